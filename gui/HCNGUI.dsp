@@ -242,6 +242,14 @@ SOURCE=.\APP\HELLOW.CPP
 
 SOURCE=.\APP\HELLOW.H
 # End Source File
+# Begin Source File
+
+SOURCE=.\APP\PAINTBCH.CPP
+# End Source File
+# Begin Source File
+
+SOURCE=.\APP\PAINTBCH.H
+# End Source File
 # End Group
 # Begin Group "syscall"
 
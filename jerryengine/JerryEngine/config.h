@@ -43,6 +43,17 @@ return ecma_make_simple_value(ECMA_SIMPLE_VALUE_UNDEFINED); \
  */
 #define JERRY_JS_PARSER
 
+/**
+ * Enable saving and executing snapshots,used by the snapshot cache
+ * of script files(snapshot-cache.c).
+ */
+#ifndef JERRY_ENABLE_SNAPSHOT_SAVE
+#define JERRY_ENABLE_SNAPSHOT_SAVE
+#endif
+#ifndef JERRY_ENABLE_SNAPSHOT_EXEC
+#define JERRY_ENABLE_SNAPSHOT_EXEC
+#endif
+
 /**
  * Limit of data (system heap, engine's data except engine's own heap)
  */
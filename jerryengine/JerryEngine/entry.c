@@ -20,6 +20,7 @@
 
 #include "jerry-api.h"
 #include "jerry-port.h"
+#include "snapshot-cache.h"
 
 /**
  * A local helper routine to show out a jerry value
@@ -194,14 +195,96 @@ __TERMINAL:
  */
 #define MAX_USER_JS_LEN (1024 * 64)
 
+/**
+ * Convert CPU cycles to kilo cycles for showing.
+ */
+#define KCYCLES(c) ((unsigned long)((c) / 1000))
+
+/**
+ * Run a script file for the given times,each run starts from a
+ * clean engine,as the scripts run on each event.The time spent
+ * to parse or to load snapshot is shown for each run.
+ */
+static int run_script_file(const char* path, unsigned int flags, int times)
+{
+	js_cache_timing_t timing;
+	js_cache_stat_t stat;
+	jerry_value_t ret_val;
+	int i;
+
+	for (i = 0; i < times; i++)
+	{
+		jerry_init(JERRY_INIT_EMPTY);
+		ret_val = js_cache_run_file(path, flags, &timing);
+		if (jerry_value_has_error_flag(ret_val))
+		{
+			jerry_port_console("Unhandled JS exception occured: ");
+		}
+		print_value(ret_val);
+		jerry_release_value(ret_val);
+		jerry_cleanup();
+		js_cache_release();
+
+		_hx_printf("Run %d: %s,read %lu Kcycles,parse %lu Kcycles,"
+			"load snapshot %lu Kcycles,exec %lu Kcycles.\r\n",
+			i + 1,
+			(flags & JS_CACHE_DISABLE) ? "no cache" : (timing.cache_hit ? "cache hit" : "cache miss"),
+			KCYCLES(timing.read_cycles),
+			KCYCLES(timing.parse_cycles),
+			KCYCLES(timing.load_cycles),
+			KCYCLES(timing.exec_cycles));
+	}
+
+	js_cache_get_stat(&stat);
+	_hx_printf("Snapshot cache: hit = %lu,miss = %lu,save = %lu,save error = %lu,stale = %lu.\r\n",
+		stat.hits, stat.misses, stat.saves, stat.save_errors, stat.stale);
+	return 0;
+}
+
 /**
  * Main entry of Jerry Engine under HelloX.
+ * Runs a script file if it's specified in command line:
+ *   <jerry app> script.js [-nocache] [-direct] [-r times]
+ * otherwise reads scripts from console.
  */
 int _hx_jerry_entry(int argc, char *argv[])
 {
 	bool is_done = false;
 	char* cmd = NULL;
 	size_t len = 0;
+	unsigned int flags = 0;
+	int times = 1;
+	int i;
+
+	/* Run script file,argv[0] is the app module's name. */
+	if ((argc > 1) && (NULL != argv))
+	{
+		for (i = 2; i < argc; i++)
+		{
+			if (0 == strcmp(argv[i], "-nocache"))
+			{
+				flags |= JS_CACHE_DISABLE;
+			}
+			else if (0 == strcmp(argv[i], "-direct"))
+			{
+				flags |= JS_CACHE_DIRECT;
+			}
+			else if ((0 == strcmp(argv[i], "-r")) && (i + 1 < argc))
+			{
+				times = atoi(argv[++i]);
+				if (times <= 0)
+				{
+					times = 1;
+				}
+			}
+			else
+			{
+				_hx_printf("Usage: %s script.js [-nocache] [-direct] [-r times]\r\n", argv[0]);
+				return -1;
+			}
+		}
+		return run_script_file(argv[1], flags, times);
+	}
 
 	/* Initialize engine */
 	jerry_init(JERRY_INIT_EMPTY);
@@ -0,0 +1,424 @@
+//***********************************************************************/
+//    Author                    :
+//    Original Date             : Oct,16 2026
+//    Module Name               : snapshot-cache.c
+//    Module Funciton           :
+//                                Persistent bytecode snapshot cache of script
+//                                files.The snapshot of a script is saved in
+//                                JS_CACHE_DIR after it's parsed the first time,
+//                                and is loaded by jerry_exec_snapshot in later
+//                                runs,the parser is skipped.
+//    Last modified Author      :
+//    Last modified Date        :
+//    Last modified Content     :
+//                                1.
+//                                2.
+//    Lines number              :
+//***********************************************************************/
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <kapi.h>
+
+#include "jerry-api.h"
+#include "jerry-port.h"
+#include "snapshot-cache.h"
+
+/**
+ * Cache file format,a header followed by the snapshot.
+ * The file system does not report file's modify time,so a
+ * snapshot is keyed by source's path,size and a hash of the
+ * source's content.
+ */
+#define JS_CACHE_MAGIC      0x504E534A    /* "JSNP" */
+#define JS_CACHE_VERSION    1
+#define JS_CACHE_PATH_LEN   128
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t source_size;
+	uint32_t source_hash;
+	uint32_t snapshot_size;
+	char     path[JS_CACHE_PATH_LEN];
+} js_cache_header_t;
+
+/**
+ * Limits of script source and snapshot.
+ */
+#define JS_MAX_SOURCE_LEN   (512 * 1024)
+#define JS_SNAPSHOT_MIN_BUF (16 * 1024)
+#define JS_SNAPSHOT_MAX_BUF (512 * 1024)
+
+/**
+ * Max snapshots can be run in place at the same time,they
+ * are kept until the engine is cleaned up.
+ */
+#define JS_CACHE_MAX_DIRECT 16
+
+static js_cache_stat_t cache_stat;
+static void* direct_snapshots[JS_CACHE_MAX_DIRECT];
+static int direct_num = 0;
+
+/**
+ * Read CPU's time stamp counter.
+ */
+uint64_t js_cache_cycles(void)
+{
+	uint32_t lo, hi;
+#ifdef __GNUC__
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+#else
+	__asm{
+		rdtsc
+		mov lo, eax
+		mov hi, edx
+	}
+#endif
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/**
+ * FNV-1a hash,used to key snapshots.
+ */
+static uint32_t js_cache_hash(const uint8_t *data, size_t len, uint32_t hash)
+{
+	while (len--)
+	{
+		hash ^= *data++;
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+#define JS_HASH_SEED 2166136261u
+
+/**
+ * Read a whole file into a newly allocated buffer.
+ */
+static uint8_t* js_cache_read_file(const char *path, uint32_t *size)
+{
+	HANDLE hFile = NULL;
+	uint8_t* buffer = NULL;
+	DWORD dwFileSize = 0;
+	DWORD dwRead = 0;
+
+	hFile = CreateFile((LPSTR)path, FILE_ACCESS_READ, 0, NULL);
+	if (NULL == hFile)
+	{
+		goto __TERMINAL;
+	}
+	dwFileSize = GetFileSize(hFile, NULL);
+	if ((0 == dwFileSize) || (dwFileSize > JS_MAX_SOURCE_LEN))
+	{
+		goto __TERMINAL;
+	}
+	buffer = (uint8_t*)_hx_malloc(dwFileSize);
+	if (NULL == buffer)
+	{
+		goto __TERMINAL;
+	}
+	if (!ReadFile(hFile, dwFileSize, buffer, &dwRead) || (dwRead != dwFileSize))
+	{
+		_hx_free(buffer);
+		buffer = NULL;
+		goto __TERMINAL;
+	}
+	*size = dwFileSize;
+
+__TERMINAL:
+	if (hFile)
+	{
+		CloseFile(hFile);
+	}
+	return buffer;
+}
+
+/**
+ * Build the cache file's name and the key path of a script,the
+ * file name is the hash of the capitalized path,in 8.3 format.
+ */
+static void js_cache_names(const char *path, char *key_path, char *cache_name)
+{
+	int i;
+
+	for (i = 0; (i < JS_CACHE_PATH_LEN - 1) && path[i]; i++)
+	{
+		key_path[i] = (char)toupper(path[i]);
+	}
+	key_path[i] = 0;
+	_hx_sprintf(cache_name, "%s\\%08X.SNP", JS_CACHE_DIR,
+		js_cache_hash((const uint8_t*)key_path, i, JS_HASH_SEED));
+}
+
+/**
+ * Load the snapshot of a script from cache,NULL is returned if there
+ * is no snapshot,or the source has been changed since it's saved.
+ */
+static void* js_cache_load(const char *cache_name, const js_cache_header_t *key, uint32_t *snapshot_size)
+{
+	HANDLE hFile = NULL;
+	js_cache_header_t header;
+	void* snapshot = NULL;
+	DWORD dwRead = 0;
+
+	hFile = CreateFile((LPSTR)cache_name, FILE_ACCESS_READ, 0, NULL);
+	if (NULL == hFile)
+	{
+		goto __TERMINAL;
+	}
+	if (!ReadFile(hFile, sizeof(header), &header, &dwRead) || (dwRead != sizeof(header)))
+	{
+		goto __TERMINAL;
+	}
+	if ((header.magic != JS_CACHE_MAGIC) || (header.version != JS_CACHE_VERSION) ||
+		strcmp(header.path, key->path))
+	{
+		goto __TERMINAL;
+	}
+	if ((header.source_size != key->source_size) || (header.source_hash != key->source_hash))
+	{
+		cache_stat.stale++;
+		goto __TERMINAL;
+	}
+	if ((0 == header.snapshot_size) || (header.snapshot_size > JS_SNAPSHOT_MAX_BUF))
+	{
+		goto __TERMINAL;
+	}
+	snapshot = _hx_malloc(header.snapshot_size);
+	if (NULL == snapshot)
+	{
+		goto __TERMINAL;
+	}
+	if (!ReadFile(hFile, header.snapshot_size, snapshot, &dwRead) || (dwRead != header.snapshot_size))
+	{
+		_hx_free(snapshot);
+		snapshot = NULL;
+		goto __TERMINAL;
+	}
+	*snapshot_size = header.snapshot_size;
+
+__TERMINAL:
+	if (hFile)
+	{
+		CloseFile(hFile);
+	}
+	return snapshot;
+}
+
+/**
+ * Save the snapshot of a script.The header is written with a zero
+ * magic first and completed after the snapshot is written,so a
+ * partially written file is never taken as valid.
+ */
+static bool js_cache_save(const char *cache_name, js_cache_header_t *header, const void *snapshot)
+{
+	HANDLE hFile = NULL;
+	DWORD dwWritten = 0;
+	DWORD dwLow = 0, dwHigh = 0;
+	bool ret = false;
+
+	CreateDirectory(JS_CACHE_DIR);
+	hFile = CreateFile((LPSTR)cache_name, FILE_ACCESS_WRITE | FILE_OPEN_ALWAYS, 0, NULL);
+	if (NULL == hFile)
+	{
+		goto __TERMINAL;
+	}
+
+	header->magic = 0;
+	if (!WriteFile(hFile, sizeof(*header), header, &dwWritten) || (dwWritten != sizeof(*header)))
+	{
+		goto __TERMINAL;
+	}
+	if (!WriteFile(hFile, header->snapshot_size, (LPVOID)snapshot, &dwWritten) ||
+		(dwWritten != header->snapshot_size))
+	{
+		goto __TERMINAL;
+	}
+	SetEndOfFile(hFile);
+
+	header->magic = JS_CACHE_MAGIC;
+	if (!SetFilePointer(hFile, &dwLow, &dwHigh, FILE_FROM_BEGIN))
+	{
+		goto __TERMINAL;
+	}
+	if (!WriteFile(hFile, sizeof(header->magic), &header->magic, &dwWritten) ||
+		(dwWritten != sizeof(header->magic)))
+	{
+		goto __TERMINAL;
+	}
+	FlushFileBuffers(hFile);
+	ret = true;
+
+__TERMINAL:
+	if (hFile)
+	{
+		CloseFile(hFile);
+		if (!ret)
+		{
+			DeleteFile((LPSTR)cache_name);
+		}
+	}
+	return ret;
+}
+
+/**
+ * Parse the script and run it without snapshot.
+ */
+static jerry_value_t js_cache_parse_and_run(const uint8_t *source, uint32_t size, js_cache_timing_t *timing)
+{
+	jerry_value_t parsed;
+	jerry_value_t ret_val;
+	uint64_t start = js_cache_cycles();
+
+	parsed = jerry_parse((const jerry_char_t*)source, size, false);
+	timing->parse_cycles = js_cache_cycles() - start;
+	if (jerry_value_has_error_flag(parsed))
+	{
+		return parsed;
+	}
+
+	start = js_cache_cycles();
+	ret_val = jerry_run(parsed);
+	timing->exec_cycles = js_cache_cycles() - start;
+	jerry_release_value(parsed);
+	return ret_val;
+}
+
+/**
+ * Run a script file through the snapshot cache.
+ */
+jerry_value_t js_cache_run_file(const char *path, unsigned int flags, js_cache_timing_t *timing)
+{
+	js_cache_header_t header;
+	char cache_name[64];
+	uint8_t* source = NULL;
+	uint8_t* snapshot = NULL;
+	uint32_t source_size = 0;
+	uint32_t snapshot_size = 0;
+	size_t buffer_size = 0;
+	bool in_place = false;
+	jerry_value_t ret_val;
+	uint64_t start;
+
+	memset(timing, 0, sizeof(*timing));
+
+	start = js_cache_cycles();
+	source = js_cache_read_file(path, &source_size);
+	if (NULL == source)
+	{
+		return jerry_create_error(JERRY_ERROR_COMMON, (const jerry_char_t*)"Can not read script file.");
+	}
+	if (flags & JS_CACHE_DISABLE)
+	{
+		timing->read_cycles = js_cache_cycles() - start;
+		ret_val = js_cache_parse_and_run(source, source_size, timing);
+		goto __TERMINAL;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.version = JS_CACHE_VERSION;
+	header.source_size = source_size;
+	header.source_hash = js_cache_hash(source, source_size, JS_HASH_SEED);
+	js_cache_names(path, header.path, cache_name);
+	timing->read_cycles = js_cache_cycles() - start;
+
+	/* Hit,run the saved snapshot. */
+	start = js_cache_cycles();
+	snapshot = (uint8_t*)js_cache_load(cache_name, &header, &snapshot_size);
+	if (snapshot)
+	{
+		timing->load_cycles = js_cache_cycles() - start;
+		timing->cache_hit = true;
+		cache_stat.hits++;
+
+		/* Run the bytecode in place if asked,saves copying literals
+		 * and bytecode into engine's heap. */
+		in_place = (flags & JS_CACHE_DIRECT) && (direct_num < JS_CACHE_MAX_DIRECT);
+		start = js_cache_cycles();
+		ret_val = jerry_exec_snapshot(snapshot, snapshot_size, !in_place);
+		timing->exec_cycles = js_cache_cycles() - start;
+		if (in_place)
+		{
+			direct_snapshots[direct_num++] = snapshot;
+			snapshot = NULL;
+		}
+		goto __TERMINAL;
+	}
+
+	/* Miss,parse the source and save the snapshot. */
+	cache_stat.misses++;
+	buffer_size = source_size * 4;
+	if (buffer_size < JS_SNAPSHOT_MIN_BUF)
+	{
+		buffer_size = JS_SNAPSHOT_MIN_BUF;
+	}
+	if (buffer_size > JS_SNAPSHOT_MAX_BUF)
+	{
+		buffer_size = JS_SNAPSHOT_MAX_BUF;
+	}
+	snapshot = (uint8_t*)_hx_malloc(buffer_size);
+	if (NULL == snapshot)
+	{
+		ret_val = js_cache_parse_and_run(source, source_size, timing);
+		goto __TERMINAL;
+	}
+
+	start = js_cache_cycles();
+	snapshot_size = (uint32_t)jerry_parse_and_save_snapshot((const jerry_char_t*)source,
+		source_size, true, false, snapshot, buffer_size);
+	timing->parse_cycles = js_cache_cycles() - start;
+	if (0 == snapshot_size)
+	{
+		/* Syntax error or snapshot too large,the plain parser
+		 * reports the error if any. */
+		cache_stat.save_errors++;
+		ret_val = js_cache_parse_and_run(source, source_size, timing);
+		goto __TERMINAL;
+	}
+
+	header.snapshot_size = snapshot_size;
+	start = js_cache_cycles();
+	if (js_cache_save(cache_name, &header, snapshot))
+	{
+		cache_stat.saves++;
+	}
+	else
+	{
+		cache_stat.save_errors++;
+	}
+	timing->parse_cycles += js_cache_cycles() - start;
+
+	start = js_cache_cycles();
+	ret_val = jerry_exec_snapshot(snapshot, snapshot_size, true);
+	timing->exec_cycles = js_cache_cycles() - start;
+
+__TERMINAL:
+	if (snapshot)
+	{
+		_hx_free(snapshot);
+	}
+	_hx_free(source);
+	return ret_val;
+}
+
+/**
+ * Release snapshots run in place.
+ */
+void js_cache_release(void)
+{
+	while (direct_num > 0)
+	{
+		_hx_free(direct_snapshots[--direct_num]);
+	}
+}
+
+/**
+ * Get the statistics of snapshot cache.
+ */
+void js_cache_get_stat(js_cache_stat_t *stat)
+{
+	memcpy(stat, &cache_stat, sizeof(*stat));
+}
@@ -0,0 +1,77 @@
+//***********************************************************************/
+//    Author                    :
+//    Original Date             : Oct,16 2026
+//    Module Name               : snapshot-cache.h
+//    Module Funciton           :
+//                                Persistent bytecode snapshot cache of script
+//                                files,so a script is only parsed once and
+//                                later runs load the saved snapshot.
+//    Last modified Author      :
+//    Last modified Date        :
+//    Last modified Content     :
+//                                1.
+//                                2.
+//    Lines number              :
+//***********************************************************************/
+
+#ifndef __SNAPSHOT_CACHE_H__
+#define __SNAPSHOT_CACHE_H__
+
+#include "jerry-api.h"
+
+/**
+ * Directory on the FAT32 volume to hold snapshot files.
+ */
+#define JS_CACHE_DIR "C:\\JSCACHE"
+
+/**
+ * Flags to control how a script file is run.
+ */
+#define JS_CACHE_DISABLE 0x01  /* Always parse the source,bypass the cache. */
+#define JS_CACHE_DIRECT  0x02  /* Run bytecode in place from the loaded snapshot. */
+
+/**
+ * Timing of one script run,in CPU cycles.
+ */
+typedef struct {
+	bool     cache_hit;      /* Snapshot loaded from the cache. */
+	uint64_t read_cycles;    /* Reading and hashing the source. */
+	uint64_t parse_cycles;   /* Parsing and saving snapshot,0 on hit. */
+	uint64_t load_cycles;    /* Loading snapshot file,0 on miss. */
+	uint64_t exec_cycles;    /* Running the bytecode. */
+} js_cache_timing_t;
+
+/**
+ * Statistics of the snapshot cache.
+ */
+typedef struct {
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long saves;
+	unsigned long save_errors;    /* Snapshot too large,or can not write file. */
+	unsigned long stale;          /* Source changed since snapshot saved. */
+} js_cache_stat_t;
+
+/**
+ * Run a script file,through the snapshot cache unless JS_CACHE_DISABLE
+ * is given.The returned value must be released by jerry_release_value.
+ */
+jerry_value_t js_cache_run_file(const char *path, unsigned int flags, js_cache_timing_t *timing);
+
+/**
+ * Release the snapshots used in place(JS_CACHE_DIRECT),must be called
+ * after jerry_cleanup.
+ */
+void js_cache_release(void);
+
+/**
+ * Get the statistics of snapshot cache.
+ */
+void js_cache_get_stat(js_cache_stat_t *stat);
+
+/**
+ * Read CPU's time stamp counter.
+ */
+uint64_t js_cache_cycles(void);
+
+#endif //__SNAPSHOT_CACHE_H__
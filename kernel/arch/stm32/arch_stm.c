@@ -115,6 +115,22 @@ VOID __GetTsc(__U64* lpResult)
 }
 
 
+//Atomic compare and exchange,simulated by critical section.
+DWORD __AtomicCompareExchange(volatile DWORD* lpDest,DWORD dwOld,DWORD dwNew)
+{
+	DWORD dwPrev;
+	DWORD dwFlags;
+
+	__ENTER_CRITICAL_SECTION(NULL,dwFlags);
+	dwPrev = *lpDest;
+	if(dwPrev == dwOld)
+	{
+		*lpDest = dwNew;
+	}
+	__LEAVE_CRITICAL_SECTION(NULL,dwFlags);
+	return dwPrev;
+}
+
 #define CLOCK_PER_MICROSECOND 1024  //Assume the CPU's clock is 1G Hz.
 
 VOID __MicroDelay(DWORD dwmSeconds)
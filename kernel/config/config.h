@@ -153,6 +153,10 @@
 //Include IDE driver in OS.
 #define __CFG_DRV_IDE
 
+//Include AHCI and bus master IDE DMA drivers,IDE driver uses them instead
+//of BIOS service to access hard disk if any disk is found.
+#define __CFG_DRV_AHCI
+
 //Include COM driver in OS.
 #define __CFG_DRV_COM
 
@@ -195,6 +199,19 @@
 //Include NTFS file system function in OS.
 //#define __CFG_FS_NTFS
 
+//Largest read ahead window(bytes) of NTFS file,the window grows to it
+//when a file is read sequentially.
+#define NTFS_READAHEAD_MAX     (128 * 1024)
+
+//Include block buffer cache in IO manager,file systems and raw partition
+//access go through it.
+#define __CFG_FS_BCACHE
+
+//Blocks(sectors) in buffer cache,and the interval(ms) dirty blocks are
+//flushed to device.
+#define BCACHE_BLOCK_NUM       1024
+#define BCACHE_FLUSH_INTERVAL  1000
+
 //Include RAM file system in OS.
 //#define __CFG_FS_RAM
 
@@ -0,0 +1,638 @@
+//***********************************************************************/
+//    Author                    :
+//    Original Date             : Oct,16 2026
+//    Module Name               : ahci.c
+//    Module Funciton           :
+//                                AHCI(SATA) host bus adapter driver.Each ATA
+//                                disk attached is registered as a native disk
+//                                to IDE driver,commands are issued through
+//                                command list and PRD,completed by interrupt,
+//                                several of them are outstanding at the same
+//                                time if the disk supports NCQ.
+//    Last modified Author      :
+//    Last modified Date        :
+//    Last modified Content     :
+//                                1.
+//                                2.
+//    Lines number              :
+//***********************************************************************/
+
+#ifndef __STDAFX_H__
+#include <StdAfx.h>
+#endif
+
+#include <pci_drv.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "idebase.h"
+#include "ahci.h"
+
+#ifdef __CFG_DRV_AHCI
+
+//Command tables are 128 bytes aligned,one for each slot.
+#define AHCI_CMD_TABLE_SIZE    256
+
+struct tag__AHCI_HBA;
+
+//One port with an ATA disk attached.
+typedef struct tag__AHCI_PORT{
+	struct tag__AHCI_HBA*  pHba;
+	BYTE*                  pRegs;        //Port register base.
+	int                    nPort;
+	__AHCI_CMD_HEADER*     pCmdList;
+	BYTE*                  pRxFis;
+	BYTE*                  pCmdTables;
+	DWORD                  dwSlotMask;   //Command slots can be used.
+	DWORD                  dwIssued;     //Slots with command outstanding.
+	BOOL                   bNcq;
+	BOOL                   bLba48;
+	int                    nDepth;       //Commands can be outstanding.
+	__DISK_REQUEST*        pReq[AHCI_MAX_SLOTS];
+	CHAR                   szModel[41];
+	__NATIVE_DISK          disk;
+}__AHCI_PORT;
+
+typedef struct tag__AHCI_HBA{
+	BYTE*                  pAbar;        //Memory mapped registers.
+	int                    nSlots;
+	BOOL                   bNcq;
+	UCHAR                  ucVector;
+	HANDLE                 hInterrupt;
+	__AHCI_PORT*           pPorts[AHCI_MAX_PORTS];
+}__AHCI_HBA;
+
+#define HBA_READ(hba,reg)        __readl((hba)->pAbar + (reg))
+#define HBA_WRITE(hba,reg,v)     __writel(v,(hba)->pAbar + (reg))
+#define PORT_READ(p,reg)         __readl((p)->pRegs + (reg))
+#define PORT_WRITE(p,reg,v)      __writel(v,(p)->pRegs + (reg))
+
+#define AHCI_CMD_TABLE(p,slot)   ((__AHCI_CMD_TABLE*)((p)->pCmdTables + (slot) * AHCI_CMD_TABLE_SIZE))
+
+//Wait until (register & mask) == value,or time out.
+static BOOL AhciWait(BYTE* pReg,DWORD dwMask,DWORD dwValue,int nMillionSecond)
+{
+	int nLoop = nMillionSecond * 10;
+
+	while((__readl(pReg) & dwMask) != dwValue)
+	{
+		if(nLoop-- <= 0)
+		{
+			return FALSE;
+		}
+		__MicroDelay(100);
+	}
+	return TRUE;
+}
+
+//Stop command processing of a port,PxCI and PxSACT are cleared by HBA.
+static BOOL AhciStopPort(__AHCI_PORT* p)
+{
+	PORT_WRITE(p,AHCI_PxCMD,PORT_READ(p,AHCI_PxCMD) & ~AHCI_PxCMD_ST);
+	return AhciWait(p->pRegs + AHCI_PxCMD,AHCI_PxCMD_CR,0,500);
+}
+
+static BOOL AhciStartPort(__AHCI_PORT* p)
+{
+	if(!AhciWait(p->pRegs + AHCI_PxCMD,AHCI_PxCMD_CR,0,500))
+	{
+		return FALSE;
+	}
+	PORT_WRITE(p,AHCI_PxCMD,PORT_READ(p,AHCI_PxCMD) | AHCI_PxCMD_FRE |
+		AHCI_PxCMD_SUD | AHCI_PxCMD_POD);
+	PORT_WRITE(p,AHCI_PxCMD,PORT_READ(p,AHCI_PxCMD) | AHCI_PxCMD_ST);
+	return TRUE;
+}
+
+//Build the command FIS,header and PRD of a slot.
+static VOID AhciPrepare(__AHCI_PORT* p,int nSlot,UCHAR ucCmd,DWORD dwLba,
+						DWORD dwCount,BYTE* pBuffer,DWORD dwBytes,BOOL bWrite)
+{
+	__AHCI_CMD_HEADER* pHdr = &p->pCmdList[nSlot];
+	__AHCI_CMD_TABLE*  pTbl = AHCI_CMD_TABLE(p,nSlot);
+	BYTE*              fis  = pTbl->cfis;
+
+	memset(fis,0,20);
+	fis[0]  = FIS_TYPE_REG_H2D;
+	fis[1]  = FIS_H2D_CMD;
+	fis[2]  = ucCmd;
+	fis[4]  = (BYTE)dwLba;
+	fis[5]  = (BYTE)(dwLba >> 8);
+	fis[6]  = (BYTE)(dwLba >> 16);
+	fis[7]  = 0x40;    //LBA mode.
+	if((IDE_CMD_READ_FPDMA == ucCmd) || (IDE_CMD_WRITE_FPDMA == ucCmd))
+	{
+		//Sector count goes in features,tag in count.
+		fis[3]  = (BYTE)dwCount;
+		fis[11] = (BYTE)(dwCount >> 8);
+		fis[12] = (BYTE)(nSlot << 3);
+		fis[8]  = (BYTE)(dwLba >> 24);
+	}
+	else
+	{
+		fis[12] = (BYTE)dwCount;
+		fis[13] = (BYTE)(dwCount >> 8);
+		if(p->bLba48)
+		{
+			fis[8] = (BYTE)(dwLba >> 24);
+		}
+		else
+		{
+			fis[7] |= (BYTE)((dwLba >> 24) & 0x0F);
+		}
+	}
+
+	//Buffer is physically contiguous,ensured by NativeDiskIo or allocated
+	//by _hx_dma_malloc in initialization.
+	pTbl->prdt[0].dwDba  = _hx_dma_addr(pBuffer);
+	pTbl->prdt[0].dwDbau = 0;
+	pTbl->prdt[0].dwRsv  = 0;
+	pTbl->prdt[0].dwDbc  = (dwBytes - 1) | AHCI_PRD_INT;
+
+	pHdr->wFlags  = (WORD)(5 | (bWrite ? AHCI_CMD_FLAG_WRITE : 0));  //FIS is 5 DWORDs.
+	pHdr->wPrdtl  = 1;
+	pHdr->dwPrdbc = 0;
+	pHdr->dwCtba  = _hx_dma_addr(pTbl);
+	pHdr->dwCtbau = 0;
+}
+
+//Issue IDENTIFY DEVICE in slot 0 and poll for completion,used in
+//initialization only.
+static BOOL AhciIdentify(__AHCI_PORT* p,WORD* pBuffer)
+{
+	AhciPrepare(p,0,IDE_CMD_IDENTIFY,0,0,(BYTE*)pBuffer,512,FALSE);
+	PORT_WRITE(p,AHCI_PxIS,0xFFFFFFFF);
+	PORT_WRITE(p,AHCI_PxCI,1);
+	if(!AhciWait(p->pRegs + AHCI_PxCI,1,0,1000))
+	{
+		return FALSE;
+	}
+	if((PORT_READ(p,AHCI_PxIS) & AHCI_PxIS_ERROR) ||
+	   (PORT_READ(p,AHCI_PxTFD) & AHCI_PxTFD_ERR))
+	{
+		return FALSE;
+	}
+	PORT_WRITE(p,AHCI_PxIS,0xFFFFFFFF);
+	return TRUE;
+}
+
+//Error or cancel,stop the port to abort all commands,reset the link if the
+//device hangs,then restart.All outstanding commands are failed,NCQ error
+//does not tell which one is wrong without reading the log page.
+static VOID AhciRecover(__AHCI_PORT* p)
+{
+	__DISK_REQUEST* pReq;
+	DWORD dwIssued = p->dwIssued;
+	DWORD dwSctl;
+	int i;
+
+	AhciStopPort(p);
+	PORT_WRITE(p,AHCI_PxSERR,0xFFFFFFFF);
+	PORT_WRITE(p,AHCI_PxIS,0xFFFFFFFF);
+	if(PORT_READ(p,AHCI_PxTFD) & (AHCI_PxTFD_BSY | AHCI_PxTFD_DRQ))
+	{
+		//COMRESET.
+		dwSctl = PORT_READ(p,AHCI_PxSCTL) & ~0x0F;
+		PORT_WRITE(p,AHCI_PxSCTL,dwSctl | 1);
+		__MicroDelay(1000);
+		PORT_WRITE(p,AHCI_PxSCTL,dwSctl);
+		AhciWait(p->pRegs + AHCI_PxSSTS,0x0F,AHCI_DET_PRESENT,1000);
+		PORT_WRITE(p,AHCI_PxSERR,0xFFFFFFFF);
+	}
+	AhciStartPort(p);
+
+	p->dwIssued = 0;
+	for(i = 0;i < AHCI_MAX_SLOTS;i ++)
+	{
+		if(dwIssued & (1 << i))
+		{
+			pReq = p->pReq[i];
+			p->pReq[i] = NULL;
+			NativeDiskComplete(pReq,TRUE);
+		}
+	}
+}
+
+//Complete finished commands of a port,from interrupt or polling.
+static VOID AhciService(__AHCI_PORT* p)
+{
+	__DISK_REQUEST* pReq;
+	DWORD dwStatus,dwDone;
+	int i;
+
+	dwStatus = PORT_READ(p,AHCI_PxIS);
+	PORT_WRITE(p,AHCI_PxIS,dwStatus);
+	HBA_WRITE(p->pHba,AHCI_HBA_IS,1 << p->nPort);
+	dwDone = p->dwIssued & ~(PORT_READ(p,AHCI_PxCI) | PORT_READ(p,AHCI_PxSACT));
+	p->dwIssued &= ~dwDone;
+	for(i = 0;dwDone && (i < AHCI_MAX_SLOTS);i ++)
+	{
+		if(dwDone & (1 << i))
+		{
+			pReq = p->pReq[i];
+			p->pReq[i] = NULL;
+			dwDone &= ~(1 << i);
+			NativeDiskComplete(pReq,FALSE);
+		}
+	}
+	//Commands still outstanding are failed.
+	if(dwStatus & AHCI_PxIS_ERROR)
+	{
+		AhciRecover(p);
+	}
+}
+
+//Native disk operations,called with interrupt disabled.
+static BOOL AhciSubmit(__NATIVE_DISK* pDisk,BOOL bWrite,DWORD dwStart,
+					   DWORD dwNum,BYTE* pBuffer,__DISK_REQUEST* pReq)
+{
+	__AHCI_PORT* p = (__AHCI_PORT*)pDisk->pPrivate;
+	DWORD dwFree = p->dwSlotMask & ~p->dwIssued;
+	UCHAR ucCmd;
+	int nSlot = 0;
+
+	if(0 == dwFree)
+	{
+		return FALSE;
+	}
+	while(0 == (dwFree & (1 << nSlot)))
+	{
+		nSlot ++;
+	}
+	if(p->bNcq)
+	{
+		ucCmd = bWrite ? IDE_CMD_WRITE_FPDMA : IDE_CMD_READ_FPDMA;
+	}
+	else if(p->bLba48)
+	{
+		ucCmd = bWrite ? IDE_CMD_WRITE_DMA_EXT : IDE_CMD_READ_DMA_EXT;
+	}
+	else
+	{
+		ucCmd = bWrite ? IDE_CMD_WRITE_DMA : IDE_CMD_READ_DMA;
+	}
+	AhciPrepare(p,nSlot,ucCmd,dwStart,dwNum,pBuffer,dwNum * 512,bWrite);
+	p->pReq[nSlot] = pReq;
+	p->dwIssued |= (1 << nSlot);
+	if(p->bNcq)
+	{
+		PORT_WRITE(p,AHCI_PxSACT,1 << nSlot);
+	}
+	PORT_WRITE(p,AHCI_PxCI,1 << nSlot);
+	return TRUE;
+}
+
+static VOID AhciPoll(__NATIVE_DISK* pDisk)
+{
+	AhciService((__AHCI_PORT*)pDisk->pPrivate);
+}
+
+static VOID AhciCancel(__NATIVE_DISK* pDisk)
+{
+	AhciRecover((__AHCI_PORT*)pDisk->pPrivate);
+}
+
+static BOOL AhciInterrupt(LPVOID lpESP,LPVOID lpParam)
+{
+	__AHCI_HBA* pHba = (__AHCI_HBA*)lpParam;
+	DWORD dwStatus;
+	int i;
+
+	dwStatus = HBA_READ(pHba,AHCI_HBA_IS);
+	if(0 == dwStatus)  //Shared line,not ours.
+	{
+		return FALSE;
+	}
+	for(i = 0;i < AHCI_MAX_PORTS;i ++)
+	{
+		if(0 == (dwStatus & (1 << i)))
+		{
+			continue;
+		}
+		if(pHba->pPorts[i])
+		{
+			AhciService(pHba->pPorts[i]);
+		}
+		else
+		{
+			__writel(0xFFFFFFFF,pHba->pAbar + AHCI_PORT_BASE(i) + AHCI_PxIS);
+		}
+	}
+	HBA_WRITE(pHba,AHCI_HBA_IS,dwStatus);
+	return TRUE;
+}
+
+//Copy the byte swapped ATA string of IDENTIFY data.
+static VOID AhciCopyString(CHAR* pDest,WORD* pWords,int nWords)
+{
+	int i;
+
+	for(i = 0;i < nWords;i ++)
+	{
+		pDest[i * 2]     = (CHAR)(pWords[i] >> 8);
+		pDest[i * 2 + 1] = (CHAR)pWords[i];
+	}
+	pDest[nWords * 2] = 0;
+	for(i = nWords * 2 - 1;(i >= 0) && (' ' == pDest[i]);i --)
+	{
+		pDest[i] = 0;
+	}
+}
+
+static VOID AhciFreePort(__AHCI_PORT* p)
+{
+	if(p->pCmdList)
+	{
+		_hx_free(p->pCmdList);
+	}
+	if(p->pRxFis)
+	{
+		_hx_free(p->pRxFis);
+	}
+	if(p->pCmdTables)
+	{
+		_hx_free(p->pCmdTables);
+	}
+	_hx_free(p);
+}
+
+//Set up a port with an ATA disk attached and identify the disk.
+static __AHCI_PORT* AhciInitPort(__AHCI_HBA* pHba,int nPort,WORD* pIdentify)
+{
+	__AHCI_PORT* p = NULL;
+	DWORD dwHigh;
+	BOOL bResult = FALSE;
+
+	p = (__AHCI_PORT*)_hx_malloc(sizeof(__AHCI_PORT));
+	if(NULL == p)
+	{
+		goto __TERMINAL;
+	}
+	memset(p,0,sizeof(__AHCI_PORT));
+	p->pHba  = pHba;
+	p->nPort = nPort;
+	p->pRegs = pHba->pAbar + AHCI_PORT_BASE(nPort);
+
+	//Structures accessed by HBA must be physically contiguous.
+	p->pCmdList   = (__AHCI_CMD_HEADER*)_hx_dma_malloc(AHCI_CMD_LIST_SIZE,1024);
+	p->pRxFis     = (BYTE*)_hx_dma_malloc(AHCI_RX_FIS_SIZE,256);
+	p->pCmdTables = (BYTE*)_hx_dma_malloc(AHCI_CMD_TABLE_SIZE * pHba->nSlots,128);
+	if((NULL == p->pCmdList) || (NULL == p->pRxFis) || (NULL == p->pCmdTables))
+	{
+		goto __TERMINAL;
+	}
+	memset(p->pCmdList,0,AHCI_CMD_LIST_SIZE);
+	memset(p->pRxFis,0,AHCI_RX_FIS_SIZE);
+	memset(p->pCmdTables,0,AHCI_CMD_TABLE_SIZE * pHba->nSlots);
+
+	//Take the port over from BIOS and rebase it to our structures.
+	if(!AhciStopPort(p))
+	{
+		goto __TERMINAL;
+	}
+	PORT_WRITE(p,AHCI_PxCMD,PORT_READ(p,AHCI_PxCMD) & ~AHCI_PxCMD_FRE);
+	if(!AhciWait(p->pRegs + AHCI_PxCMD,AHCI_PxCMD_FR,0,500))
+	{
+		goto __TERMINAL;
+	}
+	PORT_WRITE(p,AHCI_PxCLB,_hx_dma_addr(p->pCmdList));
+	PORT_WRITE(p,AHCI_PxCLBU,0);
+	PORT_WRITE(p,AHCI_PxFB,_hx_dma_addr(p->pRxFis));
+	PORT_WRITE(p,AHCI_PxFBU,0);
+	PORT_WRITE(p,AHCI_PxIE,0);
+	PORT_WRITE(p,AHCI_PxSERR,0xFFFFFFFF);
+	PORT_WRITE(p,AHCI_PxIS,0xFFFFFFFF);
+	if(!AhciStartPort(p))
+	{
+		goto __TERMINAL;
+	}
+
+	if(!AhciIdentify(p,pIdentify))
+	{
+		AhciStopPort(p);
+		goto __TERMINAL;
+	}
+	p->bLba48 = (pIdentify[83] & (1 << 10)) ? TRUE : FALSE;
+	if(p->bLba48)
+	{
+		//Only 32 bits sector number is used in system.
+		dwHigh = pIdentify[102] | pIdentify[103];
+		p->disk.dwSectorNum = dwHigh ? 0xFFFFFFFF :
+			(pIdentify[100] | ((DWORD)pIdentify[101] << 16));
+	}
+	else
+	{
+		p->disk.dwSectorNum = pIdentify[60] | ((DWORD)pIdentify[61] << 16);
+	}
+	p->nDepth = 1;
+	if(pHba->bNcq && (pIdentify[76] & (1 << 8)))
+	{
+		p->bNcq   = TRUE;
+		p->nDepth = (pIdentify[75] & 0x1F) + 1;
+		if(p->nDepth > pHba->nSlots)
+		{
+			p->nDepth = pHba->nSlots;
+		}
+	}
+	p->dwSlotMask = (p->nDepth >= 32) ? 0xFFFFFFFF : ((1 << p->nDepth) - 1);
+	AhciCopyString(p->szModel,&pIdentify[27],20);
+
+	p->disk.pPrivate     = p;
+	p->disk.pszName      = "AHCI";
+	p->disk.dwMaxSectors = AHCI_MAX_SECTORS;
+	p->disk.bInterrupt   = FALSE;
+	p->disk.Submit       = AhciSubmit;
+	p->disk.Poll         = AhciPoll;
+	p->disk.Cancel       = AhciCancel;
+	PORT_WRITE(p,AHCI_PxIE,AHCI_PxIE_DEFAULT);
+	bResult = TRUE;
+
+__TERMINAL:
+	if(!bResult && p)
+	{
+		AhciFreePort(p);
+		p = NULL;
+	}
+	return p;
+}
+
+//Reserve the register region in virtual space,if VMM is enabled.
+static BOOL AhciMapRegisters(__PHYSICAL_DEVICE* pDev,BYTE* pAbar)
+{
+#ifdef __CFG_SYS_VMM
+	DWORD dwMemSize;
+	LPVOID pMemRegion;
+	int i;
+
+	for(i = 0;i < MAX_RESOURCE_NUM;i ++)
+	{
+		if(RESOURCE_TYPE_EMPTY == pDev->Resource[i].dwResType)
+		{
+			break;
+		}
+		if(RESOURCE_TYPE_MEMORY != pDev->Resource[i].dwResType)
+		{
+			continue;
+		}
+		if((DWORD)pDev->Resource[i].Dev_Res.MemoryRegion.lpStartAddr != (DWORD)pAbar)
+		{
+			continue;
+		}
+		dwMemSize = (DWORD)pDev->Resource[i].Dev_Res.MemoryRegion.lpEndAddr -
+			(DWORD)pDev->Resource[i].Dev_Res.MemoryRegion.lpStartAddr + 1;
+		pMemRegion = VirtualAlloc((LPVOID)pAbar,
+			dwMemSize,
+			VIRTUAL_AREA_ALLOCATE_IO,
+			VIRTUAL_AREA_ACCESS_RW,
+			(UCHAR*)"AHCI_REG");
+		return (pMemRegion == (LPVOID)pAbar);
+	}
+	return FALSE;
+#else
+	return TRUE;
+#endif
+}
+
+//Initialize one HBA,returns how many disks are found on it.
+static int AhciInitHba(__PHYSICAL_DEVICE* pDev)
+{
+	__AHCI_HBA* pHba = NULL;
+	__AHCI_PORT* p = NULL;
+	WORD* pIdentify = NULL;
+	DWORD dwBar,dwCap,dwPi,dwCmd;
+	BYTE* pPort;
+	int i,nDisks = 0;
+
+	dwBar = pDev->ReadDeviceConfig(pDev,PCI_CONFIG_OFFSET_BASE6,sizeof(DWORD));
+	if(dwBar & 1)  //ABAR must be memory space.
+	{
+		goto __TERMINAL;
+	}
+	pHba = (__AHCI_HBA*)_hx_malloc(sizeof(__AHCI_HBA));
+	pIdentify = (WORD*)_hx_dma_malloc(512,4);
+	if((NULL == pHba) || (NULL == pIdentify))
+	{
+		goto __TERMINAL;
+	}
+	memset(pHba,0,sizeof(__AHCI_HBA));
+	pHba->pAbar = (BYTE*)(dwBar & ~0x0F);
+	if(!AhciMapRegisters(pDev,pHba->pAbar))
+	{
+		goto __TERMINAL;
+	}
+	for(i = 0;i < MAX_RESOURCE_NUM;i ++)
+	{
+		if(RESOURCE_TYPE_INTERRUPT == pDev->Resource[i].dwResType)
+		{
+			pHba->ucVector = pDev->Resource[i].Dev_Res.ucVector;
+			break;
+		}
+	}
+
+	//Enable memory space and bus master.
+	dwCmd = pDev->ReadDeviceConfig(pDev,PCI_CONFIG_OFFSET_COMMAND,sizeof(DWORD));
+	dwCmd |= PCI_COMMAND_MEMORY | PCI_COMMAND_MASTER;
+	pDev->WriteDeviceConfig(pDev,PCI_CONFIG_OFFSET_COMMAND,dwCmd,sizeof(DWORD));
+
+	HBA_WRITE(pHba,AHCI_HBA_GHC,HBA_READ(pHba,AHCI_HBA_GHC) | AHCI_GHC_AE);
+	HBA_WRITE(pHba,AHCI_HBA_GHC,HBA_READ(pHba,AHCI_HBA_GHC) & ~AHCI_GHC_IE);
+	dwCap = HBA_READ(pHba,AHCI_HBA_CAP);
+	dwPi  = HBA_READ(pHba,AHCI_HBA_PI);
+	pHba->nSlots = AHCI_CAP_NCS(dwCap);
+	pHba->bNcq   = (dwCap & AHCI_CAP_SNCQ) ? TRUE : FALSE;
+
+	for(i = 0;i < AHCI_MAX_PORTS;i ++)
+	{
+		if(0 == (dwPi & (1 << i)))
+		{
+			continue;
+		}
+		pPort = pHba->pAbar + AHCI_PORT_BASE(i);
+		if(AHCI_DET_PRESENT != AHCI_PxSSTS_DET(__readl(pPort + AHCI_PxSSTS)))
+		{
+			continue;
+		}
+		if(AHCI_SIG_ATA != __readl(pPort + AHCI_PxSIG))  //ATAPI or port multiplier.
+		{
+			continue;
+		}
+		p = AhciInitPort(pHba,i,pIdentify);
+		if(NULL == p)
+		{
+			_hx_printf("AHCI: can not initialize port %d.\r\n",i);
+			continue;
+		}
+		if(!RegisterNativeDisk(&p->disk))
+		{
+			AhciStopPort(p);
+			AhciFreePort(p);
+			continue;
+		}
+		pHba->pPorts[i] = p;
+		nDisks ++;
+		_hx_printf("AHCI: port %d,%s,%d MB,%s,queue depth %d.\r\n",
+			i,p->szModel,p->disk.dwSectorNum / 2048,
+			p->bNcq ? "NCQ" : (p->bLba48 ? "LBA48" : "LBA28"),
+			p->nDepth);
+	}
+	if(0 == nDisks)
+	{
+		goto __TERMINAL;
+	}
+
+	//Completion is polled if no interrupt can be connected.
+	if(pHba->ucVector)
+	{
+		pHba->hInterrupt = ConnectInterrupt(AhciInterrupt,
+			(LPVOID)pHba,
+			pHba->ucVector + INTERRUPT_VECTOR_BASE);
+	}
+	if(pHba->hInterrupt)
+	{
+		for(i = 0;i < AHCI_MAX_PORTS;i ++)
+		{
+			if(pHba->pPorts[i])
+			{
+				pHba->pPorts[i]->disk.bInterrupt = TRUE;
+			}
+		}
+		HBA_WRITE(pHba,AHCI_HBA_IS,0xFFFFFFFF);
+		HBA_WRITE(pHba,AHCI_HBA_GHC,HBA_READ(pHba,AHCI_HBA_GHC) | AHCI_GHC_IE);
+	}
+
+__TERMINAL:
+	if(pIdentify)
+	{
+		_hx_free(pIdentify);
+	}
+	if((0 == nDisks) && pHba)
+	{
+		_hx_free(pHba);
+	}
+	return nDisks;
+}
+
+//Find all AHCI controllers and register disks on them.
+int AhciInitialize(void)
+{
+	__PHYSICAL_DEVICE* pDev = NULL;
+	__IDENTIFIER id;
+	int nDisks = 0;
+
+	id.dwBusType = BUS_TYPE_PCI;
+	id.Bus_ID.PCI_Identifier.ucMask  = PCI_IDENTIFIER_MASK_CLASS;
+	id.Bus_ID.PCI_Identifier.dwClass = (AHCI_PCI_CLASS_ID << 8);
+	while(TRUE)
+	{
+		pDev = DeviceManager.GetDevice(&DeviceManager,BUS_TYPE_PCI,&id,pDev);
+		if(NULL == pDev)
+		{
+			break;
+		}
+		nDisks += AhciInitHba(pDev);
+	}
+	return nDisks;
+}
+
+#endif  //__CFG_DRV_AHCI
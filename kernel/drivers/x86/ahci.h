@@ -0,0 +1,132 @@
+//***********************************************************************/
+//    Author                    :
+//    Original Date             : Oct,16 2026
+//    Module Name               : ahci.h
+//    Module Funciton           :
+//                                Register layout and in memory structures of
+//                                AHCI(SATA) host bus adapter,used by the native
+//                                hard disk driver.
+//    Last modified Author      :
+//    Last modified Date        :
+//    Last modified Content     :
+//                                1.
+//                                2.
+//    Lines number              :
+//***********************************************************************/
+
+#ifndef __AHCI_H__
+#define __AHCI_H__
+
+//PCI class code of AHCI 1.0 compatible SATA controller.
+#define AHCI_PCI_CLASS_ID      0x010601
+
+//Generic host control registers,offset to ABAR.
+#define AHCI_HBA_CAP           0x00
+#define AHCI_HBA_GHC           0x04
+#define AHCI_HBA_IS            0x08
+#define AHCI_HBA_PI            0x0C
+#define AHCI_HBA_VS            0x10
+
+#define AHCI_CAP_NCS(cap)      ((((cap) >> 8) & 0x1F) + 1)  //Command slots per port.
+#define AHCI_CAP_SNCQ          (1 << 30)
+#define AHCI_CAP_S64A          (1 << 31)
+
+#define AHCI_GHC_HR            (1 << 0)
+#define AHCI_GHC_IE            (1 << 1)
+#define AHCI_GHC_AE            (1 << 31)
+
+//Port registers,offset to the port's register base.
+#define AHCI_PORT_BASE(n)      (0x100 + (n) * 0x80)
+#define AHCI_PxCLB             0x00
+#define AHCI_PxCLBU            0x04
+#define AHCI_PxFB              0x08
+#define AHCI_PxFBU             0x0C
+#define AHCI_PxIS              0x10
+#define AHCI_PxIE              0x14
+#define AHCI_PxCMD             0x18
+#define AHCI_PxTFD             0x20
+#define AHCI_PxSIG             0x24
+#define AHCI_PxSSTS            0x28
+#define AHCI_PxSCTL            0x2C
+#define AHCI_PxSERR            0x30
+#define AHCI_PxSACT            0x34
+#define AHCI_PxCI              0x38
+
+#define AHCI_PxCMD_ST          (1 << 0)
+#define AHCI_PxCMD_SUD         (1 << 1)
+#define AHCI_PxCMD_POD         (1 << 2)
+#define AHCI_PxCMD_FRE         (1 << 4)
+#define AHCI_PxCMD_FR          (1 << 14)
+#define AHCI_PxCMD_CR          (1 << 15)
+
+//Port interrupt status/enable bits.
+#define AHCI_PxIS_DHRS         (1 << 0)   //D2H register FIS.
+#define AHCI_PxIS_PSS          (1 << 1)   //PIO setup FIS.
+#define AHCI_PxIS_DSS          (1 << 2)   //DMA setup FIS.
+#define AHCI_PxIS_SDBS         (1 << 3)   //Set device bits FIS,NCQ completion.
+#define AHCI_PxIS_DPS          (1 << 5)   //Descriptor processed.
+#define AHCI_PxIS_IFS          (1 << 27)  //Interface fatal error.
+#define AHCI_PxIS_HBDS         (1 << 28)  //Host bus data error.
+#define AHCI_PxIS_HBFS         (1 << 29)  //Host bus fatal error.
+#define AHCI_PxIS_TFES         (1 << 30)  //Task file error.
+#define AHCI_PxIS_ERROR        (AHCI_PxIS_IFS | AHCI_PxIS_HBDS | AHCI_PxIS_HBFS | AHCI_PxIS_TFES)
+#define AHCI_PxIE_DEFAULT      (AHCI_PxIS_DHRS | AHCI_PxIS_PSS | AHCI_PxIS_DSS | AHCI_PxIS_SDBS | \
+                                AHCI_PxIS_DPS | AHCI_PxIS_ERROR)
+
+#define AHCI_PxTFD_ERR         (1 << 0)
+#define AHCI_PxTFD_DRQ         (1 << 3)
+#define AHCI_PxTFD_BSY         (1 << 7)
+
+#define AHCI_PxSSTS_DET(s)     ((s) & 0x0F)
+#define AHCI_DET_PRESENT       3          //Device present and PHY up.
+#define AHCI_SIG_ATA           0x00000101
+
+//Most ports and command slots an HBA may have.
+#define AHCI_MAX_PORTS         32
+#define AHCI_MAX_SLOTS         32
+
+//Sectors one command transfers,one PRD entry of 64K.
+#define AHCI_MAX_SECTORS       128
+
+//Command header,32 entries form the command list of a port.
+typedef struct tag__AHCI_CMD_HEADER{
+	WORD       wFlags;     //CFL in bit 0-4,W(write) in bit 6.
+	WORD       wPrdtl;     //Entries in PRD table.
+	DWORD      dwPrdbc;    //Bytes transferred,updated by HBA.
+	DWORD      dwCtba;     //Command table's physical address,128 bytes aligned.
+	DWORD      dwCtbau;
+	DWORD      dwRsv[4];
+}__AHCI_CMD_HEADER;
+
+#define AHCI_CMD_FLAG_WRITE    (1 << 6)
+
+//Physical region descriptor.
+typedef struct tag__AHCI_PRD{
+	DWORD      dwDba;      //Data base address,word aligned.
+	DWORD      dwDbau;
+	DWORD      dwRsv;
+	DWORD      dwDbc;      //Byte count minus 1,bit 31 asks interrupt.
+}__AHCI_PRD;
+
+#define AHCI_PRD_INT           (1 << 31)
+
+//Command table,one for each command slot.
+typedef struct tag__AHCI_CMD_TABLE{
+	BYTE       cfis[64];   //Command FIS.
+	BYTE       acmd[16];   //ATAPI command,not used.
+	BYTE       rsv[48];
+	__AHCI_PRD prdt[1];    //Only one PRD entry per command.
+}__AHCI_CMD_TABLE;
+
+//Register host to device FIS.
+#define FIS_TYPE_REG_H2D       0x27
+#define FIS_H2D_CMD            0x80       //C bit,the FIS carries a command.
+
+//Received FIS area is 256 bytes,command list 1K.
+#define AHCI_RX_FIS_SIZE       256
+#define AHCI_CMD_LIST_SIZE     (sizeof(__AHCI_CMD_HEADER) * AHCI_MAX_SLOTS)
+
+//Find all AHCI controllers and register disks on them.
+int AhciInitialize(void);
+
+#endif  //__AHCI_H__
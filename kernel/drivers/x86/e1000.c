@@ -4950,31 +4950,35 @@ e1000_sw_init(struct e1000_hw *hw)
 	return E1000_SUCCESS;
 }
 
+/*
+ * Hand all rx descriptors to the NIC,each one points to the data
+ * block that the frame will be received into.One descriptor is held
+ * back so the head never catches up the tail.
+ */
 void
 fill_rx(struct e1000_hw *hw)
 {
 	struct e1000_rx_desc *rd;
-	unsigned long flush_start, flush_end;
-
-	hw->rx_last = hw->rx_tail;
-	rd = hw->rx_base + hw->rx_tail;
-	hw->rx_tail = (hw->rx_tail + 1) % 8;
-	memset(rd, 0, 16);
-	rd->buffer_addr = cpu_to_le64((unsigned long)hw->packet);
-
-	/*
-	* Make sure there are no stale data in WB over this area, which
-	* might get written into the memory while the e1000 also writes
-	* into the same memory area.
-	*/
-	invalidate_dcache_range((unsigned long)packet,
-		(unsigned long)packet + 4096);
-	/* Dump the DMA descriptor into RAM. */
-	flush_start = ((unsigned long)rd) & ~(ARCH_DMA_MINALIGN - 1);
-	flush_end = flush_start + roundup(sizeof(*rd), ARCH_DMA_MINALIGN);
-	flush_dcache_range(flush_start, flush_end);
-
-	E1000_WRITE_REG(hw, RDT, hw->rx_tail);
+	int i;
+
+	for (i = 0; i < RX_DESC_NUM; i++) {
+		rd = hw->rx_base + i;
+		memset(rd, 0, sizeof(*rd));
+		rd->buffer_addr = cpu_to_le64(hw->rx_block[i]->DmaAddr);
+		/*
+		* Make sure there are no stale data in WB over this area, which
+		* might get written into the memory while the e1000 also writes
+		* into the same memory area.
+		*/
+		invalidate_dcache_range((unsigned long)hw->rx_block[i]->Data,
+			(unsigned long)hw->rx_block[i]->Data + ETH_MAX_FRAME_LEN);
+	}
+	/* Dump the DMA descriptors into RAM. */
+	flush_dcache_range((unsigned long)hw->rx_base,
+		(unsigned long)(hw->rx_base + RX_DESC_NUM));
+
+	hw->rx_tail = 0;
+	E1000_WRITE_REG(hw, RDT, RX_DESC_NUM - 1);
 }
 
 /**
@@ -4994,12 +4998,17 @@ e1000_configure_tx(struct e1000_hw *hw)
 	E1000_WRITE_REG(hw, TDBAL, lower_32_bits((unsigned long)hw->tx_base));
 	E1000_WRITE_REG(hw, TDBAH, upper_32_bits((unsigned long)hw->tx_base));
 
-	E1000_WRITE_REG(hw, TDLEN, 128);
+	E1000_WRITE_REG(hw, TDLEN, TX_DESC_NUM * sizeof(struct e1000_tx_desc));
 
 	/* Setup the HW Tx Head and Tail descriptor pointers */
+	memset(hw->tx_base, 0, TX_DESC_NUM * sizeof(struct e1000_tx_desc));
+	flush_dcache_range((unsigned long)hw->tx_base,
+		(unsigned long)(hw->tx_base + TX_DESC_NUM));
 	E1000_WRITE_REG(hw, TDH, 0);
 	E1000_WRITE_REG(hw, TDT, 0);
 	hw->tx_tail = 0;
+	hw->tx_clean = 0;
+	hw->tx_ctx = 0;
 
 	/* Set the default values for the Tx Inter Packet Gap timer */
 	if (hw->mac_type <= e1000_82547_rev_2 &&
@@ -5098,6 +5107,9 @@ e1000_setup_rctl(struct e1000_hw *hw)
 	rctl &= ~(E1000_RCTL_SZ_4096);
 	rctl |= E1000_RCTL_SZ_2048;
 	rctl &= ~(E1000_RCTL_BSEX | E1000_RCTL_LPE);
+	/* Strip the CRC,frames are posted to network core as they are */
+	if (hw->mac_type >= e1000_82540)
+		rctl |= E1000_RCTL_SECRC;
 	E1000_WRITE_REG(hw, RCTL, rctl);
 }
 
@@ -5135,11 +5147,16 @@ e1000_configure_rx(struct e1000_hw *hw)
 	E1000_WRITE_REG(hw, RDBAL, lower_32_bits((unsigned long)hw->rx_base));
 	E1000_WRITE_REG(hw, RDBAH, upper_32_bits((unsigned long)hw->rx_base));
 
-	E1000_WRITE_REG(hw, RDLEN, 128);
+	E1000_WRITE_REG(hw, RDLEN, RX_DESC_NUM * sizeof(struct e1000_rx_desc));
 
 	/* Setup the HW Rx Head and Tail Descriptor Pointers */
 	E1000_WRITE_REG(hw, RDH, 0);
 	E1000_WRITE_REG(hw, RDT, 0);
+
+	/* Verify IP and TCP/UDP checksum of incoming frames */
+	if (hw->mac_type >= e1000_82543)
+		E1000_WRITE_REG(hw, RXCSUM,
+			E1000_RXCSUM_IPOFL | E1000_RXCSUM_TUOFL);
 	/* Enable Receives */
 
 	if (hw->mac_type == e1000_igb) {
@@ -5155,78 +5172,336 @@ e1000_configure_rx(struct e1000_hw *hw)
 	fill_rx(hw);
 }
 
+/* Ethernet header and FCS length */
+#define E1000_ETH_HLEN	14
+#define E1000_ETH_FCS	4
+
+/*
+ * Fill the checksum flags of a received frame,from the status
+ * and errors reported by the NIC.A frame with bad checksum is
+ * not dropped,network core verifies it again and counts it.
+ */
+static __u16
+e1000_rx_csum(struct e1000_rx_desc *rd)
+{
+	__u16 flags = 0;
+
+	if (rd->status & E1000_RXD_STAT_IXSM)
+		return 0;
+	if ((rd->status & E1000_RXD_STAT_IPCS) &&
+		!(rd->errors & E1000_RXD_ERR_IPE))
+		flags |= ETH_CSUM_IP_OK;
+	if ((rd->status & E1000_RXD_STAT_TCPCS) &&
+		!(rd->errors & E1000_RXD_ERR_TCPE))
+		flags |= ETH_CSUM_L4_OK;
+	return flags;
+}
+
 /**************************************************************************
-POLL - Wait for a frame
+CLEAN_RX - Post received frames to network core
 ***************************************************************************/
-static int
-_e1000_poll(struct e1000_hw *hw)
+/*
+ * Frames are posted in the data block they are received into,
+ * a new block from the rx pool replaces it in the descriptor.If no
+ * block is available the frame is dropped and the buffer is reused.
+ * At most budget frames are processed,returns the number processed.
+ */
+int
+e1000_clean_rx(struct e1000_hw *hw, int budget)
 {
+	__ETHERNET_INTERFACE *pEthInt = hw->nic;
+	__ETHERNET_BUFFER *pEthBuff;
+	__ETH_DATA_BLOCK *pBlock;
 	struct e1000_rx_desc *rd;
-	unsigned long inval_start, inval_end;
-	uint32_t len;
+	int count = 0, last = -1;
+	int len;
 
-	/* return true if there's an ethernet packet ready to read */
-	rd = hw->rx_base + hw->rx_last;
+	while (count < budget) {
+		rd = hw->rx_base + hw->rx_tail;
+		/* Re-load the descriptor from RAM. */
+		invalidate_dcache_range((unsigned long)rd, (unsigned long)(rd + 1));
+		if (!(rd->status & E1000_RXD_STAT_DD))
+			break;
+		count++;
+
+		len = le16_to_cpu(rd->length);
+		if (hw->mac_type < e1000_82540)
+			len -= E1000_ETH_FCS;
+		if (!(rd->status & E1000_RXD_STAT_EOP) ||
+			(rd->errors & E1000_RXD_ERR_FRAME_ERR_MASK) ||
+			(len <= E1000_ETH_HLEN) || (len > ETH_MAX_FRAME_LEN)) {
+			/* Bad frame or spans descriptors,drop it. */
+			pEthInt->ifState.dwRxErrorNum++;
+		}
+		else if (NULL == (pBlock = EthernetManager.AllocDataBlock(hw->rx_pool))) {
+			/* Rx pool is exhausted,drop the frame. */
+			pEthInt->ifState.dwRxErrorNum++;
+		}
+		else {
+			/* Packet received, make sure the data are re-loaded from RAM. */
+			invalidate_dcache_range((unsigned long)hw->rx_block[hw->rx_tail]->Data,
+				(unsigned long)hw->rx_block[hw->rx_tail]->Data + len);
+			pEthBuff = EthernetManager.CreateRxEthernetBuffer(pEthInt,
+				hw->rx_block[hw->rx_tail], len);
+			hw->rx_block[hw->rx_tail] = pBlock;
+			rd->buffer_addr = cpu_to_le64(pBlock->DmaAddr);
+			if (pEthBuff) {
+				pEthBuff->csum_flags = e1000_rx_csum(rd);
+				if (!EthernetManager.PostFrame(pEthInt, pEthBuff))
+					EthernetManager.DestroyEthernetBuffer(pEthBuff);
+			}
+		}
 
-	/* Re-load the descriptor from RAM. */
-	inval_start = ((unsigned long)rd) & ~(ARCH_DMA_MINALIGN - 1);
-	inval_end = inval_start + roundup(sizeof(*rd), ARCH_DMA_MINALIGN);
-	invalidate_dcache_range(inval_start, inval_end);
+		/* Give the descriptor back to NIC. */
+		rd->length = 0;
+		rd->csum = 0;
+		rd->status = 0;
+		rd->errors = 0;
+		flush_dcache_range((unsigned long)rd, (unsigned long)(rd + 1));
+		last = hw->rx_tail;
+		hw->rx_tail = (hw->rx_tail + 1) % RX_DESC_NUM;
+	}
 
-	if (!(rd->status & E1000_RXD_STAT_DD))
+	/* The last one processed is held back,as fill_rx does. */
+	if (last >= 0)
+		E1000_WRITE_REG(hw, RDT, last);
+	return count;
+}
+
+/* Context descriptor has DEXT set but it's type is not data. */
+#define E1000_TXD_IS_CONTEXT(txp) \
+	((le32_to_cpu((txp)->lower.data) & \
+	(E1000_TXD_CMD_DEXT | E1000_TXD_DTYP_D)) == E1000_TXD_CMD_DEXT)
+
+/**************************************************************************
+CLEAN_TX - Reclaim descriptors of frames sent out
+***************************************************************************/
+/*
+ * Descriptors are reclaimed in order,from tx_clean to the first one
+ * not done yet.Context descriptor is not written back by the NIC,so
+ * it's reclaimed together with the data descriptor follows it.
+ * Returns the number of descriptors reclaimed.
+ */
+int
+e1000_clean_tx(struct e1000_hw *hw)
+{
+	struct e1000_tx_desc *txp;
+	int count = 0, n;
+
+	while (hw->tx_clean != hw->tx_tail) {
+		txp = hw->tx_base + hw->tx_clean;
+		invalidate_dcache_range((unsigned long)txp, (unsigned long)(txp + 1));
+		n = 1;
+		if (E1000_TXD_IS_CONTEXT(txp)) {
+			txp = hw->tx_base + (hw->tx_clean + 1) % TX_DESC_NUM;
+			invalidate_dcache_range((unsigned long)txp, (unsigned long)(txp + 1));
+			n = 2;
+		}
+		if (!(le32_to_cpu(txp->upper.data) & E1000_TXD_STAT_DD))
+			break;
+		hw->tx_clean = (hw->tx_clean + n) % TX_DESC_NUM;
+		count += n;
+	}
+	return count;
+}
+
+/*
+ * Prepare TCP/UDP checksum offload of an IPv4 frame.The checksum
+ * field is seeded with the pseudo header sum,the NIC adds the sum
+ * from TCP/UDP header to the end and stores the complement.
+ * Returns the checksum context,start and offset of checksum and the
+ * end if there is padding after IP packet,or 0 if the frame can not
+ * be offloaded.It's always offloadable for frames from network core,
+ * which asks offload only for unfragmented TCP/UDP.
+ */
+static int
+e1000_tx_csum_prepare(unsigned char *buf, int length)
+{
+	unsigned char *ip = buf + E1000_ETH_HLEN;
+	int ip_hlen, ip_len, css, cso, cse = 0;
+	uint32_t sum = 0;
+	int i;
+
+	if (length < E1000_ETH_HLEN + 20)
+		return 0;
+	if ((buf[12] != 0x08) || (buf[13] != 0x00) || ((ip[0] >> 4) != 4))
+		return 0;
+	/* Fragment offset and MF flag must be zero. */
+	if ((ip[6] & 0x3F) || ip[7])
+		return 0;
+	ip_hlen = (ip[0] & 0x0F) * 4;
+	ip_len = (ip[2] << 8) | ip[3];
+	if ((ip_hlen < 20) || (E1000_ETH_HLEN + ip_len > length))
 		return 0;
-	/* DEBUGOUT("recv: packet len=%d\r\n", rd->length); */
-	/* Packet received, make sure the data are re-loaded from RAM. */
-	len = le16_to_cpu(rd->length);
-	invalidate_dcache_range((unsigned long)packet,
-		(unsigned long)packet +
-		roundup(len, ARCH_DMA_MINALIGN));
-	return len;
+
+	css = E1000_ETH_HLEN + ip_hlen;
+	switch (ip[9]) {
+	case 6:  /* TCP */
+		cso = css + 16;
+		break;
+	case 17: /* UDP */
+		cso = css + 6;
+		break;
+	default:
+		return 0;
+	}
+	if (cso + 2 > E1000_ETH_HLEN + ip_len)
+		return 0;
+	if (E1000_ETH_HLEN + ip_len < length)
+		cse = E1000_ETH_HLEN + ip_len - 1;
+
+	/* Source and destination address,protocol and TCP/UDP length. */
+	for (i = 12; i < 20; i += 2)
+		sum += (ip[i] << 8) | ip[i + 1];
+	sum += ip[9];
+	sum += ip_len - ip_hlen;
+	while (sum >> 16)
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	buf[cso] = (unsigned char)(sum >> 8);
+	buf[cso + 1] = (unsigned char)sum;
+
+	return (cse << 16) | (cso << 8) | css;
 }
 
-static int _e1000_transmit(struct e1000_hw *hw, void *txpacket, int length)
+/**************************************************************************
+TRANSMIT - Transmit a frame
+***************************************************************************/
+/*
+ * The frame is copied into the tx buffer of the descriptor and the
+ * routine returns without waiting,descriptors are reclaimed later in
+ * interrupt or when the ring is full.If csum is set the TCP/UDP
+ * checksum is left to the NIC,a context descriptor is inserted only
+ * if the checksum context changes.
+ * Returns 0 if the ring is full,otherwise 1.
+ */
+int
+_e1000_transmit(struct e1000_hw *hw, void *txpacket, int length, int csum)
 {
-	void *nv_packet = (void *)txpacket;
 	struct e1000_tx_desc *txp;
-	int i = 0;
-	unsigned long flush_start, flush_end;
+	struct e1000_context_desc *ctxd;
+	unsigned char *buf;
+	int ctx = 0, used;
+	int ret = 0;
+	DWORD dwFlags;
 
-	txp = hw->tx_base + hw->tx_tail;
-	hw->tx_tail = (hw->tx_tail + 1) % 8;
+	if (length > TX_BUFFER_SIZE)
+		return 0;
+
+	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	/* Two descriptors at most,one context and one data. */
+	used = (hw->tx_tail - hw->tx_clean + TX_DESC_NUM) % TX_DESC_NUM;
+	if (TX_DESC_NUM - 1 - used < 2) {
+		used -= e1000_clean_tx(hw);
+		if (TX_DESC_NUM - 1 - used < 2)
+			goto __TERMINAL;
+	}
+
+	/* The buffer of the first descriptor the frame takes. */
+	buf = hw->tx_buffer + hw->tx_tail * TX_BUFFER_SIZE;
+	memcpy(buf, txpacket, length);
+	if (csum)
+		ctx = e1000_tx_csum_prepare(buf, length);
+
+	if (ctx && (ctx != hw->tx_ctx)) {
+		ctxd = (struct e1000_context_desc *)(hw->tx_base + hw->tx_tail);
+		ctxd->lower_setup.ip_config = 0;
+		ctxd->upper_setup.tcp_fields.tucss = (uint8_t)ctx;
+		ctxd->upper_setup.tcp_fields.tucso = (uint8_t)(ctx >> 8);
+		ctxd->upper_setup.tcp_fields.tucse = cpu_to_le16((uint16_t)(ctx >> 16));
+		ctxd->cmd_and_length = cpu_to_le32(E1000_TXD_CMD_DEXT |
+			((((ctx >> 8) & 0xFF) - (ctx & 0xFF) == 16) ? E1000_TXD_CMD_TCP : 0));
+		ctxd->tcp_seg_setup.data = 0;
+		flush_dcache_range((unsigned long)ctxd, (unsigned long)(ctxd + 1));
+		hw->tx_ctx = ctx;
+		hw->tx_tail = (hw->tx_tail + 1) % TX_DESC_NUM;
+	}
 
-	txp->buffer_addr = (uint64_t)cpu_to_le64(virt_to_bus(hw->pdev, nv_packet));
-	txp->lower.data = cpu_to_le32(hw->txd_cmd | length);
-	txp->upper.data = 0;
+	txp = hw->tx_base + hw->tx_tail;
+	txp->buffer_addr = cpu_to_le64(virt_to_bus(hw->pdev, buf));
+	if (ctx) {
+		txp->lower.data = cpu_to_le32(hw->txd_cmd | length |
+			E1000_TXD_CMD_DEXT | E1000_TXD_DTYP_D);
+		txp->upper.data = cpu_to_le32(E1000_TXD_POPTS_TXSM << 8);
+	}
+	else {
+		txp->lower.data = cpu_to_le32(hw->txd_cmd | length);
+		txp->upper.data = 0;
+	}
 
 	/* Dump the packet into RAM so e1000 can pick them. */
-	flush_dcache_range((unsigned long)nv_packet,
-		(unsigned long)nv_packet +
-		roundup(length, ARCH_DMA_MINALIGN));
+	flush_dcache_range((unsigned long)buf,
+		(unsigned long)buf + roundup(length, ARCH_DMA_MINALIGN));
 	/* Dump the descriptor into RAM as well. */
-	flush_start = ((unsigned long)txp) & ~(ARCH_DMA_MINALIGN - 1);
-	flush_end = flush_start + roundup(sizeof(*txp), ARCH_DMA_MINALIGN);
-	flush_dcache_range(flush_start, flush_end);
+	flush_dcache_range((unsigned long)txp, (unsigned long)(txp + 1));
 
+	hw->tx_tail = (hw->tx_tail + 1) % TX_DESC_NUM;
 	E1000_WRITE_REG(hw, TDT, hw->tx_tail);
+	ret = 1;
 
+__TERMINAL:
+	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	return ret;
+}
+
+/* Interrupts the driver handles. */
+#define E1000_IMS_ENABLE_MASK \
+	(E1000_IMS_RXT0 | E1000_IMS_RXDMT0 | E1000_IMS_RXO | \
+	E1000_IMS_TXDW | E1000_IMS_LSC)
+
+void
+e1000_irq_enable(struct e1000_hw *hw)
+{
+	E1000_WRITE_REG(hw, IMS, E1000_IMS_ENABLE_MASK);
 	E1000_WRITE_FLUSH(hw);
-	while (1) {
-		invalidate_dcache_range(flush_start, flush_end);
-		if (le32_to_cpu(txp->upper.data) & E1000_TXD_STAT_DD)
-			break;
-		if (i++ > TOUT_LOOP) {
-			DEBUGOUT("e1000: tx timeout\r\n");
-			return 0;
-		}
-		udelay(10);	/* give the nic a chance to write to the register */
-	}
-	return 1;
 }
 
-static void
+void
+e1000_irq_disable(struct e1000_hw *hw)
+{
+	E1000_WRITE_REG(hw, IMC, 0xffffffff);
+	E1000_WRITE_FLUSH(hw);
+}
+
+/**************************************************************************
+INTERRUPT - Interrupt handler
+***************************************************************************/
+/*
+ * Reading ICR acknowledges all pending causes.Received frames are
+ * processed in budget,if more are pending the rx timer interrupt is
+ * raised again by ICS,so other interrupts get the chance to run and
+ * the rate is still limited by ITR.
+ * Returns FALSE if the interrupt is not raised by this NIC.
+ */
+BOOL
+e1000_interrupt(struct e1000_hw *hw)
+{
+	uint32_t icr;
+
+	icr = E1000_READ_REG(hw, ICR);
+	if (!icr)
+		return FALSE;
+
+	if (icr & E1000_ICR_RXO)
+		hw->nic->ifState.dwRxErrorNum++;
+	if (icr & (E1000_ICR_RXT0 | E1000_ICR_RXDMT0 | E1000_ICR_RXO)) {
+		if (e1000_clean_rx(hw, E1000_RX_BUDGET) == E1000_RX_BUDGET)
+			E1000_WRITE_REG(hw, ICS, E1000_ICS_RXT0);
+	}
+	if (icr & E1000_ICR_TXDW)
+		e1000_clean_tx(hw);
+	if (icr & E1000_ICR_LSC) {
+		hw->get_link_status = true;
+		_hx_printf("%s: link %s\r\n", hw->name,
+			(E1000_READ_REG(hw, STATUS) & E1000_STATUS_LU) ? "up" : "down");
+	}
+	return TRUE;
+}
+
+void
 _e1000_disable(struct e1000_hw *hw)
 {
 	/* Turn off the ethernet interface */
+	e1000_irq_disable(hw);
 	E1000_WRITE_REG(hw, RCTL, 0);
 	E1000_WRITE_REG(hw, TCTL, 0);
 
@@ -5388,7 +5663,7 @@ int e1000_init_one(struct e1000_hw *hw, int cardnum, __PHYSICAL_DEVICE* pdev,
 }
 
 /* Put the name of a device in a string */
-static void e1000_name(char *str, int cardnum)
+void e1000_name(char *str, int cardnum)
 {
 	_hx_sprintf(str, "E1000_Eth_If_%d", cardnum);
 }
@@ -5400,7 +5675,7 @@ TRANSMIT - Transmit a frame
 static int e1000_transmit(__ETHERNET_INTERFACE* nic, void *txpacket, int length)
 {
 	struct e1000_hw *hw = nic->pIntExtension;
-	return _e1000_transmit(hw, txpacket, length);
+	return _e1000_transmit(hw, txpacket, length, 0);
 }
 
 /**************************************************************************
@@ -5424,21 +5699,6 @@ e1000_init(__ETHERNET_INTERFACE* nic, void *bis)
 	return _e1000_init(hw, &nic->ethMac[0]);
 }
 
-static int
-e1000_poll(__ETHERNET_INTERFACE* nic)
-{
-	struct e1000_hw *hw = nic->pIntExtension;
-	int len;
-
-	len = _e1000_poll(hw);
-	if (len) {
-		net_process_received_packet((unsigned char *)hw->packet, len);
-		fill_rx(hw);
-	}
-
-	return len ? 1 : 0;
-}
-
 /**************************************************************************
 PROBE - Look for an adapter, this routine's visible to the outside
 You should omit the last argument struct pci_device * for a non-PCI NIC
@@ -1106,17 +1106,26 @@ struct e1000_hw {
 	LPVOID memaddr_s;  //Start memory mapping address.
 	LPVOID memaddr_e;  //End memory mapping address.
 
+	/* Interface name and interrupt object. */
+	char ifname[MAX_ETH_NAME_LEN + 1];
+	HANDLE hInterrupt;
+
 	/*
-	 * TX/RX descriptors and packet buffer.
+	 * TX/RX descriptors and buffers.Frames are received into
+	 * data blocks directly,the block of a descriptor is replaced
+	 * by a new one when it's frame is posted to network core.
 	 */
 	struct e1000_tx_desc* tx_base;
 	struct e1000_rx_desc* rx_base;
-	unsigned char* packet;
+	unsigned char* tx_buffer;
+	__ETH_DATA_BLOCK** rx_block;
+	__ETH_BUFFER_POOL* rx_pool;
 
 	/* Descriptor pointer. */
-	int tx_tail;
-	int rx_tail;
-	int rx_last;
+	int tx_tail;     //Next tx descriptor to fill.
+	int tx_clean;    //Oldest tx descriptor not reclaimed.
+	int tx_ctx;      //Checksum context loaded in NIC,0 if none.
+	int rx_tail;     //Next rx descriptor to check.
 
 	uint8_t *hw_addr;
 	e1000_mac_type mac_type;
@@ -1531,6 +1540,7 @@ Pin 5 */
 #define E1000_RCTL_DPF		0x00400000	/* discard pause frames */
 #define E1000_RCTL_PMCF		0x00800000	/* pass MAC control frames */
 #define E1000_RCTL_BSEX		0x02000000	/* Buffer size extension */
+#define E1000_RCTL_SECRC	0x04000000	/* Strip Ethernet CRC */
 
 /* SW_W_SYNC definitions */
 #define E1000_SWFW_EEP_SM     0x0001
@@ -2623,5 +2633,13 @@ after IMS clear */
 int e1000_init_one(struct e1000_hw *hw, int cardnum, __PHYSICAL_DEVICE* pdev,
 	unsigned char enetaddr[6]);
 int _e1000_init(struct e1000_hw *hw, unsigned char enetaddr[6]);
+void e1000_name(char *str, int cardnum);
+void _e1000_disable(struct e1000_hw *hw);
+int _e1000_transmit(struct e1000_hw *hw, void *txpacket, int length, int csum);
+int e1000_clean_rx(struct e1000_hw *hw, int budget);
+int e1000_clean_tx(struct e1000_hw *hw);
+BOOL e1000_interrupt(struct e1000_hw *hw);
+void e1000_irq_enable(struct e1000_hw *hw);
+void e1000_irq_disable(struct e1000_hw *hw);
 
 #endif	/* _E1000_HW_H_ */
@@ -165,23 +165,152 @@ void* pci_map_bar(__PHYSICAL_DEVICE* pdev, DWORD dwOffset, DWORD dwFlags)
 	return vir_mem;
 }
 
-/* Process incoming packet. */
-void net_process_received_packet(unsigned char* packet, int length)
+/* Interrupt handler of E1000 NIC. */
+static BOOL E1000_Interrupt(LPVOID lpESP, LPVOID lpParam)
 {
-	return;
+	struct e1000_hw* hw = (struct e1000_hw*)lpParam;
+
+	/* Not registered to network framework yet. */
+	if (NULL == hw->nic)
+	{
+		return FALSE;
+	}
+	return e1000_interrupt(hw);
+}
+
+/*
+ * Initializer of the ethernet interface,it will be called by HelloX's
+ * ethernet framework.Checksum offload is told to network core here.
+ */
+static BOOL Ethernet_Int_Init(__ETHERNET_INTERFACE* pInt)
+{
+	struct e1000_hw* hw = (struct e1000_hw*)pInt->pIntExtension;
+
+	if (hw->mac_type >= e1000_82543)
+	{
+		pInt->dwOffloadFlags |= ETH_OFFLOAD_RX_CSUM;
+		if (hw->mac_type != e1000_igb)
+		{
+			pInt->dwOffloadFlags |= ETH_OFFLOAD_TX_CSUM;
+		}
+	}
+	return TRUE;
+}
+
+/* Control functions of the ethernet interface. */
+static BOOL Ethernet_Ctrl(__ETHERNET_INTERFACE* pInt, DWORD dwOperation, LPVOID pData)
+{
+	return TRUE;
+}
+
+/*
+ * Send a ethernet frame out through E1000 NIC.The frame's content
+ * is in pInt's send buffer,it's copied into tx ring and the routine
+ * returns without waiting the NIC.
+ */
+static BOOL Ethernet_SendFrame(__ETHERNET_INTERFACE* pInt)
+{
+	struct e1000_hw*   hw = NULL;
+	__ETHERNET_BUFFER* pEthBuff = NULL;
+	int                csum = 0;
+	BOOL               bResult = FALSE;
+
+	if (NULL == pInt)
+	{
+		goto __TERMINAL;
+	}
+	pEthBuff = &pInt->SendBuffer;
+
+	//No data to send or exceed the MTU(include ethernet frame header).
+	if ((0 == pEthBuff->act_length) || (pEthBuff->act_length > (ETH_DEFAULT_MTU + ETH_HEADER_LEN)))
+	{
+		goto __TERMINAL;
+	}
+
+	hw = (struct e1000_hw*)pInt->pIntExtension;
+	if ((pEthBuff->csum_flags & ETH_CSUM_TX_L4) &&
+		(pInt->dwOffloadFlags & ETH_OFFLOAD_TX_CSUM))
+	{
+		csum = 1;
+	}
+	if (0 == _e1000_transmit(hw, pEthBuff->Buffer, pEthBuff->act_length, csum))
+	{
+		//Tx ring is full.
+		pInt->ifState.dwTxErrorNum++;
+		goto __TERMINAL;
+	}
+	bResult = TRUE;
+
+__TERMINAL:
+	return bResult;
 }
 
 /*
- * Initialize a new found E1000 nic.
+ * Receive a frame from ethernet link.Frames are posted to network
+ * core in interrupt handler,so nothing to do here.
+ */
+static __ETHERNET_BUFFER* Ethernet_RecvFrame(__ETHERNET_INTERFACE* pInt)
+{
+	return NULL;
+}
+
+/*
+ * Initialize a new found E1000 nic,and register it to HelloX's
+ * network framework.
  */
 static BOOL _Init_E1000(struct e1000_hw* hw)
 {
 	unsigned char macAddr[6];
-	int ret = -1;
+	BOOL bResult = FALSE;
+
+	e1000_name(hw->ifname, hw->cardnum);
+	hw->name = hw->ifname;
+
+	if (e1000_init_one(hw, hw->cardnum, hw->pdev, macAddr))
+	{
+		goto __TERMINAL;
+	}
+	if (_e1000_init(hw, macAddr))
+	{
+		goto __TERMINAL;
+	}
+
+	hw->hInterrupt = ConnectInterrupt(E1000_Interrupt,
+		(LPVOID)hw,
+		hw->int_vector + INTERRUPT_VECTOR_BASE);
+	if (NULL == hw->hInterrupt)
+	{
+		_hx_printf("%s:can not connect interrupt object[vector = %d].\r\n",
+			__func__,
+			hw->int_vector + INTERRUPT_VECTOR_BASE);
+		_e1000_disable(hw);
+		goto __TERMINAL;
+	}
 
-	ret = e1000_init_one(hw, hw->cardnum, hw->pdev, macAddr);
-	_e1000_init(hw, macAddr);
-	return (0 == ret ? TRUE : FALSE);
+	hw->nic = EthernetManager.AddEthernetInterface(
+		hw->ifname,
+		(char*)macAddr,
+		(LPVOID)hw,
+		Ethernet_Int_Init,
+		Ethernet_SendFrame,
+		Ethernet_RecvFrame,
+		Ethernet_Ctrl);
+	if (NULL == hw->nic)
+	{
+		_hx_printf("%s:add ethernet interface[%s] failed.\r\n", __func__, hw->ifname);
+		_e1000_disable(hw);
+		DisconnectInterrupt(hw->hInterrupt);
+		hw->hInterrupt = NULL;
+		goto __TERMINAL;
+	}
+	hw->nic->pBufferPool = hw->rx_pool;
+
+	/* Everything is ready,frames can be received now. */
+	e1000_irq_enable(hw);
+	bResult = TRUE;
+
+__TERMINAL:
+	return bResult;
 }
 
 /*
@@ -270,13 +399,39 @@ static BOOL _Check_E1000_Nic(struct pci_device_id* id)
 		{
 			goto __TERMINAL;
 		}
-		priv->packet = (unsigned char*)_hx_aligned_malloc(PACKET_BUFFER_SIZE,
-			E1000_BUFFER_ALIGN);
-		if (NULL == priv->packet)
+		priv->tx_buffer = (unsigned char*)_hx_aligned_malloc(
+			TX_DESC_NUM * TX_BUFFER_SIZE, E1000_BUFFER_ALIGN);
+		if (NULL == priv->tx_buffer)
 		{
 			goto __TERMINAL;
 		}
 
+		/* 
+		 * Rx buffers are data blocks from a pool,extra blocks are
+		 * replaced into descriptors when frames are posted.
+		 */
+		priv->rx_block = (__ETH_DATA_BLOCK**)_hx_malloc(
+			RX_DESC_NUM * sizeof(__ETH_DATA_BLOCK*));
+		if (NULL == priv->rx_block)
+		{
+			goto __TERMINAL;
+		}
+		memset(priv->rx_block, 0, RX_DESC_NUM * sizeof(__ETH_DATA_BLOCK*));
+		priv->rx_pool = EthernetManager.CreateBufferPool(
+			RX_DESC_NUM + ETH_BUFFER_POOL_SIZE);
+		if (NULL == priv->rx_pool)
+		{
+			goto __TERMINAL;
+		}
+		for (index = 0; index < RX_DESC_NUM; index++)
+		{
+			priv->rx_block[index] = EthernetManager.AllocDataBlock(priv->rx_pool);
+			if (NULL == priv->rx_block[index])
+			{
+				goto __TERMINAL;
+			}
+		}
+
 		priv->pdev = pDev;
 		priv->ioport_s = iobase_s;
 		priv->ioport_e = iobase_e;
@@ -327,9 +482,24 @@ __TERMINAL:
 			{
 				_hx_free(priv->rx_base);
 			}
-			if (priv->packet)
+			if (priv->tx_buffer)
+			{
+				_hx_free(priv->tx_buffer);
+			}
+			if (priv->rx_block)
+			{
+				for (index = 0; index < RX_DESC_NUM; index++)
+				{
+					if (priv->rx_block[index])
+					{
+						EthernetManager.ReleaseDataBlock(priv->rx_block[index]);
+					}
+				}
+				_hx_free(priv->rx_block);
+			}
+			if (priv->rx_pool)
 			{
-				_hx_free(priv->packet);
+				EthernetManager.DestroyBufferPool(priv->rx_pool);
 			}
 			_hx_free(priv);
 		}
@@ -19,12 +19,24 @@
 /* Intel i210 needs the DMA descriptor rings aligned to 128b */
 #define E1000_BUFFER_ALIGN	128
 
-/* Tx/Rx descriptor number. */
-#define TX_DESC_NUM 16
-#define RX_DESC_NUM 16
+/* 
+ * Tx/Rx descriptor number,the ring's length in bytes must
+ * be multiple of 128.
+ */
+#define TX_DESC_NUM 256
+#define RX_DESC_NUM 256
 
-/* Packet buffer size. */
-#define PACKET_BUFFER_SIZE 4096
+/* 
+ * Buffer size of each tx descriptor,a frame is copied into
+ * it and the descriptor is reclaimed after the NIC sends it.
+ */
+#define TX_BUFFER_SIZE 1536
+
+/* 
+ * Maximal frames processed in one interrupt,the rest is left
+ * to next interrupt,which is throttled by ITR.
+ */
+#define E1000_RX_BUDGET 64
 
 /* PCI device ID. */
 struct pci_device_id{
@@ -55,7 +67,4 @@ void* pci_map_bar(__PHYSICAL_DEVICE* pdev, DWORD dwOffset, DWORD dwFlags);
 /* Entry point of E1000 driver. */
 BOOL E1000_Drv_Initialize(LPVOID pData);
 
-/* Process incoming packet. */
-void net_process_received_packet(unsigned char* packet, int length);
-
 #endif //__E1000_H__
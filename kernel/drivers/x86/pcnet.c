@@ -398,7 +398,7 @@ static BOOL ProbePCNetNICs()
 	return bResult;
 }
 
-static unsigned char* pcnet_recv(pcnet_priv_t *dev, int* pPktLen);
+static unsigned char* pcnet_recv(pcnet_priv_t *dev, int* pPktLen, __ETH_DATA_BLOCK** ppBlock);
 
 //Handle the Rx interrupt.It requests a ethernet buffer object,copy the
 //received data into it,and post it to Ethernet Core Thread.
@@ -407,6 +407,7 @@ static VOID RxInterruptHandler(pcnet_priv_t* priv)
 	__ETHERNET_BUFFER* pEthBuff = NULL;
 	int            len = 0;
 	__ETHERNET_INTERFACE* pEthInt = priv->pEthInt;
+	__ETH_DATA_BLOCK* pBlock = NULL;
 	unsigned char* buf = NULL;
 
 	if (NULL == pEthInt)
@@ -414,14 +415,26 @@ static VOID RxInterruptHandler(pcnet_priv_t* priv)
 		BUG();
 	}
 
-	buf = pcnet_recv(priv, &len);
+	buf = pcnet_recv(priv, &len, &pBlock);
 	if (!buf)  //No packet received.
 	{
 		return;
 	}
 
 	//Received a pakcet,post to kernel.
-	if (len > 0)
+	if (pBlock)  //Received into data block directly.
+	{
+		pEthBuff = EthernetManager.CreateRxEthernetBuffer(pEthInt, pBlock, len);
+		if (NULL == pEthBuff)
+		{
+			return;
+		}
+		if (!EthernetManager.PostFrame(pEthInt, pEthBuff))
+		{
+			EthernetManager.DestroyEthernetBuffer(pEthBuff);
+		}
+	}
+	else if (len > 0)
 	{
 		pEthBuff = EthernetManager.CreateEthernetBuffer(len);
 		if (NULL == pEthBuff)
@@ -560,6 +573,8 @@ static BOOL InitPCNetNIC(pcnet_priv_t* dev)
 	//controller that both Init Block and TX/RX ring must be aligned with 16 boundary.
 	dev->uc = dev->uc_unalign = NULL;
 	dev->rx_buf = dev->rx_buf_unalign = NULL;
+	dev->rx_pool = NULL;
+	memset(dev->rx_block, 0, sizeof(dev->rx_block));
 #ifdef __CFG_SYS_VMM
 	//Use virtual memory mechanism to implement the un-cached zone.
 	uc = (struct pcnet_uncached_priv*)VirtualAlloc(
@@ -591,20 +606,33 @@ static BOOL InitPCNetNIC(pcnet_priv_t* dev)
 	addr = (addr + 0x0F) & ~0x0F;
 	dev->uc = (struct pcnet_uncached_priv*)addr;
 
-	//Allocate rx buffer.
-	rx_buff = (unsigned char*)_hx_malloc(sizeof(*dev->rx_buf) + 0x10);
-	if (NULL == rx_buff)
+	//Allocate rx buffer,use data blocks from pool if can,so the received frame
+	//need not to be copied.
+	dev->rx_pool = EthernetManager.CreateBufferPool(ETH_BUFFER_POOL_SIZE);
+	for (i = 0; (i < RX_RING_SIZE) && dev->rx_pool; i++)
 	{
+		dev->rx_block[i] = EthernetManager.AllocDataBlock(dev->rx_pool);
+		if (NULL == dev->rx_block[i])
+		{
+			goto __TERMINAL;
+		}
+	}
+	if (NULL == dev->rx_pool)
+	{
+		rx_buff = (unsigned char*)_hx_malloc(sizeof(*dev->rx_buf) + 0x10);
+		if (NULL == rx_buff)
+		{
 #ifdef __PCNET_DEBUG
-		_hx_printf("PCNet: Can not allocate memory for rx_buff.\r\n");
+			_hx_printf("PCNet: Can not allocate memory for rx_buff.\r\n");
 #endif
-		goto __TERMINAL;
+			goto __TERMINAL;
+		}
+		dev->rx_buf_unalign = rx_buff;
+		//Align to 16.
+		addr = (__U32)rx_buff;
+		addr = (addr + 0x0F) & ~0x0F;
+		dev->rx_buf = (unsigned char*)addr;
 	}
-	dev->rx_buf_unalign = rx_buff;
-	//Align to 16.
-	addr = (__U32)rx_buff;
-	addr = (addr + 0x0F) & ~0x0F;
-	dev->rx_buf = (unsigned char*)addr;
 
 	uc = dev->uc;
 	//Initialize Init Block.
@@ -617,7 +645,14 @@ static BOOL InitPCNetNIC(pcnet_priv_t* dev)
 	*/
 	dev->cur_rx = 0;
 	for (i = 0; i < RX_RING_SIZE; i++) {
-		uc->rx_ring[i].base = (__U32)PCI_TO_MEM_LE(dev, (*dev->rx_buf)[i]);
+		if (dev->rx_block[i])
+		{
+			uc->rx_ring[i].base = (__U32)cpu_to_le32(dev->rx_block[i]->DmaAddr);
+		}
+		else
+		{
+			uc->rx_ring[i].base = (__U32)PCI_TO_MEM_LE(dev, (*dev->rx_buf)[i]);
+		}
 		uc->rx_ring[i].buf_length = cpu_to_le16(-PKT_BUF_SZ);
 		uc->rx_ring[i].status = cpu_to_le16(0x8000);
 #ifdef __PCNET_DEBUG
@@ -702,6 +737,16 @@ __TERMINAL:
 		{
 			_hx_free(dev->rx_buf_unalign);
 		}
+		for (i = 0; i < RX_RING_SIZE; i++)
+		{
+			EthernetManager.ReleaseDataBlock(dev->rx_block[i]);
+			dev->rx_block[i] = NULL;
+		}
+		if (dev->rx_pool)
+		{
+			EthernetManager.DestroyBufferPool(dev->rx_pool);
+			dev->rx_pool = NULL;
+		}
 		if (dev->hInterrupt)
 		{
 			DisconnectInterrupt(dev->hInterrupt);
@@ -796,13 +841,18 @@ failure:
 
 //Receive a packet from PCNet NIC,it maybe called by the polling process
 //of HelloX's network framework.
-static unsigned char* pcnet_recv(pcnet_priv_t *dev,int* pPktLen)
+//If the frame is received into data block,the block is returned by ppBlock
+//and replaced by a new one in rx ring,otherwise ppBlock is set to NULL and
+//caller should copy the frame out.
+static unsigned char* pcnet_recv(pcnet_priv_t *dev,int* pPktLen, __ETH_DATA_BLOCK** ppBlock)
 {
 	struct pcnet_rx_head *entry;
+	__ETH_DATA_BLOCK* pNewBlock = NULL;
 	unsigned char *buf = NULL;
 	int pkt_len = 0;
 	__U16 status, err_status;
 	
+	*ppBlock = NULL;
 	while (1) {
 		entry = &dev->uc->rx_ring[dev->cur_rx];
 		
@@ -841,6 +891,19 @@ static unsigned char* pcnet_recv(pcnet_priv_t *dev,int* pPktLen)
 					_hx_printf("PCNet: Rx%d: invalid packet length %d\r\n",
 						dev->cur_rx, pkt_len);
 				}
+				else if (dev->rx_block[dev->cur_rx]) {
+					buf = dev->rx_block[dev->cur_rx]->Data;
+					__FLUSH_CACHE(buf, buf + pkt_len, CACHE_FLUSH_INVALIDATE);
+					//Hand out the block and refill the entry with a new one,
+					//the frame is copied out from entry if can not get new one.
+					pNewBlock = EthernetManager.AllocDataBlock(dev->rx_pool);
+					if (pNewBlock)
+					{
+						*ppBlock = dev->rx_block[dev->cur_rx];
+						dev->rx_block[dev->cur_rx] = pNewBlock;
+						__writel(cpu_to_le32(pNewBlock->DmaAddr), (unsigned long)&entry->base);
+					}
+				}
 				else {
 					buf = (*dev->rx_buf)[dev->cur_rx];
 					__FLUSH_CACHE(buf, buf + pkt_len, CACHE_FLUSH_INVALIDATE);
@@ -929,6 +992,7 @@ static __ETHERNET_BUFFER* Ethernet_RecvFrame(__ETHERNET_INTERFACE* pInt)
 	__ETHERNET_BUFFER* pEthBuff = NULL;
 	int            len = 0;
 	pcnet_priv_t*  dev = NULL;
+	__ETH_DATA_BLOCK* pBlock = NULL;
 	unsigned char* buf = NULL;
 
 	if (NULL == pInt)
@@ -941,16 +1005,18 @@ static __ETHERNET_BUFFER* Ethernet_RecvFrame(__ETHERNET_INTERFACE* pInt)
 		return NULL;
 	}
 
-	buf = pcnet_recv(dev, &len);
+	buf = pcnet_recv(dev, &len, &pBlock);
 	if (!buf)  //No packet received.
 	{
 		return NULL;
 	}
 
-
-
 	//Received a pakcet,delivery it to IP stack.
-	if (len > 0)
+	if (pBlock)
+	{
+		pEthBuff = EthernetManager.CreateRxEthernetBuffer(pInt, pBlock, len);
+	}
+	else if (len > 0)
 	{
 		pEthBuff = EthernetManager.CreateEthernetBuffer(len);
 		if (NULL == pEthBuff)
@@ -1053,6 +1119,10 @@ BOOL PCNet_Drv_Initialize(LPVOID pData)
 			//Mark the structure as unavailable,it will be released later.
 			dev->available = 0;
 		}
+		else
+		{
+			dev->pEthInt->pBufferPool = dev->rx_pool;
+		}
 		//Process next one.
 		dev = dev->next;
 		index ++;
@@ -114,6 +114,12 @@ typedef struct pcnet_priv {
 	/* Receive Buffer space */
 	unsigned char(*rx_buf)[RX_RING_SIZE][PKT_BUF_SZ + 4];
 	unsigned char(*rx_buf_unalign)[RX_RING_SIZE][PKT_BUF_SZ + 4];
+	/* 
+	 * Data blocks as receive buffer,NIC receives frame into
+	 * them directly,the rx_buf is used if can not create pool.
+	 */
+	__ETH_BUFFER_POOL* rx_pool;
+	__ETH_DATA_BLOCK* rx_block[RX_RING_SIZE];
 	int cur_rx;
 	int cur_tx;
 	/* Hardware resources of the NIC. */
@@ -205,15 +205,19 @@ __TERMINAL:
 
 //Receive a frame from link into device private data structure's buffer,and return
 //the buffer to caller.
-static char* RTL8111_Recv(rtl8111_priv_t* priv, int* len)
+//If the buffer is data block,it's returned by ppBlock and replaced by a new one in
+//rx descriptor,caller should copy the frame out if ppBlock is set to NULL.
+static char* RTL8111_Recv(rtl8111_priv_t* priv, int* len, __ETH_DATA_BLOCK** ppBlock)
 {
 	unsigned long ioaddr = priv->ioaddr;
+	__ETH_DATA_BLOCK* pNewBlock = NULL;
 	char*         rtlbuf = NULL;
 	int           cur_rx;
 	int           pkt_size = 0;
 	int           rxdesc_cnt = 0;
 	struct	RxDesc	*rxdesc;
 
+	*ppBlock = NULL;
 	cur_rx = priv->cur_rx;
 	rxdesc = &priv->RxDescArray[cur_rx];
 	//Synchronizing cache content if necessary.
@@ -239,6 +243,19 @@ static char* RTL8111_Recv(rtl8111_priv_t* priv, int* len)
 			}
 
 			rtlbuf = (char*)rxdesc->buf_addr;
+			if (priv->rx_block[cur_rx])
+			{
+				//Descriptor holds physical address,use the block's.
+				rtlbuf = (char*)priv->rx_block[cur_rx]->Data;
+				pNewBlock = EthernetManager.AllocDataBlock(priv->rx_pool);
+				if (pNewBlock)  //Hand out the block and refill descriptor.
+				{
+					*ppBlock = priv->rx_block[cur_rx];
+					priv->rx_block[cur_rx] = pNewBlock;
+					priv->rx_skbuff_dma_addr[cur_rx] = (dma_addr_t)pNewBlock->DmaAddr;
+					rxdesc->buf_addr = cpu_to_le32(priv->rx_skbuff_dma_addr[cur_rx]);
+				}
+			}
 			// Update rx descriptor
 			if (cur_rx == (NUM_RX_DESC - 1))
 			{
@@ -354,6 +371,7 @@ static BOOL RTL8111_RX_Interrupt(rtl8111_priv_t* priv)
 {
 	__ETHERNET_INTERFACE*  pEthInt = priv->pEthInt;
 	__ETHERNET_BUFFER*  pEthBuff = NULL;
+	__ETH_DATA_BLOCK*   pBlock = NULL;
 	unsigned char*      buf = NULL;
 	int                 len = 0;
 
@@ -368,8 +386,21 @@ static BOOL RTL8111_RX_Interrupt(rtl8111_priv_t* priv)
 		buf = NULL;
 		len = 0;
 
-		buf = (unsigned char*)RTL8111_Recv(priv, &len);
-		if (buf)
+		buf = (unsigned char*)RTL8111_Recv(priv, &len, &pBlock);
+		if (buf && pBlock)
+		{
+			//Received into data block directly,post to kernel.
+			pEthBuff = EthernetManager.CreateRxEthernetBuffer(pEthInt, pBlock, len);
+			if (NULL == pEthBuff)
+			{
+				continue;
+			}
+			if (!EthernetManager.PostFrame(pEthInt, pEthBuff))
+			{
+				EthernetManager.DestroyEthernetBuffer(pEthBuff);
+			}
+		}
+		else if (buf)
 		{
 			//Received a pakcet,post to kernel.			
 			pEthBuff = EthernetManager.CreateEthernetBuffer(len);
@@ -549,6 +580,9 @@ static BOOL RTL8111_Start(rtl8111_priv_t* priv)
 	memset(priv->TxDescArray, 0, priv->sizeof_txdesc_space);
 	memset(priv->RxDescArray, 0, priv->sizeof_rxdesc_space);
 
+	//Use data blocks as rx buffer if can,to avoid copying received frames.
+	priv->rx_pool = EthernetManager.CreateBufferPool(ETH_BUFFER_POOL_SIZE);
+
 	for (i = 0; i < NUM_RX_DESC; i++)
 	{
 		if (i == (NUM_RX_DESC - 1))
@@ -562,7 +596,15 @@ static BOOL RTL8111_Start(rtl8111_priv_t* priv)
 				cpu_to_le32(OWNbit | (unsigned long)priv->hw_rx_pkt_len);
 		}
 
-		priv->rx_skbuff_dma_addr[i] = (dma_addr_t)_hx_malloc(MAX_RX_SKBDATA_SIZE);
+		if (priv->rx_pool)
+		{
+			priv->rx_block[i] = EthernetManager.AllocDataBlock(priv->rx_pool);
+			priv->rx_skbuff_dma_addr[i] = priv->rx_block[i] ? (dma_addr_t)priv->rx_block[i]->DmaAddr : 0;
+		}
+		else
+		{
+			priv->rx_skbuff_dma_addr[i] = (dma_addr_t)_hx_malloc(MAX_RX_SKBDATA_SIZE);
+		}
 		if (0 == priv->rx_skbuff_dma_addr[i])
 		{
 			_hx_printf("%s:can not allocate rx buffer.\r\n", __func__);
@@ -801,6 +843,7 @@ static __ETHERNET_BUFFER* Ethernet_RecvFrame(__ETHERNET_INTERFACE* pInt)
 {
 	__ETHERNET_BUFFER* pEthBuff = NULL;
 	rtl8111_priv_t*    dev = NULL;
+	__ETH_DATA_BLOCK*  pBlock = NULL;
 	unsigned char*     buf = NULL;
 	int                len = 0;
 
@@ -815,14 +858,18 @@ static __ETHERNET_BUFFER* Ethernet_RecvFrame(__ETHERNET_INTERFACE* pInt)
 		return NULL;
 	}
 
-	buf = RTL8111_Recv(dev, &len);
+	buf = RTL8111_Recv(dev, &len, &pBlock);
 	if (!buf)  //No packet received.
 	{
 		return NULL;
 	}
 
 	//Received a pakcet,delivery it to IP stack.
-	if (len > 0)
+	if (pBlock)
+	{
+		pEthBuff = EthernetManager.CreateRxEthernetBuffer(pInt, pBlock, len);
+	}
+	else if (len > 0)
 	{
 		pEthBuff = EthernetManager.CreateEthernetBuffer(len);
 		if (NULL == pEthBuff)
@@ -907,6 +954,10 @@ BOOL RTL8111_Drv_Initialize(LPVOID pData)
 			//Mark the structure as unavailable,it will be released later.
 			dev->available = 0;
 		}
+		else
+		{
+			dev->pEthInt->pBufferPool = dev->rx_pool;
+		}
 		//Process next one.
 		dev = dev->next;
 		index++;
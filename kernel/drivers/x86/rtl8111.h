@@ -352,6 +352,9 @@ struct rtl8111_priv{
 	dma_addr_t txdesc_array_dma_addr[NUM_TX_DESC];
 	dma_addr_t rxdesc_array_dma_addr[NUM_RX_DESC];
 	dma_addr_t rx_skbuff_dma_addr[NUM_RX_DESC];
+	//Data blocks as rx buffer,NIC receives frame into them directly.
+	__ETH_BUFFER_POOL* rx_pool;
+	__ETH_DATA_BLOCK* rx_block[NUM_RX_DESC];
 
 	void *txdesc_space;
 	dma_addr_t txdesc_phy_dma_addr;
@@ -128,6 +128,10 @@
 #include "kmemmgr.h"
 #endif
 
+#ifndef __SLAB_H__
+#include "slab.h"
+#endif
+
 #ifndef __KTMSG_H__
 #include "ktmsg.h"
 #endif
@@ -35,27 +35,18 @@ typedef struct LOG_MESSAGE{
 	char msg[MSG_MAX_LENGTH];
 }__LOG_MESSAGE;
 
-typedef struct BUFFER_QUEUE
-{
-	__LOG_MESSAGE BufferQueue[256];
-	int head;
-	int tail;
-	int len;
-
-	void (*Enqueue)(struct BUFFER_QUEUE *pThis, __LOG_MESSAGE *pMsg);
-	__LOG_MESSAGE *(*Dequeue)(struct BUFFER_QUEUE *pThis);
-
-}__BUFFER_QUEUE;
+//Length of log rings,log messages are dropped if the ring is full.
+#define LOG_RING_LENGTH 256
 
 typedef struct DEBUG_MANAGER{
-	//һͬ ɶأ
-	__MUTEX *pMutexForBufferQueue;
-	// User logpool..
-	__BUFFER_QUEUE *pBufferQueue;
+	// User log ring,elements are pointers of __LOG_MESSAGE.
+	__RING_BUFFER *pLogRing;
+
+	// For kernel log ring.
+	__RING_BUFFER *pKRNLLogRing;
 
-	// For kernel bufferqueue and sync
-	__MUTEX *pMutexForKRNLBufferQueue;
-	__BUFFER_QUEUE *pKRNLBufferQueue;
+	// Set by both rings when they become non-empty.
+	__EVENT *pLogEvent;
 
 	void (*Log)(struct DEBUG_MANAGER *pThis, char *tag, char *msg);
 	void (*Logk)(struct DEBUG_MANAGER *pThis, char *tag, char *msg);
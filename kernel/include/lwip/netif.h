@@ -98,6 +98,18 @@ extern "C" {
 #ifdef __CFG_NET_NAT
 #define NETIF_FLAG_NAT          0x100U
 #endif /* __CFG_NET_NAT */
+/** HelloX: the link level driver fills TCP/UDP checksum of outgoing
+ * packets marked with PBUF_FLAG_CSUM_TX. */
+#define NETIF_FLAG_TXCSUM       0x200U
+
+/** HelloX: whether the TCP/UDP checksum of a packet to dest,of tot_len
+ * bytes without IP header,can be left to the NIC. The packet must not
+ * be fragmented or looped back,where nobody fills the checksum. */
+#define NETIF_TXCSUM_OFFLOAD(netif, dest, tot_len) \
+  (((netif)->flags & NETIF_FLAG_TXCSUM) && \
+   ((tot_len) + IP_HLEN <= (netif)->mtu) && \
+   !ip_addr_cmp((dest), &((netif)->ip_addr)) && \
+   !ip_addr_ismulticast(dest))
 
 /** Function prototype for netif init functions. Set up flags and output/linkoutput
  * callback functions in this function.
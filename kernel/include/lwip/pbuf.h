@@ -69,6 +69,12 @@ typedef enum {
 #define PBUF_FLAG_IS_CUSTOM 0x02U
 /** indicates this pbuf is UDP multicast to be looped back */
 #define PBUF_FLAG_MCASTLOOP 0x04U
+/** HelloX: TCP/UDP checksum of this outgoing packet is left to the NIC */
+#define PBUF_FLAG_CSUM_TX   0x10U
+/** HelloX: IP header checksum of this incoming packet is verified by the NIC */
+#define PBUF_FLAG_CSUM_IP_OK 0x20U
+/** HelloX: TCP/UDP checksum of this incoming packet is verified by the NIC */
+#define PBUF_FLAG_CSUM_L4_OK 0x40U
 
 struct pbuf {
   /** next pbuf in singly linked pbuf chain */
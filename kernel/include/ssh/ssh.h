@@ -43,6 +43,9 @@ extern "C" {
 	int   ssh_send_msg(void* p,const char* buf,int len);
 
 	int   ssh_recv_msg(void* p,char* buf,int len);
+
+	int   ssh_cipher_bench(void);   //print throughput of ciphers
+	int   ssh_kex_bench(void);      //print cost of key exchange
 	
 
 #ifdef __cplusplus
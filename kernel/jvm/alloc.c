@@ -127,6 +127,24 @@ static char *heapmax;
 
 static unsigned long heapfree;
 
+/* Thread local allocation buffers.  Small objects are allocated by
+   bumping a pointer within the thread's buffer, which is carved from
+   the free list under the heap lock and zeroed in one go.  Before the
+   heap is scanned by GC the unused tail of each buffer is turned into
+   a free chunk (retired), so the heap is walkable when the world is
+   stopped */
+#define TLAB_SIZE               (16*1024)
+#define TLAB_MAX_OBJECT         (TLAB_SIZE/8)
+
+/* Set when no free chunk is big enough for a new buffer.  Cleared
+   by GC, to avoid scanning the free list on each allocation */
+static int tlab_exhausted;
+
+/* Cumulative GC statistics */
+static GCStats gc_stats;
+static struct timeval last_gc_end;
+static unsigned long long last_gc_allocated;
+
 /* The mark bit array, used for marking objects during
    the mark phase.  Allocated on start-up. */
 static unsigned int *markbits;
@@ -325,6 +343,9 @@ void initialiseAlloc(InitArgs *args) {
 
     /* Set verbose option from initialisation arguments */
     verbosegc = args->verbosegc;
+
+    /* Allocation rate is measured from VM start to the first GC */
+    gettimeofday(&last_gc_end, 0);
 }
 
 /* ------------------------- MARK PHASE ------------------------- */
@@ -1560,8 +1581,33 @@ static long endTime(struct timeval *start) {
     return secs * 1000000 + usecs;
 }
 
+/* Record the pause time of a GC and the allocation rate since the
+   previous one.  Called with the heap lock held */
+static void updateGCStats(long pause) {
+    unsigned long long allocated = gc_stats.allocated - last_gc_allocated;
+    long interval = endTime(&last_gc_end);
+
+    gc_stats.collections++;
+    gc_stats.total_pause += pause;
+    if(pause > gc_stats.max_pause)
+        gc_stats.max_pause = pause;
+
+    if(verbosegc) {
+        jam_printf("<GC: Pause %ld us, allocated %lld bytes since last GC",
+                   pause, allocated);
+        if(interval > 0)
+            jam_printf(" (%lld KB/s)",
+                       (long long)(allocated * 1000000 / interval / 1024));
+        jam_printf(">\n");
+    }
+
+    last_gc_allocated = gc_stats.allocated;
+    getTime(&last_gc_end);
+}
+
 unsigned long gc0(int mark_soft_refs, int compact) {
     Thread *self = threadSelf();
+    struct timeval pause_start;
     uintptr_t largest;
 
     /* Override compact if compaction has been specified
@@ -1588,9 +1634,15 @@ unsigned long gc0(int mark_soft_refs, int compact) {
     lockVMWaitLock(reference_lock, self);
 
     /* Stop the world */
+    getTime(&pause_start);
     disableSuspend(self);
     suspendAllThreads(self);
 
+    /* Turn the unused part of all allocation buffers into free
+       chunks, so they can be walked and swept */
+    retireThreadsTLAB();
+    tlab_exhausted = FALSE;
+
     if(verbosegc) {
         struct timeval start;
         float mark_time;
@@ -1614,6 +1666,7 @@ unsigned long gc0(int mark_soft_refs, int compact) {
     /* Restart the world */
     resumeAllThreads(self);
     enableSuspend(self);
+    updateGCStats(endTime(&pause_start));
 
     /* Notify the finaliser thread if new finalisers
        need to be ran */
@@ -1815,6 +1868,84 @@ void initialiseGC(InitArgs *args) {
 
 /* ------------------------- ALLOCATION ROUTINES  ------------------------- */
 
+/* Retire a thread's allocation buffer.  The heap lock must be
+   held, or all threads suspended */
+void retireTLAB(Thread *thread) {
+    char *top = thread->tlab_top;
+
+    if(top == NULL)
+        return;
+
+    if(top < thread->tlab_end)
+        ((Chunk*)top)->header = thread->tlab_end - top;
+
+    gc_stats.allocated += top - thread->tlab_start;
+    thread->tlab_start = thread->tlab_top = thread->tlab_end = NULL;
+}
+
+/* Retire the buffer of a thread which is exiting */
+void freeThreadTLAB(Thread *thread) {
+    if(!tryLockVMLock(heap_lock, thread)) {
+        disableSuspend(thread);
+        lockVMLock(heap_lock, thread);
+        enableSuspend(thread);
+    }
+
+    retireTLAB(thread);
+    unlockVMLock(heap_lock, thread);
+}
+
+/* Carve a new allocation buffer from the free list.  The heap
+   lock must be held.  The next allocation pointer is not moved,
+   so small chunks skipped here are still used by gcMalloc */
+static int refillTLAB(Thread *self) {
+    Chunk **chunk;
+
+    for(chunk = chunkpp; *chunk; chunk = &(*chunk)->next) {
+        uintptr_t len = (*chunk)->header;
+        Chunk *found = *chunk;
+
+        if(len < TLAB_SIZE)
+            continue;
+
+        if(len - TLAB_SIZE >= MIN_OBJECT_SIZE) {
+            Chunk *rem = (Chunk*)((char*)found + TLAB_SIZE);
+            rem->header = len - TLAB_SIZE;
+            rem->next = found->next;
+            *chunk = rem;
+            len = TLAB_SIZE;
+        } else
+            *chunk = found->next;
+
+        heapfree -= len;
+        memset(found, 0, len);
+
+        self->tlab_start = self->tlab_top = (char*)found;
+        self->tlab_end = (char*)found + len;
+        gc_stats.tlab_refills++;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Bump allocate from the thread's buffer.  Suspension is disabled,
+   so GC never sees a half updated buffer */
+static void *tlabAlloc(Thread *self, int n) {
+    char *ret_addr = NULL;
+
+    fastDisableSuspend(self);
+
+    if(self->tlab_end - self->tlab_top >= n) {
+        HEADER(self->tlab_top) = n | ALLOC_BIT;
+        ret_addr = self->tlab_top + HEADER_SIZE;
+        self->tlab_top += n;
+    }
+
+    fastEnableSuspend(self);
+    return ret_addr;
+}
+
 void *gcMalloc(int len) {
     /* The state determines what action to take in the event of
        allocation failure.  The states go up in seriousness,
@@ -1832,15 +1963,34 @@ void *gcMalloc(int len) {
     /* See comment below */
     char *ret_addr;
 
+    self = threadSelf();
+
+    /* Small objects are allocated from the thread's allocation
+       buffer without taking the heap lock */
+    if(n <= TLAB_MAX_OBJECT && (ret_addr = tlabAlloc(self, n)) != NULL)
+        return ret_addr;
+
     /* Grab the heap lock, hopefully without having to
        wait for it to avoid disabling suspension */
-    self = threadSelf();
     if(!tryLockVMLock(heap_lock, self)) {
         disableSuspend(self);
         lockVMLock(heap_lock, self);
         enableSuspend(self);
     }
 
+    /* The buffer is used up - replace it by a new one.  The heap
+       lock excludes GC, so the buffer can be changed here */
+    if(n <= TLAB_MAX_OBJECT && !tlab_exhausted) {
+        retireTLAB(self);
+
+        if(refillTLAB(self)) {
+            ret_addr = tlabAlloc(self, n);
+            unlockVMLock(heap_lock, self);
+            return ret_addr;
+        }
+        tlab_exhausted = TRUE;
+    }
+
     /* Scan freelist looking for a chunk big enough to
        satisfy allocation request */
 
@@ -1983,6 +2133,7 @@ got_it:
 #endif
 
     heapfree -= n;
+    gc_stats.allocated += n;
 
     /* Mark found chunk as allocated */
     found->header = n | ALLOC_BIT;
@@ -2196,6 +2347,32 @@ unsigned long maxHeapMem() {
     return heapmax-heapbase;
 }
 
+/* Snapshot of GC statistics.  Allocated bytes do not count the
+   objects in buffers which have not been retired yet */
+void getGCStats(GCStats *stats) {
+    Thread *self = threadSelf();
+
+    disableSuspend(self);
+    lockVMLock(heap_lock, self);
+    *stats = gc_stats;
+    unlockVMLock(heap_lock, self);
+    enableSuspend(self);
+}
+
+void printGCStats() {
+    GCStats stats;
+
+    if(!verbosegc)
+        return;
+
+    getGCStats(&stats);
+    jam_printf("<GC: %lld collection(s), total pause %lld us, max pause"
+               " %lld us>\n", stats.collections, stats.total_pause,
+               stats.max_pause);
+    jam_printf("<GC: Allocated %lld bytes, %lld TLAB refill(s)>\n",
+               (long long)stats.allocated, stats.tlab_refills);
+}
+
 
 /* ------ Allocation routines for internal GC lists ------- */
 
@@ -2269,9 +2446,11 @@ void freePendingFrees() {
 
 /* ------ Allocation from system heap ------- */
 
+/* VM data is allocated from the thread heap, blocks can be freed by
+   any thread since the owner heap is recorded in the block */
 void *sysMalloc(int size) {
     int n = size < sizeof(void*) ? sizeof(void*) : size;
-    void *mem = malloc(n);
+    void *mem = _hx_heap_malloc(n);
 
     if(mem == NULL) {
         jam_fprintf(stderr, "Malloc failed - aborting VM...\n");
@@ -2287,7 +2466,7 @@ void *sysRealloc(void *addr, int size) {
 	void* mem;
 
 	free(addr);
-	mem = malloc(size);
+	mem = _hx_heap_malloc(size);
 
     if(mem == NULL) {
         jam_fprintf(stderr, "Realloc failed - aborting VM...\n");
@@ -0,0 +1,147 @@
+/*
+ * Bytecode microbenchmarks for the JVM's method invocation paths.
+ *
+ * Compile with any Java compiler targeting the class library's level,
+ * copy the classes to the target and run:
+ *
+ *     jamvm -Xcodestats InvokeBench [iterations]
+ *
+ * Each benchmark prints its time and calls per millisecond.  The
+ * interface benchmarks exercise call sites with one (monomorphic),
+ * three (polymorphic) and eight (megamorphic) receiver classes,
+ * matching the states of the invokeinterface inline cache.
+ */
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+public class InvokeBench {
+    interface Shape {
+        int area();
+    }
+
+    static abstract class Base implements Shape {
+        public int area() { return 1; }
+        int side() { return 1; }
+    }
+
+    static class S0 extends Base { public int area() { return 2; } int side() { return 2; } }
+    static class S1 extends Base { public int area() { return 3; } int side() { return 3; } }
+    static class S2 extends Base { public int area() { return 4; } int side() { return 4; } }
+    static class S3 extends Base { public int area() { return 5; } int side() { return 5; } }
+    static class S4 extends Base { public int area() { return 6; } int side() { return 6; } }
+    static class S5 extends Base { public int area() { return 7; } int side() { return 7; } }
+    static class S6 extends Base { public int area() { return 8; } int side() { return 8; } }
+    static class S7 extends Base { public int area() { return 9; } int side() { return 9; } }
+
+    static Shape[] shapes(int kinds) {
+        Shape[] all = { new S0(), new S1(), new S2(), new S3(),
+                        new S4(), new S5(), new S6(), new S7() };
+        Shape[] shapes = new Shape[64];
+
+        for(int i = 0; i < shapes.length; i++)
+            shapes[i] = all[i % kinds];
+
+        return shapes;
+    }
+
+    static int sink;
+
+    static int interfaceCalls(Shape[] shapes, int iterations) {
+        int sum = 0;
+
+        for(int i = 0; i < iterations; i++)
+            sum += shapes[i & 63].area();
+
+        return sum;
+    }
+
+    static int virtualCalls(Shape[] shapes, int iterations) {
+        int sum = 0;
+
+        for(int i = 0; i < iterations; i++)
+            sum += ((Base)shapes[i & 63]).side();
+
+        return sum;
+    }
+
+    static int staticCall(int i) {
+        return i & 1;
+    }
+
+    static int staticCalls(int iterations) {
+        int sum = 0;
+
+        for(int i = 0; i < iterations; i++)
+            sum += staticCall(i);
+
+        return sum;
+    }
+
+    static int collectionCalls(int iterations) {
+        List list = new ArrayList();
+        Map map = new HashMap();
+        int sum = 0;
+
+        for(int i = 0; i < 64; i++) {
+            Integer key = new Integer(i);
+            list.add(key);
+            map.put(key, key);
+        }
+
+        for(int i = 0; i < iterations / 64; i++)
+            for(int j = 0; j < list.size(); j++)
+                sum += ((Integer)map.get(list.get(j))).intValue();
+
+        return sum;
+    }
+
+    static void report(String name, long start, int calls) {
+        long ms = System.currentTimeMillis() - start;
+
+        System.out.println(name + ": " + ms + " ms, " +
+                           (ms > 0 ? calls / ms : calls) + " calls/ms");
+    }
+
+    public static void main(String[] args) {
+        int iterations = args.length > 0 ? Integer.parseInt(args[0])
+                                         : 10000000;
+        Shape[] mono = shapes(1);
+        Shape[] poly = shapes(3);
+        Shape[] mega = shapes(8);
+        long start;
+
+        /* Warm up, so that all sites are quickened and inlined */
+        sink += interfaceCalls(mono, 100000) + interfaceCalls(poly, 100000)
+                + interfaceCalls(mega, 100000) + virtualCalls(poly, 100000)
+                + staticCalls(100000) + collectionCalls(100000);
+
+        start = System.currentTimeMillis();
+        sink += interfaceCalls(mono, iterations);
+        report("invokeinterface monomorphic", start, iterations);
+
+        start = System.currentTimeMillis();
+        sink += interfaceCalls(poly, iterations);
+        report("invokeinterface polymorphic", start, iterations);
+
+        start = System.currentTimeMillis();
+        sink += interfaceCalls(mega, iterations);
+        report("invokeinterface megamorphic", start, iterations);
+
+        start = System.currentTimeMillis();
+        sink += virtualCalls(poly, iterations);
+        report("invokevirtual", start, iterations);
+
+        start = System.currentTimeMillis();
+        sink += staticCalls(iterations);
+        report("invokestatic", start, iterations);
+
+        start = System.currentTimeMillis();
+        sink += collectionCalls(iterations);
+        report("collections", start, (iterations / 64) * 64 * 3);
+
+        System.out.println("checksum " + sink);
+    }
+}
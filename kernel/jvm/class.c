@@ -1708,6 +1708,9 @@ void freeClassData(Class *class) {
     ClassBlock *cb = CLASS_CB(class);
     int i;
 
+    /* Inline caches may hold the class */
+    invalidateInvokeCaches();
+
     if(IS_ARRAY(cb)) {
         gcPendingFree(cb->interfaces);
         return;
@@ -1731,6 +1734,8 @@ void freeClassData(Class *class) {
     for(i = 0; i < cb->methods_count; i++) {
         MethodBlock *mb = &cb->methods[i];
 
+        freeInvokeCaches(mb);
+
 #ifdef DIRECT
         if(!((uintptr_t)mb->code & 0x3)) {
 #ifdef INLINING
@@ -27,6 +27,195 @@
 #include <io.h>
 
 #include "jam.h"
+#include "thread.h"
+
+#include <string.h>
+
+/* Polymorphic inline caches of invokeinterface sites.  They're used
+   by both the direct and the indirect interpreter, so live outside
+   of the DIRECT code */
+
+/* Lock protecting the methods' inline cache lists and site tables */
+static VMLock invoke_cache_lock;
+
+/* Bumped when a class is unloaded.  A cache filled in an earlier
+   epoch may hold the address of the unloaded class, which can be
+   reused by a new class, so it's treated as empty */
+volatile unsigned int invoke_cache_epoch;
+
+void initialiseInvokeCaches() {
+    initVMLock(invoke_cache_lock);
+}
+
+static void lockInvokeCaches(Thread *self) {
+    if(!tryLockVMLock(invoke_cache_lock, self)) {
+        disableSuspend(self);
+        lockVMLock(invoke_cache_lock, self);
+        enableSuspend(self);
+    }
+}
+
+/* Create an empty inline cache, the lock must be held */
+static InvokeCache *allocInvokeCache(MethodBlock *mb, MethodBlock *imb) {
+    InvokeCache *cache = sysMalloc(sizeof(InvokeCache));
+
+    cache->imb = imb;
+    cache->entries = 0;
+    cache->imethod_hint = 0;
+    cache->epoch = invoke_cache_epoch;
+
+    cache->next = mb->invoke_caches;
+    mb->invoke_caches = cache;
+
+    return cache;
+}
+
+/* Create an empty inline cache for an invokeinterface site
+   in mb, calling the interface method imb */
+InvokeCache *newInvokeCache(MethodBlock *mb, MethodBlock *imb) {
+    Thread *self = threadSelf();
+    InvokeCache *cache;
+
+    lockInvokeCaches(self);
+    cache = allocInvokeCache(mb, imb);
+    unlockVMLock(invoke_cache_lock, self);
+
+    return cache;
+}
+
+/* Replace the site's cache old, held in slot, by a copy with the
+   receiver class added.  A cache of an earlier epoch is copied as
+   empty.  If the cache is full the site is megamorphic, and it's
+   kept */
+void extendInvokeCache(MethodBlock *mb, InvokeCache *volatile *slot,
+                       InvokeCache *old, Class *class,
+                       MethodBlock *target) {
+    Thread *self = threadSelf();
+    InvokeCache *cache;
+#ifndef DIRECT
+    InvokeCache **prev;
+#endif
+
+    if(old->epoch == invoke_cache_epoch &&
+                     old->entries == INVOKE_CACHE_SIZE)
+        return;
+
+    cache = sysMalloc(sizeof(InvokeCache));
+    memcpy(cache, old, sizeof(InvokeCache));
+
+    if(cache->epoch != invoke_cache_epoch) {
+        cache->epoch = invoke_cache_epoch;
+        cache->entries = 0;
+    }
+
+    cache->class[cache->entries] = class;
+    cache->target[cache->entries++] = target;
+
+    lockInvokeCaches(self);
+
+    /* Another thread has already replaced the cache */
+    if(*slot != old) {
+        unlockVMLock(invoke_cache_lock, self);
+        sysFree(cache);
+        return;
+    }
+
+#ifdef DIRECT
+    /* Inlined copies of the instruction may still refer to the old
+       cache, so it's kept until the method is freed */
+    cache->next = mb->invoke_caches;
+    mb->invoke_caches = cache;
+#else
+    for(prev = &mb->invoke_caches; *prev != old; prev = &(*prev)->next);
+    *prev = cache;
+#endif
+
+    /* The slot is a single word, so the replacement is atomic */
+    *slot = cache;
+
+    unlockVMLock(invoke_cache_lock, self);
+
+#ifndef DIRECT
+    /* Readers may still be using the old cache */
+    gcPendingFree(old);
+#endif
+}
+
+#ifndef DIRECT
+/* The indirect interpreter has no room in the bytecode for a
+   pointer, so the site's slot is kept in a per-method table, and
+   the invokeinterface instruction at pc is quickened with the slot
+   index in its last two bytes.  Slots are never moved, the table is
+   replaced when it grows.  Threads resolving the same instruction
+   are serialized, so the index is written by one of them only */
+void quickenInvokeInterface(MethodBlock *mb, MethodBlock *imb,
+                            unsigned char *pc) {
+    InvokeCache *volatile **sites;
+    InvokeCache *volatile **old_sites;
+    InvokeCache *volatile *slot;
+    Thread *self = threadSelf();
+    int index;
+
+    lockInvokeCaches(self);
+
+    if(pc[0] != OPC_INVOKEINTERFACE) {
+        unlockVMLock(invoke_cache_lock, self);
+        return;
+    }
+
+    slot = sysMalloc(sizeof(InvokeCache*));
+    *slot = allocInvokeCache(mb, imb);
+
+    index = mb->invoke_sites_count;
+    sites = sysMalloc((index + 1) * sizeof(*sites));
+    memcpy(sites, mb->invoke_sites, index * sizeof(*sites));
+    sites[index] = slot;
+
+    old_sites = mb->invoke_sites;
+    mb->invoke_sites = sites;
+    mb->invoke_sites_count = index + 1;
+
+    pc[3] = index >> 8;
+    pc[4] = index & 0xff;
+    MBARRIER();
+    pc[0] = OPC_INVOKEINTERFACE_QUICK;
+
+    unlockVMLock(invoke_cache_lock, self);
+
+    /* Readers may still be using the old table */
+    if(old_sites != NULL)
+        gcPendingFree(old_sites);
+}
+#endif
+
+/* Called when a class is unloaded, within GC.  No thread is running
+   in the interpreter, so the next lookup of every cache sees the new
+   epoch */
+void invalidateInvokeCaches() {
+    invoke_cache_epoch++;
+}
+
+/* Called when the method's class is freed */
+void freeInvokeCaches(MethodBlock *mb) {
+    InvokeCache *cache = mb->invoke_caches;
+
+    while(cache != NULL) {
+        InvokeCache *next = cache->next;
+        gcPendingFree(cache);
+        cache = next;
+    }
+
+#ifndef DIRECT
+    if(mb->invoke_sites != NULL) {
+        int i;
+
+        for(i = 0; i < mb->invoke_sites_count; i++)
+            gcPendingFree((void*)mb->invoke_sites[i]);
+
+        gcPendingFree((void*)mb->invoke_sites);
+    }
+#endif
+}
 
 #ifdef DIRECT
 #include <stdio.h>
@@ -284,7 +284,7 @@ opc##x##_##y##_##z:
 #define INV_QUICK_ARGS(pc)       READ_U1_OP(pc + 1)
 #define INV_QUICK_IDX(pc)        READ_U1_OP(pc)
 #define INV_INTF_IDX(pc)         DOUBLE_INDEX(pc)
-#define INV_INTF_CACHE(pc)       READ_U1_OP(pc + 3)
+#define INV_INTF_SLOT(pc)        mb->invoke_sites[READ_U2_OP(pc + 2)]
 #define MULTI_ARRAY_DIM(pc)      READ_U1_OP(pc + 2)
 #define GETFIELD_THIS_OFFSET(pc) READ_U1_OP(pc + 1)
 #define RESOLVED_CONSTANT(pc)    CP_INFO(cp, SINGLE_INDEX(pc))
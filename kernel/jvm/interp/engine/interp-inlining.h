@@ -408,8 +408,7 @@ branch_##level##_##type:                        \
 #define IINC_DELTA(pc)           pc->operand.ii.i2
 #define INV_QUICK_ARGS(pc)       pc->operand.uu.u1
 #define INV_QUICK_IDX(pc)        pc->operand.uu.u2
-#define INV_INTF_IDX(pc)         pc->operand.uu.u1
-#define INV_INTF_CACHE(pc)       pc->operand.uu.u2
+#define INV_INTF_SLOT(pc)        ((InvokeCache *volatile *)&pc->operand.pntr)
 #define MULTI_ARRAY_DIM(pc)      pc->operand.uui.u2
 #define GETFIELD_THIS_OFFSET(pc) pc->operand.i
 #define RESOLVED_CONSTANT(pc)    pc->operand.u
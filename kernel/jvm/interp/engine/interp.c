@@ -1531,8 +1531,7 @@ uintptr_t *executeJava() {
             goto throwException;
 
         if(CLASS_CB(new_mb->class)->access_flags & ACC_INTERFACE) {
-            operand.uu.u1 = idx;
-            operand.uu.u2 = 0;
+            operand.pntr = newInvokeCache(mb, new_mb);
             OPCODE_REWRITE(OPC_INVOKEINTERFACE_QUICK, cache, operand);
         } else {
             operand.uu.u1 = new_mb->args_count;
@@ -1881,7 +1880,7 @@ uintptr_t *executeJava() {
             goto throwException;
 
         if(CLASS_CB(new_mb->class)->access_flags & ACC_INTERFACE)
-            OPCODE_REWRITE(OPC_INVOKEINTERFACE_QUICK);
+            quickenInvokeInterface(mb, new_mb, pc);
         else {
             pc[3] = pc[4] = OPC_NOP;
             OPCODE_REWRITE(OPC_INVOKEVIRTUAL);
@@ -2063,32 +2062,51 @@ uintptr_t *executeJava() {
     })
 
     DEF_OPC_210(OPC_INVOKEINTERFACE_QUICK, {
-        int mtbl_idx;
+        InvokeCache *volatile *slot = INV_INTF_SLOT(pc);
+        InvokeCache *ic = *slot;
+        MethodBlock *imb = ic->imb;
+        Class *new_class;
         ClassBlock *cb;
-        int cache = INV_INTF_CACHE(pc);
+        int cache;
+        int i;
 
-        new_mb = (MethodBlock *)CP_INFO(cp, INV_INTF_IDX(pc));
-        arg1 = ostack - new_mb->args_count;
+        arg1 = ostack - imb->args_count;
 
         NULL_POINTER_CHECK(*arg1);
 
-        cb = CLASS_CB((*(Object **)arg1)->class);
+        new_class = (*(Object **)arg1)->class;
+
+        /* Inline cache hit - the receiver class has been seen here,
+           and no class has been unloaded since */
+        if(ic->epoch == invoke_cache_epoch)
+            for(i = 0; i < ic->entries; i++)
+                if(ic->class[i] == new_class) {
+                    new_mb = ic->target[i];
+                    goto invokeMethod;
+                }
+
+        cb = CLASS_CB(new_class);
+        cache = ic->imethod_hint;
 
         if(cache >= cb->imethod_table_size ||
-                  new_mb->class != cb->imethod_table[cache].interface) {
+                  imb->class != cb->imethod_table[cache].interface) {
             for(cache = 0; cache < cb->imethod_table_size &&
-                           new_mb->class != cb->imethod_table[cache].interface;
+                           imb->class != cb->imethod_table[cache].interface;
                 cache++);
 
             if(cache == cb->imethod_table_size)
                 THROW_EXCEPTION(java_lang_IncompatibleClassChangeError,
                                  "unimplemented interface");
 
-            INV_INTF_CACHE(pc) = cache;
+            ic->imethod_hint = cache;
         }
 
-        mtbl_idx = cb->imethod_table[cache].offsets[new_mb->method_table_index];
-        new_mb = cb->method_table[mtbl_idx];
+        new_mb = cb->method_table[cb->imethod_table[cache].
+                                      offsets[imb->method_table_index]];
+
+        /* Install a cache extended by the receiver class */
+        if(ic->epoch != invoke_cache_epoch || ic->entries < INVOKE_CACHE_SIZE)
+            extendInvokeCache(mb, slot, ic, new_class, new_mb);
 
         goto invokeMethod;
     })
@@ -2269,6 +2287,11 @@ invokeMethod:
     } else {
         PREPARE_MB(new_mb);
 
+#ifdef INLINING
+        /* Call count profile, consulted when inlining blocks */
+        new_mb->invoke_count++;
+#endif
+
         frame = new_frame;
         mb = new_mb;
         lvars = new_frame->lvars;
@@ -2371,6 +2394,7 @@ throwException:
 
 #ifndef executeJava
 void initialiseInterpreter(InitArgs *args) {
+    initialiseInvokeCaches();
 #ifdef DIRECT
     initialiseDirect(args);
 #endif
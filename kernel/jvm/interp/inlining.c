@@ -1047,6 +1047,17 @@ void checkInliningQuickenedInstruction(Instruction *pc, MethodBlock *mb) {
     }
 }
 
+/* Blocks within a method which has been invoked often are inlined
+   at a quarter of the profile threshold.  Most blocks of a hot method
+   have already been executed and quickened, so there is little to
+   gain from waiting for the surrounding blocks */
+static int blockThreshold(MethodBlock *mb) {
+    if(mb->invoke_count >= profile_threshold)
+        return profile_threshold >> 2;
+
+    return profile_threshold;
+}
+
 /* Search the profile list for the block and inline if the execution
    threshold has been reached.  The profile list is per-method, and
    blocks are added to the head of the list.  Testing shows 70% of
@@ -1066,7 +1077,7 @@ void *inlineProfiledBlock(Instruction *pc, MethodBlock *mb, int force_inlining)
         last = info, info = info->next);
 
     if(info != NULL && (force_inlining ||
-                        info->profile_count++ >= profile_threshold)) {
+                        info->profile_count++ >= blockThreshold(mb))) {
 
         inlineBlock(mb, info->block, self);
         return NULL;
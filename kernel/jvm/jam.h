@@ -523,12 +523,36 @@ struct methodblock {
    LineNoTableEntry *line_no_table;
    int method_table_index;
    MethodAnnotationData *annotations;
+   struct invoke_cache *invoke_caches;
+#ifndef DIRECT
+   struct invoke_cache *volatile **invoke_sites;
+   int invoke_sites_count;
+#endif
 #ifdef INLINING
    QuickPrepareInfo *quick_prepare_info;
    ProfileInfo *profile_info;
+   int invoke_count;
 #endif
 };
 
+/* Polymorphic inline cache of an invokeinterface call site.  Apart
+   from the interface table hint, an installed cache is never changed -
+   a miss installs a copy extended by the new receiver class.  The
+   caches installed at sites within a method are chained from the
+   method, and are freed with it.  A cache is only valid in the epoch
+   it was filled in, the epoch changes when a class is unloaded */
+#define INVOKE_CACHE_SIZE 4
+
+typedef struct invoke_cache {
+    MethodBlock *imb;
+    int entries;
+    int imethod_hint;
+    unsigned int epoch;
+    Class *class[INVOKE_CACHE_SIZE];
+    MethodBlock *target[INVOKE_CACHE_SIZE];
+    struct invoke_cache *next;
+} InvokeCache;
+
 typedef struct fieldblock {
    Class *class;
    char *name;
@@ -775,6 +799,18 @@ extern unsigned long freeHeapMem();
 extern unsigned long totalHeapMem();
 extern unsigned long maxHeapMem();
 
+/* Cumulative GC statistics, times are in microseconds */
+typedef struct gc_stats {
+    long long collections;
+    long long total_pause;
+    long long max_pause;
+    long long tlab_refills;
+    unsigned long long allocated;
+} GCStats;
+
+extern void getGCStats(GCStats *stats);
+extern void printGCStats();
+
 extern void *sysMalloc(int n);
 extern void sysFree(void *ptr);
 extern void *sysRealloc(void *ptr, int n);
@@ -1009,6 +1045,7 @@ extern void mainThreadWaitToExitVM();
 extern void uncaughtException();
 extern void exitVM(int status);
 extern void scanThreads();
+extern void retireThreadsTLAB();
 
 /* Monitors */
 
@@ -1067,6 +1104,21 @@ extern void jamvm_exit(int status);
 //#define jam_printf(fmt, ...) jam_fprintf(stdout, fmt, ## __VA_ARGS__)
 #define jam_printf _hx_printf
 
+/* direct */
+
+extern volatile unsigned int invoke_cache_epoch;
+extern void initialiseInvokeCaches();
+extern InvokeCache *newInvokeCache(MethodBlock *mb, MethodBlock *imb);
+extern void extendInvokeCache(MethodBlock *mb, InvokeCache *volatile *slot,
+                              InvokeCache *old, Class *class,
+                              MethodBlock *target);
+#ifndef DIRECT
+extern void quickenInvokeInterface(MethodBlock *mb, MethodBlock *imb,
+                                   unsigned char *pc);
+#endif
+extern void invalidateInvokeCaches();
+extern void freeInvokeCaches(MethodBlock *mb);
+
 /* inlining */
 
 extern void freeMethodInlinedInfo(MethodBlock *mb);
@@ -26,6 +26,7 @@
 #include "jam.h"
 
 void shutdownVM(int status) {
+    printGCStats();
     shutdownInterpreter();
     jamvm_exit(status);
 }
@@ -506,6 +506,9 @@ void initThread(Thread *thread, char is_daemon, void *stack_base) {
     /* Record the thread's stack base */
     thread->stack_base = stack_base;
 
+    /* No allocation buffer until the first allocation */
+    thread->tlab_start = thread->tlab_top = thread->tlab_end = NULL;
+
     /* Grab thread list lock.  This also stops suspension */
     pthread_mutex_lock(&lock);
 
@@ -611,6 +614,8 @@ void uncaughtException() {
     printException();
 }
 
+extern void freeThreadTLAB(Thread *thread);
+
 void detachThread(Thread *thread) {
     ExecEnv *ee = thread->ee;
     Object *jThread = ee->thread;
@@ -638,6 +643,9 @@ void detachThread(Thread *thread) {
     objectNotifyAll(vmthread);
     objectUnlock(vmthread);
 
+    /* Give back the unused part of the thread's allocation buffer */
+    freeThreadTLAB(thread);
+
     /* Disable suspend to protect lock operation */
     disableSuspend(thread);
 
@@ -1126,6 +1134,17 @@ void scanThreads() {
     pthread_mutex_unlock(&lock);
 }
 
+extern void retireTLAB(Thread *thread);
+
+void retireThreadsTLAB() {
+    Thread *thread;
+
+    pthread_mutex_lock(&lock);
+    for(thread = &main_thread; thread != NULL; thread = thread->next)
+        retireTLAB(thread);
+    pthread_mutex_unlock(&lock);
+}
+
 int systemIdle(Thread *self) {
     Thread *thread;
 
@@ -93,6 +93,9 @@ struct thread {
     Thread *prev, *next;
     unsigned int wait_id;
     unsigned int notify_id;
+    char *tlab_start;
+    char *tlab_top;
+    char *tlab_end;
 };
 
 extern Thread *threadSelf();
@@ -30,15 +30,25 @@
 //Enabled only the macro __CFG_SYS_LOGCAT is defined.
 #ifdef __CFG_SYS_LOGCAT
 
-static void __Log(__DEBUG_MANAGER *pThis, char *tag, char *msg)
+//
+// Build a log message and add it to the log ring,the message is
+// released by Logcat after it's printed.
+//
+static void __PostLog(__RING_BUFFER *pRing, char *tag, char *msg)
 {
-	__DEBUG_MANAGER			*pDebugManager		= pThis;
 	__LOG_MESSAGE			*pMsg				= NULL;
 	__KERNEL_THREAD_OBJECT	*lpCurrentThread	= NULL;
-	int						dwFlags				= 0;
-	int						Result				= -1;
+	DWORD					dwFlags				= 0;
 
+	if (NULL == pRing)  // Not initialized yet.
+	{
+		return;
+	}
 	pMsg = (__LOG_MESSAGE *)KMemAlloc(sizeof(__LOG_MESSAGE),KMEM_SIZE_TYPE_ANY);
+	if (NULL == pMsg)
+	{
+		return;
+	}
 
 	//
 	// Set to default now
@@ -49,11 +59,6 @@ static void __Log(__DEBUG_MANAGER *pThis, char *tag, char *msg)
 	pMsg->pid = 0;
 	pMsg->time = 0;
 
-	//
-	//*****XXX*******
-	// FIXME
-	//
-
 	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
 	lpCurrentThread = KernelThreadManager.lpCurrentKernelThread;
 	StrCpy(lpCurrentThread->KernelThreadName,pMsg->name);
@@ -64,283 +69,162 @@ static void __Log(__DEBUG_MANAGER *pThis, char *tag, char *msg)
 	StrCpy(tag, pMsg->tag);
 
 	//
-	// Get the authority to visit the bufferqueue
+	// No lock is needed,the ring accepts multiple producers.
+	// Drop the message if the ring is full.
 	//
-	Result = pDebugManager->pMutexForBufferQueue->WaitForThisObject((__COMMON_OBJECT*)DebugManager.pMutexForBufferQueue);
-	if (Result == OBJECT_WAIT_RESOURCE)
+	if (!pRing->AddElement((__COMMON_OBJECT*)pRing, (DWORD)pMsg))
 	{
-		pDebugManager->pBufferQueue->Enqueue(
-			pDebugManager->pBufferQueue,
-			pMsg);
-		pDebugManager->pMutexForBufferQueue->ReleaseMutex((__COMMON_OBJECT*)DebugManager.pMutexForBufferQueue);
+		KMemFree(pMsg, KMEM_SIZE_TYPE_ANY, 0);
 	}
+	return;
+}
 
-	KMemFree(pMsg, KMEM_SIZE_TYPE_ANY, 0);
+static void __Log(__DEBUG_MANAGER *pThis, char *tag, char *msg)
+{
+	__PostLog(pThis->pLogRing, tag, msg);
+}
 
-	return;
+static void __Logk(__DEBUG_MANAGER *pThis, char *tag, char *msg)
+{
+	__PostLog(pThis->pKRNLLogRing, tag, msg);
 }
 
+//
+// Get one log message and format it into buf,kernel messages go first.
+// It blocks until a message is available,buf is left untouched if the
+// debug manager is not initialized.
+//
 static void Logcat(__DEBUG_MANAGER *pThis, char *buf, int len)
 {
 	__DEBUG_MANAGER *pDebugManager	=	pThis;
-
-	__LOG_MESSAGE	*pMsg			=	NULL;
+	__RING_BUFFER	*pKRNLLogRing	=	pDebugManager->pKRNLLogRing;
+	__RING_BUFFER	*pLogRing		=	pDebugManager->pLogRing;
 	__LOG_MESSAGE	*p				=	NULL;
-	int				Result			=	-1;
-
-	pMsg = (__LOG_MESSAGE *)KMemAlloc(sizeof(__LOG_MESSAGE),KMEM_SIZE_TYPE_ANY);
 
-	//
-	// Get the authority to visit the kernel bufferqueue
-	//
-	Result = DebugManager.pMutexForKRNLBufferQueue->WaitForThisObject((__COMMON_OBJECT*)DebugManager.pMutexForKRNLBufferQueue);
-	if (Result == OBJECT_WAIT_RESOURCE)
+	if ((NULL == pKRNLLogRing) || (NULL == pLogRing))
 	{
-		p = pDebugManager->pKRNLBufferQueue->Dequeue(pDebugManager->pKRNLBufferQueue);
-		pDebugManager->pMutexForKRNLBufferQueue->ReleaseMutex((__COMMON_OBJECT*)DebugManager.pMutexForKRNLBufferQueue);
+		return;
 	}
-
-	if(p == NULL)
+	while (TRUE)
 	{
+		if (pKRNLLogRing->GetElements((__COMMON_OBJECT*)pKRNLLogRing, (DWORD*)&p, 1, 0))
+		{
+			break;
+		}
+		if (pLogRing->GetElements((__COMMON_OBJECT*)pLogRing, (DWORD*)&p, 1, 0))
+		{
+			break;
+		}
 		//
-		// Get the authority to visit the user bufferqueue
+		// Both rings are empty,arm them and wait,the event is set by
+		// the first message comes after arming.
 		//
-		Result = DebugManager.pMutexForBufferQueue->WaitForThisObject((__COMMON_OBJECT*)DebugManager.pMutexForBufferQueue);
-		if (Result == OBJECT_WAIT_RESOURCE)
+		pDebugManager->pLogEvent->ResetEvent((__COMMON_OBJECT*)pDebugManager->pLogEvent);
+		if (pKRNLLogRing->ArmWakeup((__COMMON_OBJECT*)pKRNLLogRing) &&
+			pLogRing->ArmWakeup((__COMMON_OBJECT*)pLogRing))
 		{
-			p = pDebugManager->pBufferQueue->Dequeue(pDebugManager->pBufferQueue);
-			pDebugManager->pMutexForBufferQueue->ReleaseMutex((__COMMON_OBJECT*)DebugManager.pMutexForBufferQueue);
+			pDebugManager->pLogEvent->WaitForThisObject((__COMMON_OBJECT*)pDebugManager->pLogEvent);
 		}
 	}
 
-	if(p != NULL)
-	{
-		pMsg->pid = p->pid;
-		pMsg->tid = p->tid;
-		pMsg->time = p->time;
-		StrCpy(p->tag, pMsg->tag);
-		StrCpy(p->name, pMsg->name);
-		StrCpy(p->msg, pMsg->msg);
-		_hx_sprintf(buf, "tag:%s name:%s time:%d pid:%d tid:%d msg:%s", 
-			pMsg->tag, pMsg->name, pMsg->time, 
-			pMsg->pid, pMsg->tid, pMsg->msg);	
-	}
-
-	KMemFree(pMsg, KMEM_SIZE_TYPE_ANY, 0);
-
+	_hx_sprintf(buf, "tag:%s name:%s time:%d pid:%d tid:%d msg:%s", 
+		p->tag, p->name, p->time, 
+		p->pid, p->tid, p->msg);
+	KMemFree(p, KMEM_SIZE_TYPE_ANY, 0);
 	return;	
 }
 
-static void __Logk(__DEBUG_MANAGER *pThis, char *tag, char *msg)
-{
-	__DEBUG_MANAGER			*pDebugManager		= pThis;
-	__LOG_MESSAGE			*pMsg				= NULL;
-	__KERNEL_THREAD_OBJECT	*lpCurrentThread	= NULL;
-
-	int						Result				= -1;
-	int						dwFlags				= 0;
-
-	pMsg = (__LOG_MESSAGE *)KMemAlloc(sizeof(__LOG_MESSAGE),KMEM_SIZE_TYPE_ANY);
-
-	//
-	//Set to default now
-	//
-	pMsg->code = 0;
-	pMsg->format = 0;
-	pMsg->len = 0;
-	pMsg->pid = 0;
-	pMsg->time = 0;
-
-	//
-	//*****XXX*******
-	// FIXME
-	//
-	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
-	lpCurrentThread = KernelThreadManager.lpCurrentKernelThread;
-	StrCpy(lpCurrentThread->KernelThreadName,pMsg->name);
-	pMsg->tid = lpCurrentThread->dwThreadID;
-	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-
-	StrCpy(msg, pMsg->msg);
-	StrCpy(tag, pMsg->tag);
-
-	//
-	//Get the authority to visit the bufferqueue
-	//
-
-	Result = pDebugManager->pMutexForKRNLBufferQueue->WaitForThisObject((__COMMON_OBJECT*)DebugManager.pMutexForKRNLBufferQueue);
-	if (Result == OBJECT_WAIT_RESOURCE)
-	{
-		pDebugManager->pKRNLBufferQueue->Enqueue(
-			pDebugManager->pKRNLBufferQueue,
-			pMsg);
-		pDebugManager->pMutexForKRNLBufferQueue->ReleaseMutex((__COMMON_OBJECT*)DebugManager.pMutexForKRNLBufferQueue);
-	}
-
-	KMemFree(pMsg, KMEM_SIZE_TYPE_ANY, 0);
-
-	return;
-}
-
-
-static int Enqueue(__BUFFER_QUEUE *pThis, __LOG_MESSAGE *pMsg)
-{
-
-	__BUFFER_QUEUE	*pBufferQueue	=	pThis;
-	int				saved			=	pBufferQueue->tail;
-	DWORD			dwFlags			=	0;
-
-	if(pBufferQueue->len >= 256) return -1;
-
-	pBufferQueue->tail = (pBufferQueue->tail + 1) % 256;
-	StrCpy(pMsg->name,pBufferQueue->BufferQueue[pBufferQueue->tail].name);
-	StrCpy(pMsg->tag, pBufferQueue->BufferQueue[pBufferQueue->tail].tag);
-	StrCpy(pMsg->msg, pBufferQueue->BufferQueue[pBufferQueue->tail].msg);
-	pBufferQueue->BufferQueue[pBufferQueue->tail].tid = pMsg->tid;
-	pBufferQueue->len++;
-
-	return saved;
-}
-
-static __LOG_MESSAGE *Dequeue(__BUFFER_QUEUE *pThis)
+//
+// Wakeup routine of log rings,set the log event both rings share.
+//
+static BOOL __LogRingWakeup(LPVOID lpWakeupParam)
 {
-	__BUFFER_QUEUE	*pBufferQueue	= pThis;
-	int				saved			= pBufferQueue->head;
+	__EVENT *pLogEvent = (__EVENT*)lpWakeupParam;
 
-	if(pBufferQueue->len <= 0) return NULL;
-
-	pBufferQueue->head = (pBufferQueue->head + 1) % 256;
-	pBufferQueue->len--;
-
-	return &pBufferQueue->BufferQueue[saved];
+	pLogEvent->SetEvent((__COMMON_OBJECT*)pLogEvent);
+	return TRUE;
 }
 
 static void Initialize(__DEBUG_MANAGER *pThis)
 {
-	__DEBUG_MANAGER	*pDebugManager				=		pThis;
-	__BUFFER_QUEUE	*pBufferQueue				=		NULL;
-	__BUFFER_QUEUE	*pKRNLBufferQueue			=		NULL;
-	__MUTEX			*pMutexForBufferQueue		=		NULL;
-	__MUTEX			*pMutexForKRNLBufferQueue	=		NULL;
-
-	int	i = 0;
-
-	//
-	//****************KERNEL BUFFERQUEUE*************
-	// Intialize the sync object
-	//
-	pMutexForKRNLBufferQueue = (__MUTEX*)CreateMutex();
-	if (!pMutexForKRNLBufferQueue)return;
-
-	pDebugManager->pMutexForKRNLBufferQueue = pMutexForKRNLBufferQueue;
+	__DEBUG_MANAGER	*pDebugManager	=	pThis;
+	__RING_BUFFER	*pLogRing		=	NULL;
+	__RING_BUFFER	*pKRNLLogRing	=	NULL;
+	__EVENT			*pLogEvent		=	NULL;
 
-	//
-	// Intialize the kernel BufferQueue.
-	//
-	pKRNLBufferQueue = (__BUFFER_QUEUE *)KMemAlloc(sizeof(__BUFFER_QUEUE),KMEM_SIZE_TYPE_ANY);
-	if(!pKRNLBufferQueue)return;
-	for(; i < 256; i++)
-	{
-		pKRNLBufferQueue->BufferQueue[i].code = 0;
-		pKRNLBufferQueue->BufferQueue[i].format = 0;
-		pKRNLBufferQueue->BufferQueue[i].len = 0;
-		pKRNLBufferQueue->BufferQueue[i].time = 0;
-		pKRNLBufferQueue->BufferQueue[i].pid = 0;// get pid
-		pKRNLBufferQueue->BufferQueue[i].tid = 0;// get tid
-	}
+	pLogEvent = (__EVENT*)CreateEvent(FALSE);
+	if (!pLogEvent)return;
 
 	//
-	// FIXME
+	// Any thread can log,so the rings accept multiple producers.
 	//
-	//pBufferQueue->head = pBufferQueue ->tail = -1;
-	pKRNLBufferQueue->head = pBufferQueue ->tail = 0;
-	pKRNLBufferQueue->len = 0;
+	pKRNLLogRing = (__RING_BUFFER*)CreateRingBuffEx(LOG_RING_LENGTH, RING_BUFFER_FLAG_MPSC);
+	if (!pKRNLLogRing)goto __TERMINAL;
+	pLogRing = (__RING_BUFFER*)CreateRingBuffEx(LOG_RING_LENGTH, RING_BUFFER_FLAG_MPSC);
+	if (!pLogRing)goto __TERMINAL;
 
-	pKRNLBufferQueue->Enqueue = Enqueue;
-	pKRNLBufferQueue->Dequeue = Dequeue;
-
-	pDebugManager->pKRNLBufferQueue = pKRNLBufferQueue;
-
-	//
-	//**************USER BUFFERQUEUE**************
-	// Intialize the sync object
-	//
-	pMutexForBufferQueue = (__MUTEX*)CreateMutex();
-	if (!pMutexForBufferQueue)return;
+	pKRNLLogRing->SetWakeupRoutine((__COMMON_OBJECT*)pKRNLLogRing, __LogRingWakeup, pLogEvent);
+	pLogRing->SetWakeupRoutine((__COMMON_OBJECT*)pLogRing, __LogRingWakeup, pLogEvent);
 
-	pDebugManager->pMutexForBufferQueue = pMutexForBufferQueue;
+	pDebugManager->pLogEvent = pLogEvent;
+	pDebugManager->pKRNLLogRing = pKRNLLogRing;
+	pDebugManager->pLogRing = pLogRing;
+	return;
 
-	//
-	// Intialize the user BufferQueue.
-	//
-	pBufferQueue = (__BUFFER_QUEUE *)KMemAlloc(sizeof(__BUFFER_QUEUE),KMEM_SIZE_TYPE_ANY);
-	if(!pBufferQueue)return;
-	for(; i < 256; i++)
+__TERMINAL:
+	if (pKRNLLogRing)
 	{
-		pBufferQueue->BufferQueue[i].code = 0;
-		pBufferQueue->BufferQueue[i].format = 0;
-		pBufferQueue->BufferQueue[i].len = 0;
-		pBufferQueue->BufferQueue[i].time = 0;
-		pBufferQueue->BufferQueue[i].pid = 0;// get pid
-		pBufferQueue->BufferQueue[i].tid = 0;// get tid
+		DestroyRingBuff((HANDLE)pKRNLLogRing);
 	}
-	//
-	// FIXME
-	//
-	//pBufferQueue->head = pBufferQueue ->tail = -1;
-	pBufferQueue->head = pBufferQueue ->tail = 0;
-	pBufferQueue->len = 0;
-
-	pBufferQueue->Enqueue = Enqueue;
-	pBufferQueue->Dequeue = Dequeue;
-
-	pDebugManager->pBufferQueue = pBufferQueue;
-
+	DestroyEvent((HANDLE)pLogEvent);
 	return;
 }
 
 static void Unintialize(__DEBUG_MANAGER *pThis)
 {
-
 	__DEBUG_MANAGER *DebugManager = pThis;
+	__LOG_MESSAGE	*p			  = NULL;
 
-	// Release the user BufferQueue
-	if(!DebugManager->pBufferQueue)
+	// Release the user log ring and pending messages.
+	if(DebugManager->pLogRing)
 	{
-		KMemFree(DebugManager->pBufferQueue, KMEM_SIZE_TYPE_ANY, sizeof(__BUFFER_QUEUE));
-	}
-
-	// Release the kernel BufferQueue
-	if(!DebugManager->pKRNLBufferQueue)
-	{
-		KMemFree(DebugManager->pKRNLBufferQueue, KMEM_SIZE_TYPE_ANY, sizeof(__BUFFER_QUEUE));
+		while (DebugManager->pLogRing->GetElements((__COMMON_OBJECT*)DebugManager->pLogRing,
+			(DWORD*)&p, 1, 0))
+		{
+			KMemFree(p, KMEM_SIZE_TYPE_ANY, 0);
+		}
+		DestroyRingBuff((HANDLE)DebugManager->pLogRing);
+		DebugManager->pLogRing = NULL;
 	}
 
-	//
-	// Uninitialize the sync object..
-	//
-	if (!DebugManager->pMutexForBufferQueue)
+	// Release the kernel log ring.
+	if(DebugManager->pKRNLLogRing)
 	{
-		ObjectManager.DestroyObject(&ObjectManager,(__COMMON_OBJECT*)DebugManager->pMutexForBufferQueue);
+		while (DebugManager->pKRNLLogRing->GetElements((__COMMON_OBJECT*)DebugManager->pKRNLLogRing,
+			(DWORD*)&p, 1, 0))
+		{
+			KMemFree(p, KMEM_SIZE_TYPE_ANY, 0);
+		}
+		DestroyRingBuff((HANDLE)DebugManager->pKRNLLogRing);
+		DebugManager->pKRNLLogRing = NULL;
 	}
 
-	if (!DebugManager->pMutexForKRNLBufferQueue)
+	if (DebugManager->pLogEvent)
 	{
-		ObjectManager.DestroyObject(&ObjectManager,(__COMMON_OBJECT*)DebugManager->pMutexForKRNLBufferQueue);
+		DestroyEvent((HANDLE)DebugManager->pLogEvent);
+		DebugManager->pLogEvent = NULL;
 	}
-
 	return;
 } 
 
 __DEBUG_MANAGER DebugManager =
 {
 	// For user 
-	NULL,
 	NULL,       //MODIFIED BY GARRY: Please keep same structure in header file's definition,only warning in C will be generated if
 				//align is not enforced and can lead fatal run time error.
 	// For kernel
 	NULL,
-	NULL,
+	NULL,       //pLogEvent.
 
 	__Log,		//Log
 	__Logk,		//Logk
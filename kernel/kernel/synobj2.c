@@ -883,30 +883,10 @@ VOID MailboxUninitialize(__COMMON_OBJECT* pMailboxObj)
 		(__COMMON_OBJECT*)pKernelThread,pKernelThread->dwThreadPriority);
 	pCond->nThreadNum ++;
 
-	//Release the mutex object.
+	//Release the mutex object,and wakeup one kernel thread waiting for it.
 	if(pMutex->dwWaitingNum > 0)
 	{
-		pMutex->dwWaitingNum --;
-		if(0 == pMutex->dwWaitingNum)
-		{
-			pMutex->dwMutexStatus = MUTEX_STATUS_FREE;
-		}
-		else  //Wakeup one kernel thread.
-		{
-			pKernelThread = (__KERNEL_THREAD_OBJECT*)pCond->lpPendingQueue->GetHeaderElement(
-				(__COMMON_OBJECT*)pCond->lpPendingQueue,
-				NULL);
-			if(NULL == pKernelThread)
-			{
-				BUG();
-			}
-			pKernelThread->dwWaitingStatus &= ~OBJECT_WAIT_MASK;
-			pKernelThread->dwWaitingStatus |= OBJECT_WAIT_RESOURCE;
-			pKernelThread->dwThreadStatus   = KERNEL_THREAD_STATUS_READY;
-			KernelThreadManager.AddReadyKernelThread(
-				(__COMMON_OBJECT*)&KernelThreadManager,
-				pKernelThread);
-		}
+		MutexReleaseNoSchedule(pMutex);
 	}
 	else  //This scenario should not exist,since at least current kernel thread is occupying it.
 	{
@@ -981,30 +961,10 @@ __TERMINAL:
 		(__COMMON_OBJECT*)pKernelThread,pKernelThread->dwThreadPriority);
 	pCond->nThreadNum ++;
 
-	//Release the mutex object.
+	//Release the mutex object,and wakeup one kernel thread waiting for it.
 	if(pMutex->dwWaitingNum > 0)
 	{
-		pMutex->dwWaitingNum --;
-		if(0 == pMutex->dwWaitingNum)
-		{
-			pMutex->dwMutexStatus = MUTEX_STATUS_FREE;
-		}
-		else  //Wakeup one kernel thread.
-		{
-			pKernelThread = (__KERNEL_THREAD_OBJECT*)pCond->lpPendingQueue->GetHeaderElement(
-				(__COMMON_OBJECT*)pCond->lpPendingQueue,
-				NULL);
-			if(NULL == pKernelThread)
-			{
-				BUG();
-			}
-			pKernelThread->dwWaitingStatus &= ~OBJECT_WAIT_MASK;
-			pKernelThread->dwWaitingStatus |= OBJECT_WAIT_RESOURCE;
-			pKernelThread->dwThreadStatus   = KERNEL_THREAD_STATUS_READY;
-			KernelThreadManager.AddReadyKernelThread(
-				(__COMMON_OBJECT*)&KernelThreadManager,
-				pKernelThread);
-		}
+		MutexReleaseNoSchedule(pMutex);
 	}
 	else  //This scenario should not exist,since at least current kernel thread is occupying it.
 	{
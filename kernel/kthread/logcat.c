@@ -29,18 +29,23 @@
 
 DWORD LogcatDaemon(LPVOID pData)
 {
-	char buf[256] = {'0'};
+	char buf[256] = {0};
 	while(TRUE)
 	{
+		//Blocks until a log message comes.
+		buf[0] = 0;
 		DebugManager.Logcat(&DebugManager, buf, 0);	
-		if(buf[0] != '0')
+		if(buf[0])
 		{
 			if(Console.bInitialized && Console.bLLInitialized)
 			{
 				Console.PrintLine(buf);
 			}
 		}
-		KernelThreadManager.Sleep((__COMMON_OBJECT *)&KernelThreadManager, 500);
+		else  //Debug manager is not initialized.
+		{
+			KernelThreadManager.Sleep((__COMMON_OBJECT *)&KernelThreadManager, 500);
+		}
 	}
 
 }
@@ -0,0 +1,96 @@
+//***********************************************************************/
+//    Author                    :
+//    Original Date             : Oct,16 2026
+//    Module Name               : dmamem.c
+//    Module Funciton           :
+//                                Memory routines for device DMA,allocates
+//                                physically contiguous buffers and translates
+//                                kernel virtual address to physical address.
+//    Last modified Author      :
+//    Last modified Date        :
+//    Last modified Content     :
+//                                1.
+//    Lines number              :
+//***********************************************************************/
+
+#include <StdAfx.h>
+#include "stddef.h"
+#include "stdlib.h"
+#include "stdint.h"
+
+//Allocate a physically contiguous block for device DMA.
+//The block comes from kernel memory pool which is identity mapped,so it's
+//contiguous in physical memory.Blocks not larger than one page are aligned
+//to the power of 2 above their size,so they never straddle a page boundary.
+//The block is released by _hx_free,use _hx_dma_addr to get the address
+//programmed into device.
+void* _hx_dma_malloc(int size, int align)
+{
+	int page_align = sizeof(unsigned long);
+
+	if (size <= 0)
+	{
+		return NULL;
+	}
+	if (size <= PAGE_SIZE)
+	{
+		while (page_align < size)
+		{
+			page_align <<= 1;
+		}
+	}
+	if (align < page_align)
+	{
+		align = page_align;
+	}
+	return _hx_aligned_malloc(size, align);
+}
+
+//Return the physical address of a kernel virtual address,which can be
+//programmed into device.
+unsigned long _hx_dma_addr(void* ptr)
+{
+#ifdef __CFG_SYS_VMM
+	LPVOID phys = NULL;
+
+	if (lpVirtualMemoryMgr)
+	{
+		phys = lpVirtualMemoryMgr->GetPhysicalAddress((__COMMON_OBJECT*)lpVirtualMemoryMgr, ptr);
+		if (phys)
+		{
+			return (unsigned long)phys;
+		}
+	}
+#endif
+	//Kernel memory is identity mapped.
+	return (unsigned long)ptr;
+}
+
+//Check if a buffer can be used by device directly,it must be physically
+//contiguous and,if boundary is not zero,must not cross a boundary of that
+//size(such as the 64K boundary of IDE bus master).
+int _hx_dma_capable(void* ptr, size_t size, unsigned long boundary)
+{
+	unsigned long start = _hx_dma_addr(ptr);
+	unsigned long page  = 0;
+
+	if (0 == size)
+	{
+		return 0;
+	}
+	if (boundary && ((start / boundary) != ((start + size - 1) / boundary)))
+	{
+		return 0;
+	}
+	//Check each page's physical address.
+	page = ((unsigned long)ptr & ~(PAGE_SIZE - 1)) + PAGE_SIZE;
+	while (page < (unsigned long)ptr + size)
+	{
+		if (_hx_dma_addr((void*)page) != start + (page - (unsigned long)ptr))
+		{
+			return 0;
+		}
+		page += PAGE_SIZE;
+	}
+	return 1;
+}
@@ -1,37 +1,301 @@
-
 #include "StdAfx.h"
 #include "string.h"
 
 //------------------------------------------------------------------------
 // Memory manipulating functions,memcpy,memset,...
+// Memory is processed in 32 bits word when the source and destination
+// can be aligned together,string instructions are used on x86 and the
+// variant is selected by MemFuncInitialize according to CPU features.
 //------------------------------------------------------------------------
 
+//Blocks less than this size are processed byte by byte,the cost of
+//alignment is not worth.
+#define MEM_SMALL_BLOCK      16
+
+//Blocks equal or larger than this size are processed by rep movsb/stosb
+//if the CPU supports enhanced rep movsb/stosb(ERMSB).
+#define MEM_ERMSB_THRESHOLD  128
+
+//Word pattern helpers for memchr.
+#define MEM_ONES             0x01010101
+#define MEM_HIGHS            0x80808080
+#define MEM_HAS_ZERO(w)      (((w) - MEM_ONES) & ~(w) & MEM_HIGHS)
+
+//CPU features detected by MemFuncInitialize.
+DWORD __mem_features = 0;
+
+#ifdef __I386__
+
+//Executes CPUID instruction,results are saved into regs[4] as eax,ebx,ecx,edx.
+static void __mem_cpuid(DWORD leaf,DWORD subleaf,DWORD* regs)
+{
+#ifdef __GCC__
+	DWORD a,b,c,d;
+	__asm__ __volatile__("cpuid"
+		: "=a"(a),"=b"(b),"=c"(c),"=d"(d)
+		: "a"(leaf),"c"(subleaf));
+	regs[0] = a;
+	regs[1] = b;
+	regs[2] = c;
+	regs[3] = d;
+#else
+	__asm{
+		push esi
+		mov eax,leaf
+		mov ecx,subleaf
+		cpuid
+		mov esi,regs
+		mov dword ptr [esi],eax
+		mov dword ptr [esi + 4],ebx
+		mov dword ptr [esi + 8],ecx
+		mov dword ptr [esi + 12],edx
+		pop esi
+	}
+#endif
+}
+
+//Copy dwords by rep movsd.
+static void __rep_movsd(void* dst,const void* src,size_t dwords)
+{
+#ifdef __GCC__
+	__asm__ __volatile__("rep movsl"
+		: "+D"(dst),"+S"(src),"+c"(dwords)
+		:
+		: "memory");
+#else
+	__asm{
+		mov edi,dst
+		mov esi,src
+		mov ecx,dwords
+		rep movsd
+	}
+#endif
+}
+
+//Copy bytes by rep movsb.
+static void __rep_movsb(void* dst,const void* src,size_t count)
+{
+#ifdef __GCC__
+	__asm__ __volatile__("rep movsb"
+		: "+D"(dst),"+S"(src),"+c"(count)
+		:
+		: "memory");
+#else
+	__asm{
+		mov edi,dst
+		mov esi,src
+		mov ecx,count
+		rep movsb
+	}
+#endif
+}
+
+//Fill dwords by rep stosd.
+static void __rep_stosd(void* dst,DWORD pattern,size_t dwords)
+{
+#ifdef __GCC__
+	__asm__ __volatile__("rep stosl"
+		: "+D"(dst),"+c"(dwords)
+		: "a"(pattern)
+		: "memory");
+#else
+	__asm{
+		mov edi,dst
+		mov eax,pattern
+		mov ecx,dwords
+		rep stosd
+	}
+#endif
+}
+
+//Fill bytes by rep stosb.
+static void __rep_stosb(void* dst,DWORD pattern,size_t count)
+{
+#ifdef __GCC__
+	__asm__ __volatile__("rep stosb"
+		: "+D"(dst),"+c"(count)
+		: "a"(pattern)
+		: "memory");
+#else
+	__asm{
+		mov edi,dst
+		mov eax,pattern
+		mov ecx,count
+		rep stosb
+	}
+#endif
+}
+
+#endif //__I386__
+
+//
+//Detect CPU features and select the memory functions' variant,it's called
+//in hardware initialization phase.The generic variant is used before it.
+//
+void MemFuncInitialize(void)
+{
+#ifdef __I386__
+	DWORD regs[4];
+
+	__mem_cpuid(0,0,regs);
+	if(regs[0] >= 1)
+	{
+		__mem_cpuid(1,0,regs);
+		if(regs[3] & (1 << 26))
+		{
+			__mem_features |= MEM_FEATURE_SSE2;
+		}
+	}
+	if(regs[0] >= 7)
+	{
+		__mem_cpuid(7,0,regs);
+		if(regs[1] & (1 << 9))
+		{
+			__mem_features |= MEM_FEATURE_ERMSB;
+		}
+	}
+	__mem_features |= MEM_FEATURE_REPSTR;
+#endif
+}
+
 void* memcpy (void * dst,const void * src,size_t count)
 {
-	void * ret = dst;
+	unsigned char*       d   = (unsigned char*)dst;
+	const unsigned char* s   = (const unsigned char*)src;
+
+	if(count < MEM_SMALL_BLOCK)
+	{
+		while (count--)
+		{
+			*d++ = *s++;
+		}
+		return dst;
+	}
 
-	//copy from lower addresses to higher addresses
-	while (count--) 
+#ifdef __I386__
+	if(__mem_features & MEM_FEATURE_REPSTR)
 	{
-		*(char *)dst = *(char *)src;
-		dst = (char *)dst + 1;
-		src = (char *)src + 1;
+		if((__mem_features & MEM_FEATURE_ERMSB) && (count >= MEM_ERMSB_THRESHOLD))
+		{
+			__rep_movsb(d,s,count);
+			return dst;
+		}
+		//Align destination,unaligned source is handled by CPU.
+		while((DWORD)d & 3)
+		{
+			*d++ = *s++;
+			count --;
+		}
+		__rep_movsd(d,s,count >> 2);
+		d += count & ~3;
+		s += count & ~3;
+		count &= 3;
+		while(count--)
+		{
+			*d++ = *s++;
+		}
+		return dst;
 	}
+#endif
 
-	return(ret);
+	//Copy in word if source and destination can be aligned together.
+	if(0 == (((DWORD)d ^ (DWORD)s) & 3))
+	{
+		while((DWORD)d & 3)
+		{
+			*d++ = *s++;
+			count --;
+		}
+		while(count >= 16)
+		{
+			((DWORD*)d)[0] = ((const DWORD*)s)[0];
+			((DWORD*)d)[1] = ((const DWORD*)s)[1];
+			((DWORD*)d)[2] = ((const DWORD*)s)[2];
+			((DWORD*)d)[3] = ((const DWORD*)s)[3];
+			d += 16;
+			s += 16;
+			count -= 16;
+		}
+		while(count >= 4)
+		{
+			*(DWORD*)d = *(const DWORD*)s;
+			d += 4;
+			s += 4;
+			count -= 4;
+		}
+	}
+	while (count--)
+	{
+		*d++ = *s++;
+	}
+	return dst;
 }
 
 void* memset (void *dst,int val,size_t count)
 {
-	void *start = dst;
+	unsigned char*       d       = (unsigned char*)dst;
+	DWORD                pattern = (unsigned char)val;
+
+	if(count < MEM_SMALL_BLOCK)
+	{
+		while (count--)
+		{
+			*d++ = (unsigned char)val;
+		}
+		return dst;
+	}
+	pattern |= pattern << 8;
+	pattern |= pattern << 16;
 
-	while (count--) 
+#ifdef __I386__
+	if(__mem_features & MEM_FEATURE_REPSTR)
 	{
-		*(char *)dst = (char)val;
-		dst = (char *)dst + 1;
+		if((__mem_features & MEM_FEATURE_ERMSB) && (count >= MEM_ERMSB_THRESHOLD))
+		{
+			__rep_stosb(d,pattern,count);
+			return dst;
+		}
+		while((DWORD)d & 3)
+		{
+			*d++ = (unsigned char)val;
+			count --;
+		}
+		__rep_stosd(d,pattern,count >> 2);
+		d += count & ~3;
+		count &= 3;
+		while(count--)
+		{
+			*d++ = (unsigned char)val;
+		}
+		return dst;
 	}
+#endif
 
-	return(start);
+	while((DWORD)d & 3)
+	{
+		*d++ = (unsigned char)val;
+		count --;
+	}
+	while(count >= 16)
+	{
+		((DWORD*)d)[0] = pattern;
+		((DWORD*)d)[1] = pattern;
+		((DWORD*)d)[2] = pattern;
+		((DWORD*)d)[3] = pattern;
+		d += 16;
+		count -= 16;
+	}
+	while(count >= 4)
+	{
+		*(DWORD*)d = pattern;
+		d += 4;
+		count -= 4;
+	}
+	while (count--)
+	{
+		*d++ = (unsigned char)val;
+	}
+	return dst;
 }
 
 void* memzero(	void* dst,	size_t count)
@@ -41,53 +305,126 @@ void* memzero(	void* dst,	size_t count)
 
 void* memchr (const void * buf,int chr,size_t cnt)
 {
-	while ( cnt && (*(unsigned char *)buf != (unsigned char)chr) ) 
+	const unsigned char* p       = (const unsigned char*)buf;
+	unsigned char        c       = (unsigned char)chr;
+	DWORD                pattern = c;
+	DWORD                w;
+
+	//Head bytes before word boundary.
+	while(cnt && ((DWORD)p & 3))
 	{
-		buf = (unsigned char *)buf + 1;
-		cnt--;
+		if(*p == c)
+		{
+			return (void*)p;
+		}
+		p ++;
+		cnt --;
 	}
-
-	return(cnt ? (void *)buf : NULL);
+	//Scan a word each time,stop at the word containing the character.
+	pattern |= pattern << 8;
+	pattern |= pattern << 16;
+	while(cnt >= 4)
+	{
+		w = *(const DWORD*)p ^ pattern;
+		if(MEM_HAS_ZERO(w))
+		{
+			break;
+		}
+		p += 4;
+		cnt -= 4;
+	}
+	while(cnt)
+	{
+		if(*p == c)
+		{
+			return (void*)p;
+		}
+		p ++;
+		cnt --;
+	}
+	return NULL;
 }
 
 int memcmp(const void *buffer1,const void *buffer2,int count)
 {
-	if (!count) return(0);
+	const unsigned char* p1 = (const unsigned char*)buffer1;
+	const unsigned char* p2 = (const unsigned char*)buffer2;
+
+	if (count <= 0) return(0);
 
-	while ( --count && *(char *)buffer1 == *(char *)buffer2)
+	//Compare in word if the 2 buffers can be aligned together,the different
+	//word is compared byte by byte to get the result.
+	if(0 == (((DWORD)p1 ^ (DWORD)p2) & 3))
 	{
-		buffer1 = (char *)buffer1 + 1;
-		buffer2 = (char *)buffer2 + 1;
+		while(count && ((DWORD)p1 & 3))
+		{
+			if(*p1 != *p2)
+			{
+				return *p1 - *p2;
+			}
+			p1 ++;
+			p2 ++;
+			count --;
+		}
+		while((count >= 4) && (*(const DWORD*)p1 == *(const DWORD*)p2))
+		{
+			p1 += 4;
+			p2 += 4;
+			count -= 4;
+		}
 	}
-
-	return( *((unsigned char *)buffer1) - *((unsigned char *)buffer2) );
+	while(count)
+	{
+		if(*p1 != *p2)
+		{
+			return *p1 - *p2;
+		}
+		p1 ++;
+		p2 ++;
+		count --;
+	}
+	return 0;
 }
- 
+
 //It can handle the scenario that the dst and src memory overlaped scenario.
 void *memmove(void *dst,const void *src,int n)
 {
-     char *dp = (char *)dst;
-     char *sp = (char *)src; 
-     
-	 if((NULL == dst) || (NULL == src) || (n <= 0))
-	 {
-		 return NULL;
-	 }
-
-     //Not overlaped.
-     if(sp>dp||(sp+n)<dp)
-     { 
-         while(n--) 
-             *(dp++) = *(sp++);
-         *dp = '\0';
-     }
-     else if(sp<dp) //Overlaped.
-     {
-		 sp += n; 
-         dp += n; 
-         *dp = '\0'; 
-         while(n--)
-            *(--dp) = *(--sp); 
-     }
-     return dst;
+	unsigned char*       dp = (unsigned char*)dst;
+	const unsigned char* sp = (const unsigned char*)src;
+
+	if((NULL == dst) || (NULL == src) || (n <= 0))
+	{
+		return dst;
+	}
+
+	//Forward copying is safe if destination is lower than source or they are
+	//not overlaped.
+	if((dp <= sp) || (dp >= sp + n))
+	{
+		return memcpy(dst,src,n);
+	}
+
+	//Overlaped and destination is higher,copy from the end.
+	dp += n;
+	sp += n;
+	if(0 == (((DWORD)dp ^ (DWORD)sp) & 3))
+	{
+		while(n && ((DWORD)dp & 3))
+		{
+			*(--dp) = *(--sp);
+			n --;
+		}
+		while(n >= 4)
+		{
+			dp -= 4;
+			sp -= 4;
+			*(DWORD*)dp = *(const DWORD*)sp;
+			n -= 4;
+		}
+	}
+	while(n--)
+	{
+		*(--dp) = *(--sp);
+	}
+	return dst;
 }
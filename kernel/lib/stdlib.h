@@ -47,6 +47,14 @@ int munmap(void* start,size_t length);
 //Aligned malloc.
 void* _hx_aligned_malloc(int size, int align);
 
+//Malloc from current kernel thread's heap,for user level code only.
+void* _hx_heap_malloc(size_t size);
+
+//Physically contiguous memory for device DMA,and address translation.
+void* _hx_dma_malloc(int size, int align);
+unsigned long _hx_dma_addr(void* ptr);
+int _hx_dma_capable(void* ptr, size_t size, unsigned long boundary);
+
 //Flags to control the mmap routine.
 #define PROT_READ      0x00000001
 #define PROT_WRITE     0x00000002
@@ -51,6 +51,14 @@ int   memcmp(const void* p1,const void* p2,int count);
 void* memchr (const void * buf,int chr,size_t cnt);
 void *memmove(void *dst,const void *src,int n);
 
+//CPU features used by memory manipulating functions,detected and saved
+//into __mem_features by MemFuncInitialize.
+#define MEM_FEATURE_REPSTR  0x00000001    //String instructions,rep movsd/stosd.
+#define MEM_FEATURE_ERMSB   0x00000002    //Enhanced rep movsb/stosb.
+#define MEM_FEATURE_SSE2    0x00000004
+extern DWORD __mem_features;
+void  MemFuncInitialize(void);
+
 //Standard C Lib string operations.
 char* strcat(char* dst,const char* src);
 char* strcpy(char* dst,const char* src);
@@ -18,10 +18,11 @@
 #include "stdint.h"
 
 //Local macros used to control the release of different memory blocks.
-//There are 2 memory block types,named NORMAL and ALIGNED,corresponding the
-//result of normal malloc and aligned malloc.
+//There are 3 memory block types,named NORMAL,ALIGNED and HEAP,corresponding the
+//result of normal malloc,aligned malloc,and malloc from kernel thread's heap.
 #define MEMORY_BLOCK_TYPE_NORMAL  0x00
 #define MEMORY_BLOCK_TYPE_ALIGNED 0x08
+#define MEMORY_BLOCK_TYPE_HEAP    0x10
 
 //Local routine declarations.
 static void _hx_aligned_free(void* ptr);
@@ -44,6 +45,31 @@ void* _hx_malloc(size_t size)
 	return (void*)(mem_ptr + 1);
 }
 
+//Allocate memory from current kernel thread's default heap,it's used by
+//user level code only,such as the JVM and applications(KMemAlloc system
+//call).The heap is virtual memory,so the block can not be used by device
+//as DMA buffer,use _hx_dma_malloc instead.
+//Kernel memory pool is used in system initialization,or the heap can not
+//satisfy the request.The block is released by _hx_free.
+void* _hx_heap_malloc(size_t size)
+{
+	unsigned long* mem_ptr = NULL;
+#if defined(__CFG_SYS_VMM) && defined(__CFG_SYS_HEAP)
+	__HEAP_OBJECT* heap    = HeapManager.GetDefaultHeap();
+
+	if (heap)
+	{
+		mem_ptr = (unsigned long*)HeapManager.HeapAlloc(heap, size + sizeof(unsigned long));
+		if (mem_ptr)
+		{
+			mem_ptr[0] = MEMORY_BLOCK_TYPE_HEAP;
+			return (void*)(mem_ptr + 1);
+		}
+	}
+#endif
+	return _hx_malloc(size);
+}
+
 //Corresponding the C standard free routine,it can release normal memory block and aligned
 //memory block,which is allocated by aligned_malloc routine.
 void _hx_free(void* p)
@@ -60,6 +86,14 @@ void _hx_free(void* p)
 		KMemFree(mem_ptr, KMEM_SIZE_TYPE_ANY, 0);
 		return;
 	}
+#if defined(__CFG_SYS_VMM) && defined(__CFG_SYS_HEAP)
+	if (MEMORY_BLOCK_TYPE_HEAP == mem_ptr[0])
+	{
+		//Owner heap is recorded in block,so it can be freed by any thread.
+		HeapManager.HeapFree(mem_ptr, NULL);
+		return;
+	}
+#endif
 	if (MEMORY_BLOCK_TYPE_ALIGNED == mem_ptr[0])  //Aligned block.
 	{
 		_hx_aligned_free(p);
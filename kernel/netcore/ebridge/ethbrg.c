@@ -23,6 +23,7 @@
 #include <lwip/inet.h>
 
 #include "hx_eth.h"
+#include "hx_inet.h"
 #include "ethmgr.h"
 #include "ethbrg.h"
 
@@ -31,39 +32,414 @@
 */
 extern __ETHERNET_BUFFER* Do_DPI(__ETHERNET_BUFFER*);
 
+/* Global forwarding database object. */
+static __FDB_TABLE FdbTable = { 0 };
+
+/* Aging time in system tick. */
+#define FDB_AGING_TICK (FDB_AGING_TIME * 1000 / SYSTEM_TIME_SLICE)
+
+/* Max entries copied out of a hash bucket at a time in dump. */
+#define FDB_DUMP_BATCH 16
+
+/* Obtain the VLAN ID of a frame,0 for untagged one. */
+static __u16 __FrameVlan(__ETHERNET_BUFFER* pBuffer)
+{
+	/* TCI follows the TPID,after destination and source MAC. */
+	if ((FDB_VLAN_TPID == pBuffer->frame_type) &&
+		(pBuffer->act_length >= ETH_MAC_LEN * 2 + 4))
+	{
+		return _hx_ntohs(*(__u16*)(pBuffer->Buffer + ETH_MAC_LEN * 2 + 2)) & FDB_VLAN_MASK;
+	}
+	return 0;
+}
+
+/* Hash MAC address and VLAN into bucket index. */
+static unsigned int __FdbHash(__u8* mac, __u16 vlan)
+{
+	unsigned int hash = vlan;
+	int i = 0;
+
+	for (i = 0; i < ETH_MAC_LEN; i++)
+	{
+		hash = (hash * 31) + mac[i];
+	}
+	return (hash ^ (hash >> 8)) & (FDB_HASH_SIZE - 1);
+}
+
+/* Check if an entry is aged out. */
+static BOOL __FdbAged(__FDB_ENTRY* pEntry, DWORD dwNow)
+{
+	return (dwNow - pEntry->dwUpdateTick) > FDB_AGING_TICK;
+}
+
+/*
+ * Initialize the FDB,entries are pre-allocated in one
+ * chunk and linked into free list.
+ * It's called in the first time of learning,so the
+ * memory is not used if bridging is not active.
+ */
+static BOOL __FdbInitialize()
+{
+	int i = 0;
+
+	FdbTable.pEntrySpace = (__FDB_ENTRY*)_hx_malloc(
+		sizeof(__FDB_ENTRY) * FDB_MAX_ENTRY_NUM);
+	if (NULL == FdbTable.pEntrySpace)
+	{
+		return FALSE;
+	}
+	for (i = 0; i < FDB_MAX_ENTRY_NUM; i++)
+	{
+		FdbTable.pEntrySpace[i].pNext = FdbTable.pFreeEntry;
+		FdbTable.pFreeEntry = &FdbTable.pEntrySpace[i];
+	}
+	return TRUE;
+}
+
+/* 
+ * Remove aged entries from a hash chain,must be called with
+ * critical section held.
+ */
+static VOID __FdbExpireChain(unsigned int hash, DWORD dwNow)
+{
+	__FDB_ENTRY** ppEntry = &FdbTable.HashTable[hash];
+	__FDB_ENTRY* pEntry = NULL;
+
+	while (*ppEntry)
+	{
+		pEntry = *ppEntry;
+		if (__FdbAged(pEntry, dwNow))
+		{
+			*ppEntry = pEntry->pNext;
+			pEntry->pNext = FdbTable.pFreeEntry;
+			FdbTable.pFreeEntry = pEntry;
+			FdbTable.nEntryNum--;
+			continue;
+		}
+		ppEntry = &pEntry->pNext;
+	}
+}
+
+/*
+ * Reclaim entries when the table is full,must be called with
+ * critical section held.Aged entries of all buckets are removed,
+ * and the least recently seen one is evicted if none is aged.
+ */
+static VOID __FdbReclaim(DWORD dwNow)
+{
+	__FDB_ENTRY** ppOldest = NULL;
+	__FDB_ENTRY** ppEntry = NULL;
+	__FDB_ENTRY* pEntry = NULL;
+	unsigned int hash = 0;
+
+	for (hash = 0; hash < FDB_HASH_SIZE; hash++)
+	{
+		__FdbExpireChain(hash, dwNow);
+	}
+	if (FdbTable.pFreeEntry)
+	{
+		return;
+	}
+	for (hash = 0; hash < FDB_HASH_SIZE; hash++)
+	{
+		ppEntry = &FdbTable.HashTable[hash];
+		while (*ppEntry)
+		{
+			if ((NULL == ppOldest) ||
+				((dwNow - (*ppEntry)->dwUpdateTick) > (dwNow - (*ppOldest)->dwUpdateTick)))
+			{
+				ppOldest = ppEntry;
+			}
+			ppEntry = &(*ppEntry)->pNext;
+		}
+	}
+	if (NULL == ppOldest)
+	{
+		return;
+	}
+	pEntry = *ppOldest;
+	*ppOldest = pEntry->pNext;
+	pEntry->pNext = FdbTable.pFreeEntry;
+	FdbTable.pFreeEntry = pEntry;
+	FdbTable.nEntryNum--;
+	FdbTable.dwEvicted++;
+}
+
+/*
+ * Learn source MAC address of a received frame,it's called by
+ * ethernet manager for each frame received.
+ * Existing entry is refreshed,and is moved to the new port
+ * if the station moves.
+ */
+VOID Fdb_Learn(__ETHERNET_BUFFER* pBuffer)
+{
+	__FDB_ENTRY* pEntry = NULL;
+	unsigned int hash = 0;
+	__u16 vlan = 0;
+	DWORD dwNow = 0;
+	DWORD dwFlags;
+
+	BUG_ON(NULL == pBuffer);
+	/* Broadcast or multicast source is invalid. */
+	if (Eth_MAC_BM(pBuffer->srcMAC))
+	{
+		return;
+	}
+	if (NULL == FdbTable.pEntrySpace)
+	{
+		if (!__FdbInitialize())
+		{
+			return;
+		}
+	}
+	vlan = __FrameVlan(pBuffer);
+	hash = __FdbHash(pBuffer->srcMAC, vlan);
+	dwNow = System.dwClockTickCounter;
+
+	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	pEntry = FdbTable.HashTable[hash];
+	while (pEntry)
+	{
+		if ((pEntry->vlanId == vlan) &&
+			Eth_MAC_Match(pEntry->macAddr, pBuffer->srcMAC))
+		{
+			if (pEntry->pEthInt != pBuffer->pInInterface)
+			{
+				pEntry->pEthInt = pBuffer->pInInterface;
+				FdbTable.dwStationMove++;
+			}
+			pEntry->dwUpdateTick = dwNow;
+			__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+			return;
+		}
+		pEntry = pEntry->pNext;
+	}
+	/* New station,reclaim entries if table full. */
+	if (NULL == FdbTable.pFreeEntry)
+	{
+		__FdbReclaim(dwNow);
+		if (NULL == FdbTable.pFreeEntry)
+		{
+			__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+			return;
+		}
+	}
+	pEntry = FdbTable.pFreeEntry;
+	FdbTable.pFreeEntry = pEntry->pNext;
+	memcpy(pEntry->macAddr, pBuffer->srcMAC, ETH_MAC_LEN);
+	pEntry->vlanId = vlan;
+	pEntry->pEthInt = pBuffer->pInInterface;
+	pEntry->dwUpdateTick = dwNow;
+	pEntry->pNext = FdbTable.HashTable[hash];
+	FdbTable.HashTable[hash] = pEntry;
+	FdbTable.nEntryNum++;
+	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+}
+
+/*
+ * Lookup the output port of a destination MAC address.
+ * NULL is returned if the MAC is unknown or aged out.
+ */
+static __ETHERNET_INTERFACE* __FdbLookup(__u8* mac, __u16 vlan)
+{
+	__FDB_ENTRY* pEntry = NULL;
+	__ETHERNET_INTERFACE* pEthInt = NULL;
+	unsigned int hash = 0;
+	DWORD dwFlags;
+
+	if (NULL == FdbTable.pEntrySpace)
+	{
+		return NULL;
+	}
+	hash = __FdbHash(mac, vlan);
+	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	pEntry = FdbTable.HashTable[hash];
+	while (pEntry)
+	{
+		if ((pEntry->vlanId == vlan) && Eth_MAC_Match(pEntry->macAddr, mac))
+		{
+			if (!__FdbAged(pEntry, System.dwClockTickCounter))
+			{
+				pEthInt = pEntry->pEthInt;
+			}
+			break;
+		}
+		pEntry = pEntry->pNext;
+	}
+	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	return pEthInt;
+}
+
+/* Flush FDB entries learned from a port,or all entries if NULL. */
+VOID Fdb_Flush(__ETHERNET_INTERFACE* pEthInt)
+{
+	__FDB_ENTRY** ppEntry = NULL;
+	__FDB_ENTRY* pEntry = NULL;
+	DWORD dwFlags;
+	int i = 0;
+
+	if (NULL == FdbTable.pEntrySpace)
+	{
+		return;
+	}
+	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	for (i = 0; i < FDB_HASH_SIZE; i++)
+	{
+		ppEntry = &FdbTable.HashTable[i];
+		while (*ppEntry)
+		{
+			pEntry = *ppEntry;
+			if ((NULL == pEthInt) || (pEntry->pEthInt == pEthInt))
+			{
+				*ppEntry = pEntry->pNext;
+				pEntry->pNext = FdbTable.pFreeEntry;
+				FdbTable.pFreeEntry = pEntry;
+				FdbTable.nEntryNum--;
+				continue;
+			}
+			ppEntry = &pEntry->pNext;
+		}
+	}
+	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+}
+
+/* Dump out all FDB entries,aged entries are removed first. */
+VOID Fdb_Dump()
+{
+	__FDB_ENTRY Snapshot[FDB_DUMP_BATCH];
+	__FDB_ENTRY* pEntry = NULL;
+	DWORD dwNow = 0;
+	DWORD dwFlags;
+	__u8* mac = NULL;
+	int i = 0, j = 0, num = 0, start = 0;
+
+	_hx_printf("  FDB entries: %d/%d,aging time: %ds.\r\n",
+		FdbTable.nEntryNum, FDB_MAX_ENTRY_NUM, FDB_AGING_TIME);
+	_hx_printf("  known unicast: %d,flooded: %d,filtered: %d.\r\n",
+		FdbTable.dwKnownUnicast, FdbTable.dwFlooded, FdbTable.dwFiltered);
+	_hx_printf("  station move: %d,evicted: %d.\r\n",
+		FdbTable.dwStationMove, FdbTable.dwEvicted);
+	if (NULL == FdbTable.pEntrySpace)
+	{
+		return;
+	}
+	_hx_printf("  %-18s %-5s %-10s %s\r\n", "mac", "vlan", "port", "age(s)");
+	for (i = 0; i < FDB_HASH_SIZE; i++)
+	{
+		/* 
+		 * Copy the bucket out in batches and print them after
+		 * leaving critical section,to avoid printing with
+		 * interrupt disabled.
+		 */
+		start = 0;
+		do {
+			num = 0;
+			__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+			dwNow = System.dwClockTickCounter;
+			if (0 == start)
+			{
+				__FdbExpireChain(i, dwNow);
+			}
+			pEntry = FdbTable.HashTable[i];
+			for (j = 0; pEntry && (j < start); j++)
+			{
+				pEntry = pEntry->pNext;
+			}
+			while (pEntry && (num < FDB_DUMP_BATCH))
+			{
+				Snapshot[num++] = *pEntry;
+				pEntry = pEntry->pNext;
+			}
+			__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+			for (j = 0; j < num; j++)
+			{
+				mac = Snapshot[j].macAddr;
+				_hx_printf("  %02X:%02X:%02X:%02X:%02X:%02X  %-5d %-10s %d\r\n",
+					mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+					Snapshot[j].vlanId,
+					Snapshot[j].pEthInt->ethName,
+					(dwNow - Snapshot[j].dwUpdateTick) * SYSTEM_TIME_SLICE / 1000);
+			}
+			start += num;
+		} while (FDB_DUMP_BATCH == num);
+	}
+}
+
 /* 
  * Delivery an ethernet frame to bridging thread.
  * This routine is called by ethernet manager object,when
  * process an ethernet frame,and if the frame's destination
  * MAC address is not belong to the local scope.
+ * Destination of unicast frame is looked up in FDB,the frame
+ * is forwarded to the learned port only if found,and is
+ * flooded to all ports otherwise.
  */
 BOOL Do_Bridging(__ETHERNET_BUFFER* pBuffer)
 {
 	__ETHERNET_BUFFER* pNewBuff = NULL;
 	__ETHERNET_INTERFACE* pEthInt = NULL;
+	__ETHERNET_INTERFACE* pOutInt = NULL;
 
 	BUG_ON(NULL == pBuffer);
 	pEthInt = pBuffer->pInInterface;
 
+	/* Lookup the destination port for unicast frame. */
+	if (!Eth_MAC_BM(pBuffer->dstMAC))
+	{
+		pOutInt = __FdbLookup(pBuffer->dstMAC, __FrameVlan(pBuffer));
+		if (pOutInt == pEthInt)
+		{
+			/* Destination is in the incoming segment. */
+			FdbTable.dwFiltered++;
+			goto __TERMINAL;
+		}
+		if (pOutInt && (pOutInt->ifState.dwInterfaceStatus & ETHERNET_INTERFACE_STATUS_DOWN))
+		{
+			goto __TERMINAL;
+		}
+	}
+
 	pNewBuff = Do_DPI(pBuffer);
-	if (pNewBuff)
+	if (NULL == pNewBuff)
+	{
+		goto __TERMINAL;
+	}
+	if (pOutInt)
 	{
 		/*
-		* Bridging the DPI processed new ethernet frame.
-		* Please be noted that the new ethernet buffer object
-		* will be destroyed by BroadcastEthernetFrame if it returns
-		* TRUE. Otherwise the pNewBuff should be destroyed
-		* here.
-		*/
-		if (!EthernetManager.BroadcastEthernetFrame(pNewBuff))
+		 * Known unicast,send it through the learned port only.
+		 * The new buffer will be destroyed by ethernet core
+		 * thread after sending.
+		 */
+		if (!EthernetManager.SendFrame(pOutInt, pNewBuff))
 		{
 			EthernetManager.DestroyEthernetBuffer(pNewBuff);
 		}
 		else
 		{
+			FdbTable.dwKnownUnicast++;
 			pEthInt->ifState.dwFrameBridged += 1;
 		}
+		goto __TERMINAL;
+	}
+	/*
+	* Bridging the DPI processed new ethernet frame.
+	* Please be noted that the new ethernet buffer object
+	* will be destroyed by BroadcastEthernetFrame if it returns
+	* TRUE. Otherwise the pNewBuff should be destroyed
+	* here.
+	*/
+	if (!EthernetManager.BroadcastEthernetFrame(pNewBuff))
+	{
+		EthernetManager.DestroyEthernetBuffer(pNewBuff);
 	}
+	else
+	{
+		FdbTable.dwFlooded++;
+		pEthInt->ifState.dwFrameBridged += 1;
+	}
+
+__TERMINAL:
 	/*
 	 * Destroy the pBuffer object.
 	 */
@@ -18,7 +18,56 @@
 #ifndef __ETHBRG_H__
 #define __ETHBRG_H__
 
+/*
+ * Forwarding database(FDB) of the bridge.
+ * Source MAC address of each received frame is learned
+ * into FDB,together with the VLAN it belongs to and the
+ * receiving interface.Known unicast frames are forwarded
+ * to the learned interface only,unknown unicast,broadcast
+ * and multicast frames are flooded to all other ports.
+ */
+#define FDB_HASH_SIZE       256     /* Hash buckets,power of 2. */
+#define FDB_MAX_ENTRY_NUM   1024    /* Max MAC entries learned. */
+#define FDB_AGING_TIME      300     /* Aging time in second. */
+
+/* VLAN tag protocol ID,VLAN 0 is used for untagged frame. */
+#define FDB_VLAN_TPID       0x8100
+#define FDB_VLAN_MASK       0x0FFF
+
+/* FDB entry. */
+typedef struct tag__FDB_ENTRY{
+	__u8                         macAddr[ETH_MAC_LEN];
+	__u16                        vlanId;
+	__ETHERNET_INTERFACE*        pEthInt;    /* Port the MAC is learned from. */
+	DWORD                        dwUpdateTick; /* Last time the MAC is seen. */
+	struct tag__FDB_ENTRY*       pNext;      /* Hash chain or free list. */
+}__FDB_ENTRY;
+
+/* Forwarding database. */
+typedef struct tag__FDB_TABLE{
+	__FDB_ENTRY*                 HashTable[FDB_HASH_SIZE];
+	__FDB_ENTRY*                 pFreeEntry;
+	__FDB_ENTRY*                 pEntrySpace;
+	int                          nEntryNum;  /* Entries in hash table. */
+
+	/* Statistics counter. */
+	DWORD                        dwEvicted;  /* Oldest entry replaced,table full. */
+	DWORD                        dwStationMove; /* MAC moved to another port. */
+	DWORD                        dwKnownUnicast;
+	DWORD                        dwFlooded;
+	DWORD                        dwFiltered; /* Dest in the same port. */
+}__FDB_TABLE;
+
 /* Delivery an ethernet frame to bridging thread. */
 BOOL Do_Bridging(__ETHERNET_BUFFER* pEthBuff);
 
+/* Learn source MAC address of a received frame. */
+VOID Fdb_Learn(__ETHERNET_BUFFER* pEthBuff);
+
+/* Flush FDB entries learned from a port,or all entries if NULL. */
+VOID Fdb_Flush(__ETHERNET_INTERFACE* pEthInt);
+
+/* Dump out all FDB entries. */
+VOID Fdb_Dump();
+
 #endif //__ETHBRG_H__
@@ -25,6 +25,7 @@
 #include <lwip/inet.h>
 
 #include "hx_eth.h"
+#include "hx_inet.h"
 #include "ethmgr.h"
 #include "ebridge/ethbrg.h"
 #include "proto.h"
@@ -377,12 +378,27 @@ static void _dhcpAssist()
 	return;
 }
 
+//Wakeup routine of the receiving ring,send the post frame message to ethernet
+//core thread when the ring changes from empty to non-empty.
+static BOOL _RxRingWakeup(LPVOID lpWakeupParam)
+{
+	__KERNEL_THREAD_MESSAGE msg;
+
+	if (NULL == EthernetManager.EthernetCoreThread)
+	{
+		return FALSE;
+	}
+	msg.wCommand = ETH_MSG_POSTFRAME;
+	msg.wParam = 0;
+	msg.dwParam = 0;
+	return SendMessage((HANDLE)EthernetManager.EthernetCoreThread, &msg);
+}
+
 //Post a ethernet buffer object to Ethernet Manager object,which is mainly called
 //in NIC driver.
 static BOOL _PostFrame(__ETHERNET_INTERFACE* pEthInt, __ETHERNET_BUFFER* pBuffer)
 {
-	__KERNEL_THREAD_MESSAGE msg;
-	DWORD dwFlags;
+	__RING_BUFFER* pRxRing = EthernetManager.pRxRing;
 
 	if ((NULL == pEthInt) || (NULL == pBuffer))
 	{
@@ -393,6 +409,10 @@ static BOOL _PostFrame(__ETHERNET_INTERFACE* pEthInt, __ETHERNET_BUFFER* pBuffer
 	{
 		return FALSE;
 	}
+	if (NULL == pRxRing)
+	{
+		return FALSE;
+	}
 	/*
 	 * This routine is called by NIC driver,so any ethernent buffer
 	 * object delivered to this routine should be newly constructed,
@@ -400,57 +420,13 @@ static BOOL _PostFrame(__ETHERNET_INTERFACE* pEthInt, __ETHERNET_BUFFER* pBuffer
 	 */
 	BUG_ON(pBuffer->pNext != NULL);
 
-	//Link the ethernet buffer object to list,and send a message to ethernet core
-	//thread if is the fist buffer object.
-	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
-	if (NULL == EthernetManager.pBufferFirst)
-	{
-		if (NULL != EthernetManager.pBufferLast)
-		{
-			__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-			BUG();
-		}
-		//Link the buffer object to list before send POSTFRAME message.
-		EthernetManager.pBufferFirst = pBuffer;
-		EthernetManager.pBufferLast = pBuffer;
-		EthernetManager.nBuffListSize += 1;
-		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-
-		//Then send the post frame message to ethernet core thread,make it noticed to
-		//process the incoming packet.
-		//Since it may fail,we will give up in this case...
-		msg.wCommand = ETH_MSG_POSTFRAME;
-		msg.wParam = 0;
-		msg.dwParam = (DWORD)pBuffer;
-		if (!SendMessage((HANDLE)EthernetManager.EthernetCoreThread, &msg))
-		{
-			__ENTER_CRITICAL_SECTION(NULL, dwFlags);
-			EthernetManager.pBufferFirst = NULL;
-			EthernetManager.pBufferLast = NULL;
-			EthernetManager.nBuffListSize -= 1;
-			__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-			return FALSE;
-		}
-	}
-	else
-	{
-		if (NULL == EthernetManager.pBufferLast)
-		{
-			__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-			BUG();
-		}
-		//Exceed the maximal buffer list size.
-		if (EthernetManager.nBuffListSize > MAX_ETH_RXBUFFLISTSZ)
-		{
-			__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-			return FALSE;
-		}
-		EthernetManager.pBufferLast->pNext = pBuffer;
-		EthernetManager.pBufferLast = pBuffer;
-		EthernetManager.nBuffListSize += 1;
-		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-	}
-	return TRUE;
+	/*
+	 * Add the buffer object to receiving ring without any lock,the
+	 * ring sends POSTFRAME message to ethernet core thread when it
+	 * changes from empty to non-empty.It fails if the ring is full,
+	 * and the caller should destroy the buffer in this case.
+	 */
+	return pRxRing->AddElement((__COMMON_OBJECT*)pRxRing, (DWORD)pBuffer);
 }
 
 //A helper routine to delivery an ethernet frame to local layer 3 protocol,such
@@ -503,105 +479,133 @@ __TERMINAL:
 	return bDeliveryResult;
 }
 
-//Handler the Post Frame message.
-static BOOL _PostFrameHandler()
+//Process one frame received from NIC driver.
+static VOID _ProcessRxFrame(__ETHERNET_BUFFER* pBuffer)
 {
-	__ETHERNET_BUFFER* pBuffer = NULL;
 	__ETHERNET_INTERFACE* pEthInt = NULL;
-	BOOL bDeliveryResult = FALSE;
-	DWORD dwFlags;
-	BOOL bShouldReturn = FALSE;
 
-	while (TRUE)
+	//Update interface statistics.
+	//pEthInt = pBuffer->pEthernetInterface;
+	pEthInt = pBuffer->pInInterface;
+	if (NULL == pEthInt)  //Should not occur.
 	{
-		//Get one ethernet buffer from list.
-		__ENTER_CRITICAL_SECTION(NULL, dwFlags);
-		if (NULL == EthernetManager.pBufferFirst)  //No frame pending.
+		BUG();
+	}
+	pEthInt->ifState.dwFrameRecv++;
+	pEthInt->ifState.dwTotalRecvSize += pBuffer->act_length;
+#ifdef __CFG_NET_EBRG
+	//Learn the source MAC into bridge's forwarding database.
+	Fdb_Learn(pBuffer);
+#endif
+
+	//Process the frame according to it's destination MAC address.
+	if (Eth_MAC_Match(pEthInt->ethMac, pBuffer->dstMAC))
+	{
+		_Delivery2Local(pBuffer);  //Delivery to local.
+		EthernetManager.DestroyEthernetBuffer(pBuffer);
+	}
+	else
+	{
+		//Broadcast or multicast frame also should be delivered to local.
+		if (Eth_MAC_BM(pBuffer->dstMAC))
 		{
-			if (EthernetManager.pBufferLast)  //Double check.
-			{
-				__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-				BUG();
-				return FALSE;
-			}
-			__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
-			return FALSE;
+			_Delivery2Local(pBuffer);
 		}
-		bShouldReturn = FALSE;
-		pBuffer = EthernetManager.pBufferFirst;
-		EthernetManager.pBufferFirst = pBuffer->pNext;
-		if (NULL == pBuffer->pNext)
+#ifdef __CFG_NET_EBRG
+		/*
+		 * Delivery the ethernet frame to bridging thread.
+		 * The buffer object will be released in bridging
+		 * function if delivering is successful.
+		 */
+		if (Do_Bridging(pBuffer))
 		{
-			EthernetManager.pBufferLast = NULL;
-			/* 
-			 * Should return,since we encounter empty condition of
-			 * buffer list. Otherwise may lead the message queue full
-			 * netCore thread,cause the NIC driver will drop a msg
-			 * to netCore when it makes the buffer list to no-empty
-			 * from empty.Just check the implementation code of
-			 * PostFrame routine of EthernetManager object.
-			 */
-			bShouldReturn = TRUE;
+			return;
 		}
-		EthernetManager.nBuffListSize -= 1;
-		if (EthernetManager.nBuffListSize < 0)
+		else /* Should destroy the frame here. */
+#endif
 		{
-			BUG();
+			EthernetManager.DestroyEthernetBuffer(pBuffer);
 		}
-		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+		/*
+		* The old ethernet buffer should be released here.
+		*/
+	}
+	return;
+}
 
-		//Update interface statistics.
-		//pEthInt = pBuffer->pEthernetInterface;
-		pEthInt = pBuffer->pInInterface;
-		if (NULL == pEthInt)  //Should not occur.
-		{
-			BUG();
-		}
-		pEthInt->ifState.dwFrameRecv++;
-		pEthInt->ifState.dwTotalRecvSize += pBuffer->act_length;
+//Handler the Post Frame message.
+static BOOL _PostFrameHandler()
+{
+	__ETHERNET_BUFFER* BufferArray[ETH_RX_BATCH_SIZE];
+	__RING_BUFFER* pRxRing = EthernetManager.pRxRing;
+	__KERNEL_THREAD_MESSAGE msg;
+	DWORD dwNum = 0;
+	DWORD i = 0;
+	int nBudget = ETH_RX_BATCH_BUDGET;
 
-		//Process the frame according to it's destination MAC address.
-		if (Eth_MAC_Match(pEthInt->ethMac, pBuffer->dstMAC))
-		{
-			bDeliveryResult = _Delivery2Local(pBuffer);  //Delivery to local.
-			EthernetManager.DestroyEthernetBuffer(pBuffer);
-		}
-		else
+	while (TRUE)
+	{
+		//Take a batch of frames from receiving ring.
+		dwNum = pRxRing->GetElements((__COMMON_OBJECT*)pRxRing,
+			(DWORD*)&BufferArray[0], ETH_RX_BATCH_SIZE, 0);
+		if (0 == dwNum)
 		{
-			//Broadcast or multicast frame also should be delivered to local.
-			if (Eth_MAC_BM(pBuffer->dstMAC))
-			{
-				bDeliveryResult = _Delivery2Local(pBuffer);
-			}
-#ifdef __CFG_NET_EBRG
 			/*
-			 * Delivery the ethernet frame to bridging thread.
-			 * The buffer object will be released in bridging
-			 * function if delivering is successful.
+			 * Ring is drained,arm the wakeup so the next frame
+			 * posted by NIC driver will send a POSTFRAME message,
+			 * frames may arrive before arming,so check again.
 			 */
-			if (Do_Bridging(pBuffer))
+			if (pRxRing->ArmWakeup((__COMMON_OBJECT*)pRxRing))
 			{
-				continue; //Continue to process next frame.
-			}
-			else /* Should destroy the frame here. */
-#endif
-			{
-				EthernetManager.DestroyEthernetBuffer(pBuffer);
+				break;
 			}
-			/*
-			* The old ethernet buffer should be released here.
-			*/
+			continue;
 		}
-		if (bShouldReturn)
+		for (i = 0; i < dwNum; i++)
 		{
-			goto __TERMINAL;
+			_ProcessRxFrame(BufferArray[i]);
+		}
+		/*
+		 * Give other messages,such as sending frame,a chance,the
+		 * rest frames are processed in next POSTFRAME message.
+		 */
+		nBudget--;
+		if (0 == nBudget)
+		{
+			msg.wCommand = ETH_MSG_POSTFRAME;
+			msg.wParam = 0;
+			msg.dwParam = 0;
+			if (SendMessage((HANDLE)EthernetManager.EthernetCoreThread, &msg))
+			{
+				break;
+			}
+			nBudget = ETH_RX_BATCH_BUDGET;
 		}
 	}
-
-__TERMINAL:
 	return TRUE;
 }
 
+/*
+* Copy an ethernet frame to interface's sending buffer,the
+* sending buffer has it's own data area,so it does not refer
+* the frame's data block after copying.
+*/
+static VOID _CopyToSendBuffer(__ETHERNET_INTERFACE* pEthInt, __ETHERNET_BUFFER* pBuffer)
+{
+	__ETHERNET_BUFFER* pSendBuff = &pEthInt->SendBuffer;
+
+	BUG_ON(pBuffer->act_length > ETH_MAX_FRAME_LEN);
+	memcpy(pSendBuff->srcMAC, pBuffer->srcMAC, ETH_MAC_LEN);
+	memcpy(pSendBuff->dstMAC, pBuffer->dstMAC, ETH_MAC_LEN);
+	pSendBuff->frame_type = pBuffer->frame_type;
+	pSendBuff->act_length = pBuffer->act_length;
+	pSendBuff->buff_status = pBuffer->buff_status;
+	pSendBuff->csum_flags = 0;  //Bridged frame carries it's own checksum.
+	pSendBuff->pInInterface = pBuffer->pInInterface;
+	pSendBuff->pOutInterface = pBuffer->pOutInterface;
+	memcpy(pSendBuff->Buffer, pBuffer->Buffer, pBuffer->act_length);
+}
+
 /*
 * Handler of the ETH_MSG_BROADCAST in eth_core thread.
 */
@@ -611,7 +615,6 @@ static BOOL __BroadcastHandler()
 	__ETHERNET_BUFFER* pNewBuff = NULL;
 	__ETHERNET_INTERFACE* pRecvInt = NULL;
 	__ETHERNET_INTERFACE* pEthInt = NULL;
-	BOOL bDeliveryResult = FALSE;
 	int index = 0;
 	DWORD dwFlags;
 
@@ -669,7 +672,7 @@ static BOOL __BroadcastHandler()
 			BUG_ON(NULL == pEthInt->SendFrame);
 
 			//Now use the default ehernet send buffer to sendout the frame.
-			memcpy(&pEthInt->SendBuffer, pBuffer, sizeof(__ETHERNET_BUFFER));
+			_CopyToSendBuffer(pEthInt, pBuffer);
 			//pEthInt->SendBuffer.pEthernetInterface = pEthInt; //Mark the out interface.
 			pEthInt->SendBuffer.pOutInterface = pEthInt; //Mark the out interface.
 			BUG_ON(KERNEL_OBJECT_SIGNATURE != pEthInt->SendBuffer.dwSignature);
@@ -782,7 +785,7 @@ static DWORD EthCoreThreadEntry(LPVOID pData)
 				if (&pEthInt->SendBuffer != pEthBuffer)  //Not the default Ethernet Buffer.
 				{
 					//Copy to ethernet interface's default buffer.
-					memcpy(&pEthInt->SendBuffer, pEthBuffer, sizeof(__ETHERNET_BUFFER));
+					_CopyToSendBuffer(pEthInt, pEthBuffer);
 					//Release the Ethernet Buffer object.
 					EthernetManager.DestroyEthernetBuffer(pEthBuffer);
 				}
@@ -813,6 +816,11 @@ static DWORD EthCoreThreadEntry(LPVOID pData)
 					_ethernet_if_input();
 				}
 				_dhcpAssist();        //Call DHCP assist function routinely.
+				/*
+				 * Pick up frames left in receiving ring in case the
+				 * POSTFRAME message could not be sent.
+				 */
+				_PostFrameHandler();
 				break;
 
 			case ETH_MSG_DELIVER:  //Delivery a packet.
@@ -856,6 +864,24 @@ static BOOL Initialize(struct __ETHERNET_MANAGER* pManager)
 		return FALSE;
 	}
 
+	//Create the data block pool for ethernet buffers not created by driver.
+	pManager->pDefaultPool = pManager->CreateBufferPool(ETH_BUFFER_POOL_SIZE);
+	if (NULL == pManager->pDefaultPool)
+	{
+		goto __TERMINAL;
+	}
+
+	//Create the receiving ring,NIC drivers post frames into it from
+	//interrupt or their own threads,so multiple producers are allowed.
+	pManager->pRxRing = (__RING_BUFFER*)CreateRingBuffEx(MAX_ETH_RXBUFFLISTSZ,
+		RING_BUFFER_FLAG_MPSC);
+	if (NULL == pManager->pRxRing)
+	{
+		goto __TERMINAL;
+	}
+	pManager->pRxRing->SetWakeupRoutine((__COMMON_OBJECT*)pManager->pRxRing,
+		_RxRingWakeup, NULL);
+
 	//Create the ethernet core thread.
 	EthernetManager.EthernetCoreThread = KernelThreadManager.CreateKernelThread(
 		(__COMMON_OBJECT*)&KernelThreadManager,
@@ -997,6 +1023,8 @@ static __ETHERNET_INTERFACE* AddEthernetInterface(char* ethName, char* mac, LPVO
 	//pEthInt->SendBuffer.pEthernetInterface = pEthInt;  //Point back.
 	pEthInt->SendBuffer.pNext = NULL;
 	pEthInt->SendBuffer.dwSignature = KERNEL_OBJECT_SIGNATURE;
+	pEthInt->SendBuffer.Buffer = pEthInt->SendData;
+	pEthInt->SendBuffer.pBlock = NULL;
 
 	//Copy ethernet name,do not use strxxx routine for safety.
 	while (ethName[index] && (index < MAX_ETH_NAME_LEN))
@@ -1374,6 +1402,10 @@ static BOOL ShutdownInterface(char* ethName)
 		}
 	}
 	pEthInt->ifState.dwInterfaceStatus = ETHERNET_INTERFACE_STATUS_DOWN;
+#ifdef __CFG_NET_EBRG
+	//Stations learned from this interface are not reachable any more.
+	Fdb_Flush(pEthInt);
+#endif
 	return TRUE;
 }
 
@@ -1455,6 +1487,181 @@ __TERMINAL:
 	return bResult;
 }
 
+//Create a data block pool,blocks are carved from one physically contiguous
+//memory chunk and linked into free list.
+static __ETH_BUFFER_POOL* _CreateBufferPool(int nBlockNum)
+{
+	__ETH_BUFFER_POOL* pPool = NULL;
+	__ETH_DATA_BLOCK* pBlock = NULL;
+	DWORD dwStride = 0;
+	DWORD dwPageSpan = PAGE_SIZE;
+	int nPerPage = 0;
+	int i = 0;
+
+	if (nBlockNum <= 0)
+	{
+		return NULL;
+	}
+	pPool = (__ETH_BUFFER_POOL*)_hx_malloc(sizeof(__ETH_BUFFER_POOL));
+	if (NULL == pPool)
+	{
+		return NULL;
+	}
+	memset(pPool, 0, sizeof(__ETH_BUFFER_POOL));
+	/*
+	 * Keep each block aligned,since NIC may receive frame into it,and
+	 * put blocks into pages without straddling page boundary.
+	 */
+	dwStride = (sizeof(__ETH_DATA_BLOCK) + ETH_DATA_BLOCK_ALIGN - 1) & ~(ETH_DATA_BLOCK_ALIGN - 1);
+	nPerPage = PAGE_SIZE / dwStride;
+	if (0 == nPerPage)
+	{
+		nPerPage = 1;
+		dwPageSpan = (dwStride + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+	}
+	pPool->pBlockSpace = _hx_dma_malloc(((nBlockNum + nPerPage - 1) / nPerPage) * dwPageSpan, PAGE_SIZE);
+	if (NULL == pPool->pBlockSpace)
+	{
+		_hx_printf("  %s: can not allocate memory for %d blocks.\r\n", __func__, nBlockNum);
+		_hx_free(pPool);
+		return NULL;
+	}
+	for (i = nBlockNum - 1; i >= 0; i--)
+	{
+		pBlock = (__ETH_DATA_BLOCK*)((__u8*)pPool->pBlockSpace +
+			(i / nPerPage) * dwPageSpan + (i % nPerPage) * dwStride);
+		pBlock->DmaAddr = _hx_dma_addr(pBlock->Data);
+		pBlock->pPool = pPool;
+		pBlock->nRefCount = 0;
+		pBlock->bHeaderInuse = FALSE;
+		pBlock->pNext = pPool->pFreeBlock;
+		pPool->pFreeBlock = pBlock;
+	}
+	pPool->nBlockNum = nBlockNum;
+	pPool->nFreeNum = nBlockNum;
+	return pPool;
+}
+
+//Destroy a data block pool,it can be destroyed only when all blocks are
+//returned.
+static BOOL _DestroyBufferPool(__ETH_BUFFER_POOL* pPool)
+{
+	DWORD dwFlags;
+
+	if (NULL == pPool)
+	{
+		return FALSE;
+	}
+	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	if (pPool->nFreeNum != pPool->nBlockNum)  //Some block(s) in use.
+	{
+		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+		return FALSE;
+	}
+	pPool->pFreeBlock = NULL;
+	pPool->nFreeNum = pPool->nBlockNum = 0;
+	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	_hx_free(pPool->pBlockSpace);
+	_hx_free(pPool);
+	return TRUE;
+}
+
+//Allocate a data block from pool,or from heap if the pool is empty,the
+//reference counter of the returned block is 1.
+static __ETH_DATA_BLOCK* _AllocDataBlock(__ETH_BUFFER_POOL* pPool)
+{
+	__ETH_DATA_BLOCK* pBlock = NULL;
+	DWORD dwFlags;
+
+	if (pPool)
+	{
+		__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+		pPool->dwAllocTimes++;
+		pBlock = pPool->pFreeBlock;
+		if (pBlock)
+		{
+			pPool->pFreeBlock = pBlock->pNext;
+			pPool->nFreeNum--;
+		}
+		else
+		{
+			pPool->dwEmptyTimes++;
+		}
+		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	}
+	if (NULL == pBlock)
+	{
+		pBlock = (__ETH_DATA_BLOCK*)_hx_dma_malloc(sizeof(__ETH_DATA_BLOCK), ETH_DATA_BLOCK_ALIGN);
+		if (NULL == pBlock)
+		{
+			return NULL;
+		}
+		pBlock->DmaAddr = _hx_dma_addr(pBlock->Data);
+		pBlock->pPool = NULL;
+		__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+		EthernetManager.nHeapDataBlocks++;
+		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	}
+	pBlock->pNext = NULL;
+	pBlock->nRefCount = 1;
+	pBlock->bHeaderInuse = FALSE;
+	return pBlock;
+}
+
+//Decrease the reference counter of a data block,and return it to pool or
+//heap if no one refers it.
+static VOID _ReleaseDataBlock(__ETH_DATA_BLOCK* pBlock)
+{
+	__ETH_BUFFER_POOL* pPool = NULL;
+	DWORD dwFlags;
+
+	if (NULL == pBlock)
+	{
+		return;
+	}
+	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	BUG_ON(pBlock->nRefCount <= 0);
+	pBlock->nRefCount--;
+	if (pBlock->nRefCount)
+	{
+		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+		return;
+	}
+	pPool = pBlock->pPool;
+	if (pPool)
+	{
+		pBlock->pNext = pPool->pFreeBlock;
+		pPool->pFreeBlock = pBlock;
+		pPool->nFreeNum++;
+		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+		return;
+	}
+	EthernetManager.nHeapDataBlocks--;
+	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	_hx_free(pBlock);  //DMA block is also freed by _hx_free.
+}
+
+//Get an ethernet buffer object to refer the given data block,the one embedded
+//in block is used if it's free.
+static __ETHERNET_BUFFER* _GetBufferHeader(__ETH_DATA_BLOCK* pBlock)
+{
+	__ETHERNET_BUFFER* pEthBuff = NULL;
+	DWORD dwFlags;
+
+	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	if (!pBlock->bHeaderInuse)
+	{
+		pBlock->bHeaderInuse = TRUE;
+		pEthBuff = &pBlock->Header;
+	}
+	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	if (NULL == pEthBuff)
+	{
+		pEthBuff = (__ETHERNET_BUFFER*)_hx_malloc(sizeof(__ETHERNET_BUFFER));
+	}
+	return pEthBuff;
+}
+
 //Create an Ethernet Buffer object and return it,NULL will be returned
 //if failed to create.
 //buff_length will be skiped in current implementation,since the Ethernet Buffer
@@ -1462,13 +1669,20 @@ __TERMINAL:
 static __ETHERNET_BUFFER* _CreateEthernetBuffer(int buff_length)
 {
 	__ETHERNET_BUFFER* pEthBuff = NULL;
+	__ETH_DATA_BLOCK* pBlock = NULL;
 
-	pEthBuff = (__ETHERNET_BUFFER*)_hx_malloc(sizeof(__ETHERNET_BUFFER));
-	if (NULL == pEthBuff)
+	pBlock = _AllocDataBlock(EthernetManager.pDefaultPool);
+	if (NULL == pBlock)
 	{
 		_hx_printf("  %s: can not allocate Ethernet Buffer object.\r\n", __func__);
 		goto __TERMINAL;
 	}
+	pEthBuff = _GetBufferHeader(pBlock);
+	if (NULL == pEthBuff)
+	{
+		_ReleaseDataBlock(pBlock);
+		goto __TERMINAL;
+	}
 	//Create OK,initialize it.
 	pEthBuff->pNext = NULL;
 	pEthBuff->dwSignature = KERNEL_OBJECT_SIGNATURE;
@@ -1476,9 +1690,12 @@ static __ETHERNET_BUFFER* _CreateEthernetBuffer(int buff_length)
 	pEthBuff->buff_length = ETH_DEFAULT_MTU + ETH_HEADER_LEN;
 	pEthBuff->frame_type = 0;
 	pEthBuff->buff_status = ETHERNET_BUFFER_STATUS_FREE;
+	pEthBuff->csum_flags = 0;
 	//pEthBuff->pEthernetInterface = NULL;
 	pEthBuff->pInInterface = NULL;
 	pEthBuff->pOutInterface = NULL;
+	pEthBuff->pBlock = pBlock;
+	pEthBuff->Buffer = pBlock->Data;
 	memset(pEthBuff->srcMAC, 0, sizeof(pEthBuff->srcMAC));
 	memset(pEthBuff->dstMAC, 0, sizeof(pEthBuff->dstMAC));
 	EthernetManager.nTotalEthernetBuffs += 1;
@@ -1487,10 +1704,53 @@ __TERMINAL:
 	return pEthBuff;
 }
 
-//Clone a new ethernet buffer by giving a existing one.
+//Create an Ethernet Buffer object for a frame received into data block by
+//driver,the frame's header is parsed and the caller's reference of data
+//block is taken over,even if failed.
+static __ETHERNET_BUFFER* _CreateRxEthernetBuffer(__ETHERNET_INTERFACE* pEthInt,
+	__ETH_DATA_BLOCK* pBlock, int length)
+{
+	__ETHERNET_BUFFER* pEthBuff = NULL;
+
+	if ((NULL == pBlock) || (length <= ETH_MAC_LEN * 2 + 2) || (length > ETH_MAX_FRAME_LEN))
+	{
+		goto __TERMINAL;
+	}
+	pEthBuff = _GetBufferHeader(pBlock);
+	if (NULL == pEthBuff)
+	{
+		goto __TERMINAL;
+	}
+	pEthBuff->pNext = NULL;
+	pEthBuff->dwSignature = KERNEL_OBJECT_SIGNATURE;
+	pEthBuff->act_length = length;
+	pEthBuff->buff_length = ETH_DEFAULT_MTU + ETH_HEADER_LEN;
+	pEthBuff->pInInterface = pEthInt;
+	pEthBuff->pOutInterface = NULL;
+	pEthBuff->pBlock = pBlock;
+	pEthBuff->Buffer = pBlock->Data;
+	//Fill the MAC addresses and packet types.
+	memcpy(pEthBuff->dstMAC, pBlock->Data, ETH_MAC_LEN);
+	memcpy(pEthBuff->srcMAC, pBlock->Data + ETH_MAC_LEN, ETH_MAC_LEN);
+	pEthBuff->frame_type = _hx_ntohs(*(__u16*)(pBlock->Data + ETH_MAC_LEN * 2));
+	pEthBuff->buff_status = ETHERNET_BUFFER_STATUS_INITIALIZED;
+	pEthBuff->csum_flags = 0;  //Driver sets it if verified checksum.
+	EthernetManager.nTotalEthernetBuffs += 1;
+	return pEthBuff;
+
+__TERMINAL:
+	_ReleaseDataBlock(pBlock);
+	return NULL;
+}
+
+//Clone a new ethernet buffer by giving a existing one,the frame data is shared
+//between them,just the reference counter of data block is increased.
+//Data is copied only when the source one has private data.
 static __ETHERNET_BUFFER* _CloneEthernetBuffer(__ETHERNET_BUFFER* pEthBuff)
 {
 	__ETHERNET_BUFFER* pNewEthBuff = NULL;
+	__ETH_DATA_BLOCK* pBlock = NULL;
+	DWORD dwFlags;
 
 	if (NULL == pEthBuff)
 	{
@@ -1506,12 +1766,31 @@ static __ETHERNET_BUFFER* _CloneEthernetBuffer(__ETHERNET_BUFFER* pEthBuff)
 		BUG();
 	}
 
-	pNewEthBuff = (__ETHERNET_BUFFER*)_hx_malloc(sizeof(__ETHERNET_BUFFER));
+	pBlock = pEthBuff->pBlock;
+	if (pBlock)
+	{
+		__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+		pBlock->nRefCount++;
+		__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	}
+	else
+	{
+		pBlock = _AllocDataBlock(EthernetManager.pDefaultPool);
+		if (NULL == pBlock)
+		{
+			goto __TERMINAL;
+		}
+		memcpy(pBlock->Data, pEthBuff->Buffer, pEthBuff->act_length);
+	}
+	pNewEthBuff = _GetBufferHeader(pBlock);
 	if (NULL == pNewEthBuff)
 	{
+		_ReleaseDataBlock(pBlock);
 		goto __TERMINAL;
 	}
 	memcpy(pNewEthBuff, pEthBuff, sizeof(__ETHERNET_BUFFER));
+	pNewEthBuff->pBlock = pBlock;
+	pNewEthBuff->Buffer = pBlock->Data;
 	/*
 	* Reset pNext pointer.
 	*/
@@ -1526,9 +1805,50 @@ __TERMINAL:
 	return pNewEthBuff;
 }
 
+//Copy a new ethernet buffer by giving a existing one,the frame data is copied
+//into a new data block,so the new one can be modified without affecting other
+//buffers sharing the source's data block.
+static __ETHERNET_BUFFER* _CopyEthernetBuffer(__ETHERNET_BUFFER* pEthBuff)
+{
+	__ETHERNET_BUFFER* pNewEthBuff = NULL;
+	__ETH_DATA_BLOCK* pBlock = NULL;
+
+	if (NULL == pEthBuff)
+	{
+		goto __TERMINAL;
+	}
+	BUG_ON(KERNEL_OBJECT_SIGNATURE != pEthBuff->dwSignature);
+	//Buffer length should be fixed as ETH_DEFAULT_MTU + ETH_HEADER_LEN currently.
+	BUG_ON((ETH_DEFAULT_MTU + ETH_HEADER_LEN) != pEthBuff->buff_length);
+	BUG_ON(pEthBuff->act_length > ETH_MAX_FRAME_LEN);
+
+	pBlock = _AllocDataBlock(EthernetManager.pDefaultPool);
+	if (NULL == pBlock)
+	{
+		goto __TERMINAL;
+	}
+	memcpy(pBlock->Data, pEthBuff->Buffer, pEthBuff->act_length);
+	pNewEthBuff = _GetBufferHeader(pBlock);
+	if (NULL == pNewEthBuff)
+	{
+		_ReleaseDataBlock(pBlock);
+		goto __TERMINAL;
+	}
+	memcpy(pNewEthBuff, pEthBuff, sizeof(__ETHERNET_BUFFER));
+	pNewEthBuff->pBlock = pBlock;
+	pNewEthBuff->Buffer = pBlock->Data;
+	pNewEthBuff->pNext = NULL;
+	EthernetManager.nTotalEthernetBuffs += 1;
+
+__TERMINAL:
+	return pNewEthBuff;
+}
+
 //Destroy a specified Ethernet Buffer object.
 static VOID _DestroyEthernetBuffer(__ETHERNET_BUFFER* pEthBuff)
 {
+	__ETH_DATA_BLOCK* pBlock = NULL;
+
 	if (NULL == pEthBuff)
 	{
 		return;
@@ -1536,6 +1856,8 @@ static VOID _DestroyEthernetBuffer(__ETHERNET_BUFFER* pEthBuff)
 	BUG_ON(KERNEL_OBJECT_SIGNATURE != pEthBuff->dwSignature);
 	//Buffer length should be fixed as ETH_DEFAULT_MTU + ETH_HEADER_LEN currently.
 	BUG_ON((ETH_DEFAULT_MTU + ETH_HEADER_LEN) != pEthBuff->buff_length);
+	pBlock = pEthBuff->pBlock;
+	BUG_ON(NULL == pBlock);
 
 	/*
 	 * Clear all object key memeber's value before release,since it will
@@ -1547,8 +1869,18 @@ static VOID _DestroyEthernetBuffer(__ETHERNET_BUFFER* pEthBuff)
 	pEthBuff->dwSignature = 0;
 	pEthBuff->pNext = NULL;
 	pEthBuff->pInInterface = pEthBuff->pOutInterface = NULL;
+	pEthBuff->pBlock = NULL;
+	pEthBuff->Buffer = NULL;
 
-	_hx_free(pEthBuff);
+	if (pEthBuff == &pBlock->Header)
+	{
+		pBlock->bHeaderInuse = FALSE;
+	}
+	else
+	{
+		_hx_free(pEthBuff);
+	}
+	_ReleaseDataBlock(pBlock);
 
 	/*
 	* Decrease total ethernet buffer number in system.
@@ -1665,9 +1997,7 @@ struct __ETHERNET_MANAGER EthernetManager = {
 	0,                      //Index of free slot.
 	NULL,                   //Handle of ethernet core thread.
 	FALSE,                  //Not initialized yet.
-	NULL,                   //Buffer list header.
-	NULL,                   //Buffer list tail.
-	0,                      //nBuffListSize.
+	NULL,                   //Receiving ring.
 
 	NULL,                   //Broadcast list header.
 	NULL,                   //Broadcast list tail.
@@ -1676,6 +2006,8 @@ struct __ETHERNET_MANAGER EthernetManager = {
 
 	0,                      //nTotalEthernetBuffs.
 	0,                      //nDrvSendingQueueSz.
+	NULL,                   //pDefaultPool.
+	0,                      //nHeapDataBlocks.
 
 	Initialize,               //Initialize.
 	AddEthernetInterface,     //AddEthernetInterface.
@@ -1696,5 +2028,11 @@ struct __ETHERNET_MANAGER EthernetManager = {
 	_GetEthernetInterfaceState,    //GetEthernetInterfaceState.
 	_CreateEthernetBuffer,         //CreateEthernetBuffer.
 	_CloneEthernetBuffer,          //CloneEthernetBuffer.
-	_DestroyEthernetBuffer         //DestroyEthernetBuffer.
+	_CopyEthernetBuffer,           //CopyEthernetBuffer.
+	_DestroyEthernetBuffer,        //DestroyEthernetBuffer.
+	_CreateBufferPool,             //CreateBufferPool.
+	_DestroyBufferPool,            //DestroyBufferPool.
+	_AllocDataBlock,               //AllocDataBlock.
+	_ReleaseDataBlock,             //ReleaseDataBlock.
+	_CreateRxEthernetBuffer        //CreateRxEthernetBuffer.
 };
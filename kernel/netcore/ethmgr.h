@@ -55,6 +55,10 @@
 /* Predefine ethernet interface object. */
 struct tag__ETHERNET_INTERFACE;
 
+/* Predefine frame data block and it's pool. */
+struct tag__ETH_DATA_BLOCK;
+struct tag__ETH_BUFFER_POOL;
+
 //Ethernet buffer object,each ethernet frame corresponding one of this object.
 typedef struct tag__ETHERNET_BUFFER{
 	struct tag__ETHERNET_BUFFER* pNext;  //Pointing to next one if has.
@@ -62,13 +66,17 @@ typedef struct tag__ETHERNET_BUFFER{
 	__u8       srcMAC[ETH_MAC_LEN];      //Source MAC address.
 	__u8       dstMAC[ETH_MAC_LEN];      //Destination MAC address.
 	__u16      frame_type;
-	__u8       Buffer[ETH_DEFAULT_MTU + ETH_HEADER_LEN];  //Actual ethernet frame data.
+	__u8*      Buffer;                   //Actual ethernet frame data,resides in data block.
 	__u16      buff_length;              //Length of frame data,current is not used.
 	__u16      act_length;               //Actual buffer length.
 	__u16      buff_status;              //Status of the Ethernet Buffer.
 #define ETHERNET_BUFFER_STATUS_FREE        0x00  //Free to use.
 #define ETHERNET_BUFFER_STATUS_INITIALIZED 0x01  //Buffer is initialized.
 #define ETHERNET_BUFFER_STATUS_PENDING     0x02  //Pending in queue.
+	__u16      csum_flags;               //Checksum offload state of the frame.
+#define ETH_CSUM_IP_OK     0x0001  //IP header checksum verified by NIC.
+#define ETH_CSUM_L4_OK     0x0002  //TCP/UDP checksum verified by NIC.
+#define ETH_CSUM_TX_L4     0x0004  //TCP/UDP checksum is left to NIC.
 	//LPVOID     pEthernetInterface;       //Ethernet Interface this buffer associated to.
 
 	/*
@@ -85,8 +93,54 @@ typedef struct tag__ETHERNET_BUFFER{
 	 * interface when commit to sending.
 	 */
 	struct tag__ETHERNET_INTERFACE* pOutInterface;
+
+	/*
+	 * Data block the frame resides in,it's shared by all
+	 * ethernet buffers cloned from the same frame.NULL
+	 * means the buffer has private data,such as the send
+	 * buffer of ethernet interface.
+	 */
+	struct tag__ETH_DATA_BLOCK* pBlock;
 }__ETHERNET_BUFFER;
 
+/*
+ * Frame data block,reference counted.Ethernet driver can
+ * receive frame into data block directly,then attach it to
+ * an ethernet buffer,and cloning the ethernet buffer just
+ * increases the reference counter.
+ * The ethernet buffer embedded in block is used by the first
+ * owner,to save one memory allocation for each frame.
+ */
+typedef struct tag__ETH_DATA_BLOCK{
+	__u8       Data[ETH_MAX_FRAME_LEN];  //Must be the first member,keep it aligned.
+	unsigned long                DmaAddr;  //Physical address of Data,programmed into NIC.
+	struct tag__ETH_DATA_BLOCK*  pNext;  //Link in pool's free list.
+	struct tag__ETH_BUFFER_POOL* pPool;  //Pool it belongs to,NULL if from heap.
+	volatile int                 nRefCount;
+	BOOL                         bHeaderInuse;
+	__ETHERNET_BUFFER            Header;
+}__ETH_DATA_BLOCK;
+
+/*
+ * Preallocated data block pool,each ethernet driver can create
+ * one for it's interface.Data block will be allocated from heap
+ * if the pool runs out.
+ * Blocks are physically contiguous memory and never straddle a
+ * page boundary,so NIC can receive frame into them directly.
+ */
+typedef struct tag__ETH_BUFFER_POOL{
+	__ETH_DATA_BLOCK*  pFreeBlock;       //Free block list.
+	LPVOID             pBlockSpace;      //Memory of all blocks.
+	int                nBlockNum;
+	volatile int       nFreeNum;
+	DWORD              dwAllocTimes;
+	DWORD              dwEmptyTimes;     //Times of pool empty,block is allocated from heap.
+}__ETH_BUFFER_POOL;
+
+/* Data blocks in each pool,and block alignment. */
+#define ETH_BUFFER_POOL_SIZE   64
+#define ETH_DATA_BLOCK_ALIGN   32
+
 //Common network address,used to contain any type of network address.
 typedef struct tag__COMMON_NETWORK_ADDRESS{
 	UCHAR AddressType;
@@ -187,6 +241,11 @@ typedef struct tag__ETHERNET_INTERFACE{
 	char                    ethName[MAX_ETH_NAME_LEN + 1];
 	char                    ethMac[ETH_MAC_LEN];       //MAC address of the interface.
 	__ETHERNET_BUFFER       SendBuffer;                //First element of sending buffer.
+	__u8                    SendData[ETH_MAX_FRAME_LEN];  //Data of the sending buffer.
+	__ETH_BUFFER_POOL*      pBufferPool;               //Set by driver if it has one.
+	DWORD                   dwOffloadFlags;            //Set by driver in it's Init routine.
+#define ETH_OFFLOAD_RX_CSUM     0x0001  //Received frames are marked with ETH_CSUM_xx_OK.
+#define ETH_OFFLOAD_TX_CSUM     0x0002  //Frames with ETH_CSUM_TX_L4 are checksummed by NIC.
 	__ETH_INTERFACE_STATE   ifState;                   //Interface state info.
 	struct __PROTO_INTERFACE_BIND Proto_Interface[MAX_BIND_PROTOCOL_NUM];
 	LPVOID                  pIntExtension;             //Private information.
@@ -221,9 +280,14 @@ typedef BOOL                (*__ETHOPS_INITIALIZE)(__ETHERNET_INTERFACE*);
 //Maximal ethernet interfaces can exist in system.
 #define MAX_ETH_INTERFACE_NUM 4
 
-//Maximal ethernet buffer element in receiving list,i.e,the queue size.
+//Maximal ethernet buffer element in receiving ring,i.e,the queue size.
 #define MAX_ETH_RXBUFFLISTSZ  64
 
+//How many frames are taken from receiving ring at once,and how many
+//batches are processed before other messages get a chance.
+#define ETH_RX_BATCH_SIZE     16
+#define ETH_RX_BATCH_BUDGET   4
+
 //Maximal bridging queue list,ethernet frame cause the bridging queue
 //exceed this value will be droped and recorded.
 #define MAX_ETH_BCASTQUEUESZ  128
@@ -241,9 +305,7 @@ struct __ETHERNET_MANAGER{
 	int                     nIntIndex;          //Index of free slot in above array.
 	__KERNEL_THREAD_OBJECT* EthernetCoreThread;
 	BOOL                    bInitialized;       //Set to TRUE if successfully initialized.
-	__ETHERNET_BUFFER*      pBufferFirst;       //Received buffer list header.
-	__ETHERNET_BUFFER*      pBufferLast;        //Received buffer list tail.
-	volatile size_t         nBuffListSize;      //How many buffers in queue.
+	__RING_BUFFER*          pRxRing;            //Received buffers from NIC drivers.
 	
 	/*
 	 * Ethernet frame list to broadcast out.
@@ -272,6 +334,14 @@ struct __ETHERNET_MANAGER{
 	 */
 	volatile size_t         nDrvSendingQueueSz;
 
+	/*
+	 * Pool for the ethernet buffers not created by
+	 * driver,and how many data blocks are allocated
+	 * from heap currently.
+	 */
+	__ETH_BUFFER_POOL*      pDefaultPool;
+	volatile size_t         nHeapDataBlocks;
+
 	//Initializer of Ethernet Manager,should be called in process of system initialize.
 	BOOL(*Initialize)       (struct __ETHERNET_MANAGER*);
 
@@ -300,7 +370,21 @@ struct __ETHERNET_MANAGER{
 	BOOL                    (*GetEthernetInterfaceState)(__ETH_INTERFACE_STATE* pState, int nIndex, int* pnNextInt);
 	__ETHERNET_BUFFER*      (*CreateEthernetBuffer)(int buffer_length);
 	__ETHERNET_BUFFER*      (*CloneEthernetBuffer)(__ETHERNET_BUFFER* pEthBuff);
+	__ETHERNET_BUFFER*      (*CopyEthernetBuffer)(__ETHERNET_BUFFER* pEthBuff);  //Deep copy,frame data is private.
 	VOID                    (*DestroyEthernetBuffer)(__ETHERNET_BUFFER* pEthBuff);
+
+	/*
+	 * Data block operations,used by ethernet driver to receive
+	 * frame into data block directly.
+	 * CreateRxEthernetBuffer takes over the caller's reference
+	 * of data block,and parses the frame's header.
+	 */
+	__ETH_BUFFER_POOL*      (*CreateBufferPool)(int nBlockNum);
+	BOOL                    (*DestroyBufferPool)(__ETH_BUFFER_POOL* pPool);
+	__ETH_DATA_BLOCK*       (*AllocDataBlock)(__ETH_BUFFER_POOL* pPool);
+	VOID                    (*ReleaseDataBlock)(__ETH_DATA_BLOCK* pBlock);
+	__ETHERNET_BUFFER*      (*CreateRxEthernetBuffer)(__ETHERNET_INTERFACE* pEthInt,
+		__ETH_DATA_BLOCK* pBlock, int length);
 };
 
 //Global ethernet manager objects.
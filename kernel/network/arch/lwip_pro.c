@@ -123,6 +123,8 @@ static VOID pbuf_to_ethbuf(struct pbuf* p, __ETHERNET_BUFFER* pEthBuff)
 	pEthBuff->act_length = i;
 	pEthBuff->buff_status = ETHERNET_BUFFER_STATUS_INITIALIZED;
 	pEthBuff->frame_type = 0x800;  //Set frame type to IP.
+	//lwIP left the TCP/UDP checksum to NIC.
+	pEthBuff->csum_flags = (p->flags & PBUF_FLAG_CSUM_TX) ? ETH_CSUM_TX_L4 : 0;
 	return;
 }
 
@@ -147,6 +149,15 @@ static err_t eth_level_output(struct netif* netif, struct pbuf* p)
 		return ERR_VAL;
 	}
 
+	/*
+	 * Driver claims checksum offload in it's Init routine,which is
+	 * called after the interface is added to lwIP,so pick it up here.
+	 */
+	if (pEthInt->dwOffloadFlags & ETH_OFFLOAD_TX_CSUM)
+	{
+		netif->flags |= NETIF_FLAG_TXCSUM;
+	}
+
 	/* Use ethernet interface's default sending buffer to send the frame. */
 	pEthBuff = &pEthInt->SendBuffer;
 	pbuf_to_ethbuf(p, pEthBuff);
@@ -327,11 +338,74 @@ VOID lwipDeleteEthernetInterface(__ETHERNET_INTERFACE* pEthInt, LPVOID pL3Interf
 	return;
 }
 
+#if LWIP_SUPPORT_CUSTOM_PBUF
+/*
+ * Custom pbuf refers the frame data in ethernet buffer,so
+ * lwIP can consume the frame without copying.It holds
+ * a reference of the frame's data block until lwIP frees it.
+ */
+typedef struct tag__ETHBUF_PBUF{
+	struct pbuf_custom pc;
+	__ETHERNET_BUFFER* pEthBuff;
+}__ETHBUF_PBUF;
+
+/* Free routine of the custom pbuf,called by lwIP. */
+static void ethbuf_pbuf_free(struct pbuf* p)
+{
+	__ETHBUF_PBUF* pEthPbuf = (__ETHBUF_PBUF*)p;
+
+	EthernetManager.DestroyEthernetBuffer(pEthPbuf->pEthBuff);
+	_hx_free(pEthPbuf);
+}
+
+/*
+ * Wrap an ethernet buffer into custom pbuf,only the unicast
+ * frame exclusively owned by caller is wrapped,since lwIP may
+ * modify the frame in place,such as ARP or forwarding.
+ * NULL is returned if can not wrap,caller should copy it then.
+ */
+static struct pbuf* ethbuf_to_pbuf(__ETHERNET_BUFFER* pEthBuff)
+{
+	__ETHBUF_PBUF* pEthPbuf = NULL;
+	struct pbuf* p = NULL;
+
+	if ((NULL == pEthBuff->pBlock) || (1 != pEthBuff->pBlock->nRefCount))
+	{
+		return NULL;
+	}
+	if (pEthBuff->dstMAC[0] & 0x01)  //Broadcast or multicast.
+	{
+		return NULL;
+	}
+	pEthPbuf = (__ETHBUF_PBUF*)_hx_malloc(sizeof(__ETHBUF_PBUF));
+	if (NULL == pEthPbuf)
+	{
+		return NULL;
+	}
+	/* Refer the frame data,the caller's buffer will be destroyed after delivery. */
+	pEthPbuf->pEthBuff = EthernetManager.CloneEthernetBuffer(pEthBuff);
+	if (NULL == pEthPbuf->pEthBuff)
+	{
+		_hx_free(pEthPbuf);
+		return NULL;
+	}
+	pEthPbuf->pc.custom_free_function = ethbuf_pbuf_free;
+	p = pbuf_alloced_custom(PBUF_RAW, pEthBuff->act_length, PBUF_REF, &pEthPbuf->pc,
+		pEthPbuf->pEthBuff->Buffer, pEthBuff->act_length);
+	if (NULL == p)
+	{
+		EthernetManager.DestroyEthernetBuffer(pEthPbuf->pEthBuff);
+		_hx_free(pEthPbuf);
+	}
+	return p;
+}
+#endif //LWIP_SUPPORT_CUSTOM_PBUF
+
 //Delivery a Ethernet Frame to this protocol,a dedicated L3 interface is also provided.
 BOOL lwipDeliveryFrame(__ETHERNET_BUFFER* pEthBuff, LPVOID pL3Interface)
 {
 	struct netif* pIf = (struct netif*)pL3Interface;
-	struct pbuf*  p, *q;
+	struct pbuf*  p = NULL, *q;
 	int i = 0;
 
 	if ((NULL == pEthBuff) | (NULL == pL3Interface))
@@ -350,17 +424,32 @@ BOOL lwipDeliveryFrame(__ETHERNET_BUFFER* pEthBuff, LPVOID pL3Interface)
 		return FALSE;
 	}
 
-	p = pbuf_alloc(PBUF_RAW, pEthBuff->act_length, PBUF_POOL);
-	if (NULL == p)
+#if LWIP_SUPPORT_CUSTOM_PBUF
+	p = ethbuf_to_pbuf(pEthBuff);
+#endif
+	if (NULL == p)  //Copy the frame into pbuf.
 	{
-		IP_STATS_INC(ip.memerr);
-		return FALSE;
+		p = pbuf_alloc(PBUF_RAW, pEthBuff->act_length, PBUF_POOL);
+		if (NULL == p)
+		{
+			IP_STATS_INC(ip.memerr);
+			return FALSE;
+		}
+		i = 0;
+		for (q = p; q != NULL; q = q->next)
+		{
+			memcpy((u8_t*)q->payload, &pEthBuff->Buffer[i], q->len);
+			i = i + q->len;
+		}
 	}
-	i = 0;
-	for (q = p; q != NULL; q = q->next)
+	//Checksum verified by NIC,lwIP will skip it.
+	if (pEthBuff->csum_flags & ETH_CSUM_IP_OK)
+	{
+		p->flags |= PBUF_FLAG_CSUM_IP_OK;
+	}
+	if (pEthBuff->csum_flags & ETH_CSUM_L4_OK)
 	{
-		memcpy((u8_t*)q->payload, &pEthBuff->Buffer[i], q->len);
-		i = i + q->len;
+		p->flags |= PBUF_FLAG_CSUM_L4_OK;
 	}
 	//Delivery the packet to IP layer.
 	if (pIf->input(p, pIf) != ERR_OK)
@@ -326,7 +326,9 @@ ip_input(struct pbuf *p, struct netif *inp)
 
   /* verify checksum */
 #if CHECKSUM_CHECK_IP
-  if (inet_chksum(iphdr, iphdr_hlen) != 0) {
+  /* HelloX: skip it if the NIC has verified the header */
+  if (((p->flags & PBUF_FLAG_CSUM_IP_OK) == 0) &&
+      (inet_chksum(iphdr, iphdr_hlen) != 0)) {
 
     LWIP_DEBUGF(IP_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
       ("Checksum (0x%"X16_F") failed, IP packet dropped.\n", inet_chksum(iphdr, iphdr_hlen)));
@@ -477,6 +479,8 @@ ip_input(struct pbuf *p, struct netif *inp)
     if (p == NULL) {
       return ERR_OK;
     }
+    /* the NIC can not verify the transport checksum of a fragment */
+    p->flags &= ~PBUF_FLAG_CSUM_L4_OK;
     iphdr = (struct ip_hdr *)p->payload;
 #else /* IP_REASSEMBLY == 0, no packet fragment reassembly code present */
     pbuf_free(p);
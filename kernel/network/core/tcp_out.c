@@ -1113,6 +1113,13 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
 
   seg->tcphdr->chksum = 0;
 #if CHECKSUM_GEN_TCP
+  /* HelloX: leave the checksum to the NIC if it can fill it */
+  seg->p->flags &= ~PBUF_FLAG_CSUM_TX;
+  netif = ip_route(&(pcb->remote_ip));
+  if ((netif != NULL) &&
+      NETIF_TXCSUM_OFFLOAD(netif, &(pcb->remote_ip), seg->p->tot_len)) {
+    seg->p->flags |= PBUF_FLAG_CSUM_TX;
+  } else
 #if TCP_CHECKSUM_ON_COPY
   {
     u32_t acc;
@@ -252,7 +252,8 @@ udp_input(struct pbuf *p, struct netif *inp)
 #endif /* LWIP_UDPLITE */
     {
 #if CHECKSUM_CHECK_UDP
-      if (udphdr->chksum != 0) {
+      /* HelloX: skip it if the NIC has verified the checksum */
+      if ((udphdr->chksum != 0) && ((p->flags & PBUF_FLAG_CSUM_L4_OK) == 0)) {
         if (inet_chksum_pseudo(p, ip_current_src_addr(), ip_current_dest_addr(),
                                IP_PROTO_UDP, p->tot_len) != 0) {
           LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
@@ -630,7 +631,12 @@ udp_sendto_if_chksum(struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *dst_ip,
     udphdr->len = htons(q->tot_len);
     /* calculate checksum */
 #if CHECKSUM_GEN_UDP
-    if ((pcb->flags & UDP_FLAGS_NOCHKSUM) == 0) {
+    q->flags &= ~PBUF_FLAG_CSUM_TX;
+    if (((pcb->flags & UDP_FLAGS_NOCHKSUM) == 0) &&
+        NETIF_TXCSUM_OFFLOAD(netif, dst_ip, q->tot_len)) {
+      /* HelloX: the NIC fills it */
+      q->flags |= PBUF_FLAG_CSUM_TX;
+    } else if ((pcb->flags & UDP_FLAGS_NOCHKSUM) == 0) {
       u16_t udpchksum;
 #if LWIP_CHECKSUM_ON_COPY
       if (have_chksum) {
@@ -1038,6 +1038,10 @@ etharp_query(struct netif *netif, ip_addr_t *ipaddr, struct pbuf *q)
         if (pbuf_copy(p, q) != ERR_OK) {
           pbuf_free(p);
           p = NULL;
+        } else {
+          /* HelloX: keep the checksum offload request,the checksum of
+           * the copy is still left to the NIC. */
+          p->flags |= (q->flags & PBUF_FLAG_CSUM_TX);
         }
       }
     } else {
@@ -41,6 +41,9 @@
 #ifdef __CFG_NET_NAT
 #include "nat/nat.h"
 #endif
+#ifdef __CFG_NET_EBRG
+#include "ebridge/ethbrg.h"
+#endif
 
 #define  NETWORK_PROMPT_STR   "[network_view]"
 
@@ -71,6 +74,10 @@ static DWORD pppoe(__CMD_PARA_OBJ*);
 static DWORD nat(__CMD_PARA_OBJ*);
 #endif
 
+#ifdef __CFG_NET_EBRG                     //Bridge FDB control command.
+static DWORD fdb(__CMD_PARA_OBJ*);
+#endif
+
 //
 //The following is a map between command and it's handler.
 //
@@ -96,6 +103,9 @@ static struct __FDISK_CMD_MAP{
 #endif
 #ifdef __CFG_NET_NAT
 	{ "nat",        nat,       "  nat      : NAT control commands." },
+#endif
+#ifdef __CFG_NET_EBRG
+	{ "fdb",        fdb,       "  fdb      : Bridge forwarding database commands." },
 #endif
 	{ "help",       help,      "  help     : Print out this screen." },
 	{ "exit",       _exit,     "  exit     : Exit the application." },
@@ -498,20 +508,52 @@ static DWORD showint(__CMD_PARA_OBJ* lpCmdObj)
 
 static DWORD showdbg(__CMD_PARA_OBJ* lpCmdObj)
 {
+	__ETH_BUFFER_POOL* pPool = NULL;
+	__RING_BUFFER_STAT RxRingStat;
+	int i = 0;
+
 	/*
 	 * Dump out ethernet related statistics information
 	 * directly.
 	 */
 	_hx_printf("Total ethernet buff number: %d.\r\n",
 		EthernetManager.nTotalEthernetBuffs);
-	_hx_printf("Pending queue size: %d.\r\n",
-		EthernetManager.nBuffListSize);
+	if (EthernetManager.pRxRing)
+	{
+		EthernetManager.pRxRing->GetStat((__COMMON_OBJECT*)EthernetManager.pRxRing,
+			&RxRingStat);
+		_hx_printf("Pending queue size: %d.\r\n", RxRingStat.dwCount);
+		_hx_printf("Receiving ring drops/wakeups: %d/%d.\r\n",
+			RxRingStat.dwFullDrops, RxRingStat.dwWakeups);
+	}
 	_hx_printf("Broadcast queue size: %d.\r\n",
 		EthernetManager.nBroadcastSize);
 	_hx_printf("Total driver send_queue sz: %d.\r\n",
 		EthernetManager.nDrvSendingQueueSz);
 	_hx_printf("Droped broadcast frame: %d.\r\n",
 		EthernetManager.nDropedBcastSize);
+	_hx_printf("Heap data block number: %d.\r\n",
+		EthernetManager.nHeapDataBlocks);
+	if (EthernetManager.pDefaultPool)
+	{
+		_hx_printf("Default pool free/total: %d/%d,empty times: %d.\r\n",
+			EthernetManager.pDefaultPool->nFreeNum,
+			EthernetManager.pDefaultPool->nBlockNum,
+			EthernetManager.pDefaultPool->dwEmptyTimes);
+	}
+	for (i = 0; i < EthernetManager.nIntIndex; i++)
+	{
+		pPool = EthernetManager.EthInterfaces[i].pBufferPool;
+		if (NULL == pPool)
+		{
+			continue;
+		}
+		_hx_printf("%s pool free/total: %d/%d,empty times: %d.\r\n",
+			EthernetManager.EthInterfaces[i].ethName,
+			pPool->nFreeNum,
+			pPool->nBlockNum,
+			pPool->dwEmptyTimes);
+	}
 	return NET_CMD_SUCCESS;
 }
 
@@ -1218,3 +1260,61 @@ __TERMINAL:
 }
 
 #endif  //__CFG_NET_NAT.
+
+#ifdef __CFG_NET_EBRG
+/* Show usage of fdb command. */
+static void fdbUsage()
+{
+	_hx_printf("Usage:\r\n");
+	_hx_printf("  fdb show : Show bridge forwarding database.\r\n");
+	_hx_printf("  fdb flush [if_name] : Flush all entries or the entries of an interface.\r\n");
+	return;
+}
+
+/* Entry point of fdb command. */
+static DWORD fdb(__CMD_PARA_OBJ* lpCmdObj)
+{
+	__ETHERNET_INTERFACE* pEthInt = NULL;
+	int i = 0;
+
+	BUG_ON(NULL == lpCmdObj);
+
+	if (lpCmdObj->byParameterNum <= 1)
+	{
+		fdbUsage();
+		goto __TERMINAL;
+	}
+	if (strcmp(lpCmdObj->Parameter[1], "show") == 0)
+	{
+		Fdb_Dump();
+		goto __TERMINAL;
+	}
+	if (strcmp(lpCmdObj->Parameter[1], "flush") == 0)
+	{
+		if (lpCmdObj->byParameterNum > 2)
+		{
+			/* Locate the interface by name. */
+			for (i = 0; i < EthernetManager.nIntIndex; i++)
+			{
+				if (0 == strcmp(lpCmdObj->Parameter[2], EthernetManager.EthInterfaces[i].ethName))
+				{
+					pEthInt = &EthernetManager.EthInterfaces[i];
+					break;
+				}
+			}
+			if (NULL == pEthInt)
+			{
+				_hx_printf("  Please specify a valid interface name.\r\n");
+				goto __TERMINAL;
+			}
+		}
+		Fdb_Flush(pEthInt);
+		goto __TERMINAL;
+	}
+	fdbUsage();
+
+__TERMINAL:
+	return NET_CMD_SUCCESS;
+}
+#endif
+
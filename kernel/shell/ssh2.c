@@ -318,6 +318,20 @@ DWORD Ssh2Handler(__CMD_PARA_OBJ* lpCmdObj)
 
 	//return MemCheckHandler(lpCmdObj);
 
+	//ssh -bench,measure ciphers' throughput.
+	if(lpCmdObj->byParameterNum == 2 && strcmp(lpCmdObj->Parameter[1],"-bench") == 0)
+	{
+		ssh_cipher_bench();
+		return SHELL_CMD_PARSER_SUCCESS;
+	}
+	//ssh -bench kex,measure public key operations of handshake.
+	if(lpCmdObj->byParameterNum == 3 && strcmp(lpCmdObj->Parameter[1],"-bench") == 0 &&
+		strcmp(lpCmdObj->Parameter[2],"kex") == 0)
+	{
+		ssh_kex_bench();
+		return SHELL_CMD_PARSER_SUCCESS;
+	}
+
 	if(lpCmdObj->byParameterNum < 3)
 	{
 		PrintLine("params input error!");
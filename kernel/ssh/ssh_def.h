@@ -31,6 +31,8 @@
 #define SSH2_MSG_KEX_DH_GEX_GROUP                 31	/* 0x1f */
 #define SSH2_MSG_KEX_DH_GEX_INIT                  32	/* 0x20 */
 #define SSH2_MSG_KEX_DH_GEX_REPLY                 33	/* 0x21 */
+#define SSH2_MSG_KEX_ECDH_INIT                    30	/* 0x1e */
+#define SSH2_MSG_KEX_ECDH_REPLY                   31	/* 0x1f */
 #define SSH2_MSG_KEXRSA_PUBKEY                    30    /* 0x1e */
 #define SSH2_MSG_KEXRSA_SECRET                    31    /* 0x1f */
 #define SSH2_MSG_KEXRSA_DONE                      32    /* 0x20 */
@@ -105,7 +107,7 @@
 #define DH_MAX_SIZE								8192
 
 #define OUR_V2_MAXPKT 0x4000UL
-#define SSH2_MKKEY_ITERS (2)
+#define SSH2_MKKEY_ITERS (4)
 
 #define SSH2_TTY_OP_ISPEED 128
 #define SSH2_TTY_OP_OSPEED 129
@@ -166,6 +168,7 @@ enum {
      * SSH-2 key exchange algorithms
      */
     KEX_WARN,
+    KEX_ECDH,
     KEX_DHGROUP1,
     KEX_DHGROUP14,
     KEX_DHGEX,
@@ -184,6 +187,8 @@ enum {
     CIPHER_AES,			       /* (SSH-2 only) */
     CIPHER_DES,
     CIPHER_ARCFOUR,
+    CIPHER_AESGCM,		       /* (SSH-2 only) */
+    CIPHER_CHACHA20,		       /* (SSH-2 only) */
     CIPHER_MAX			       /* no. ciphers (inc warn) */
 };
 
@@ -200,7 +205,8 @@ typedef enum
 	SSH2_PKTCTX_NOKEX,
 	SSH2_PKTCTX_DHGROUP,
 	SSH2_PKTCTX_DHGEX,
-	SSH2_PKTCTX_RSAKEX
+	SSH2_PKTCTX_RSAKEX,
+	SSH2_PKTCTX_ECDHKEX
 } Pkt_KCtx;
 typedef enum 
 {
@@ -226,7 +232,7 @@ typedef struct
 typedef struct 
 {
 	char *name, *groupname;
-	enum { KEXTYPE_DH, KEXTYPE_RSA } main_type;
+	enum { KEXTYPE_DH, KEXTYPE_RSA, KEXTYPE_ECDH } main_type;
 	/* For DH */
 	const unsigned char *pdata, *gdata; /* NULL means group exchange */
 	int plen, glen;
@@ -284,7 +290,13 @@ typedef  struct
 	int keylen;
 	unsigned int flags;
 #define SSH_CIPHER_IS_CBC	1
+#define SSH_CIPHER_IS_AEAD	2	/* integrity by cipher, no MAC */
 	char *text_name;
+	/* whole-packet operations of AEAD ciphers */
+	int (*aead_length) (void *, unsigned char const *blk, unsigned long seq);
+	void (*aead_encrypt) (void *, unsigned char *blk, int len, unsigned long seq);
+	int (*aead_decrypt) (void *, unsigned char *blk, int len, unsigned long seq);
+	int taglen;
 }ssh2_cipher;
 
 typedef  struct  
@@ -294,6 +306,8 @@ typedef  struct
 
 }ssh2_ciphers;
 
+int aes_hw_available(void);
+
 
 typedef struct  
 {
@@ -657,6 +671,7 @@ int    random_byte(void);
 Bignum bn_power_2(int n);
 void bignum_set_bit(Bignum bn, int i, int value);
 Bignum modpow(Bignum base, Bignum exp, Bignum mod);
+Bignum modpow_simple(Bignum base, Bignum exp, Bignum mod);
 Bignum bigsub(Bignum a, Bignum b);
 
 
@@ -684,6 +699,11 @@ void        dh_cleanup(void *);
 void*       dh_setup_gex(Bignum pval, Bignum gval);
 Bignum      dh_create_e(void *, int nbits);
 
+void*       ssh_ecdhkex_newkey(const ssh_kex *kex);
+const unsigned char* ssh_ecdhkex_getpublic(void *key, int *len);
+Bignum      ssh_ecdhkex_getkey(void *key, const unsigned char *remote, int len);
+void        ssh_ecdhkex_freekey(void *key);
+
 #define snewn(n, type) ((type *)ssh_new((n)*sizeof(type)))
 #define sresize(ptr, n, type) (type *)ssh_rnew(ptr,n*sizeof(type))
 #define sfree(p) ssh_free(p)
@@ -16,8 +16,12 @@ extern  ssh_mac ssh_hmac_sha1_buggy;
 extern  ssh_kexes ssh_rsa_kex;
 
 extern   ssh2_ciphers ssh2_3des;
+extern   ssh2_ciphers ssh2_aes;
+extern   ssh2_ciphers ssh2_aesgcm;
+extern   ssh2_ciphers ssh2_ccp;
 
 extern  ssh_kexes ssh_diffiehellman_gex;
+extern  ssh_kexes ssh_ec_kex;
 
 static  ssh_signkey *hostkey_algs[] = { &ssh_rsa, &ssh_dss };
 
@@ -309,6 +313,10 @@ int ssh_step1(ssh_session*  ssh,Packet* pktin)
 			break;
 		}
 	}
+	if (s->cscipher_tobe->flags & SSH_CIPHER_IS_AEAD)
+	{
+		s->csmac_tobe = NULL;    // MAC is ignored,cipher does integrity
+	}
 	ssh_pkt_getstring(pktin, &str, &len);    // server->client mac 
 
 	if (!str) 
@@ -323,6 +331,10 @@ int ssh_step1(ssh_session*  ssh,Packet* pktin)
 			break;
 		}
 	}
+	if (s->sccipher_tobe->flags & SSH_CIPHER_IS_AEAD)
+	{
+		s->scmac_tobe = NULL;
+	}
 	ssh_pkt_getstring(pktin, &str, &len);  // client->server compression 
 	if (!str) 
 	{
@@ -416,7 +428,28 @@ int ssh_step1(ssh_session*  ssh,Packet* pktin)
             }
             ssh2_pkt_send_noqueue(ssh, s->pktout);
 		}
-	}	
+	}
+	else if (ssh->kex->main_type == KEXTYPE_ECDH)
+	{
+		const unsigned char *publicPoint;
+		int publicPointLength;
+
+		ssh->pkt_kctx = SSH2_PKTCTX_ECDHKEX;
+		ssh->kex_ctx  = ssh_ecdhkex_newkey(ssh->kex);
+		if (!ssh->kex_ctx)
+		{
+			return S_FALSE;
+		}
+
+		publicPoint = ssh_ecdhkex_getpublic(ssh->kex_ctx, &publicPointLength);
+		s->pktout = ssh2_pkt_init(SSH2_MSG_KEX_ECDH_INIT);
+		ssh2_pkt_addstring_start(s->pktout);
+		ssh2_pkt_addstring_data(s->pktout, (char*)publicPoint, publicPointLength);
+		ssh2_pkt_send_noqueue(ssh, s->pktout);
+
+		//No group negotiation,the server's reply goes to step 3 directly.
+		ssh->setup = 2;
+	}
 
 	return S_OK;
 }
@@ -444,6 +477,7 @@ static void ssh2_mkkey(ssh_session* ssh, Bignum K, unsigned char *H, char chr,	u
 {
 	ssh_hash *h = ssh->kex->hash;
 	void *s;
+	int i;
 
 	/* First hlen bytes. */
 	s = h->init();
@@ -458,17 +492,19 @@ static void ssh2_mkkey(ssh_session* ssh, Bignum K, unsigned char *H, char chr,	u
 	h->bytes(s, ssh->v2_session_id, ssh->v2_session_id_len);
 	h->final(s, keyspace);
 
-	/* Next hlen bytes. */
-	s = h->init();
-	if (!(ssh->remote_bugs & BUG_SSH2_DERIVEKEY))
+	/* Next hlen bytes,each hashes all the bytes before it. */
+	for (i = 1; i < SSH2_MKKEY_ITERS; i++)
 	{
-		hash_mpint(h, s, K);
-	}
-
-	h->bytes(s, H, h->hlen);
-	h->bytes(s, keyspace, h->hlen);
-	h->final(s, keyspace + h->hlen);
+		s = h->init();
+		if (!(ssh->remote_bugs & BUG_SSH2_DERIVEKEY))
+		{
+			hash_mpint(h, s, K);
+		}
 
+		h->bytes(s, H, h->hlen);
+		h->bytes(s, keyspace, h->hlen * i);
+		h->final(s, keyspace + h->hlen * i);
+	}
 }
 
 
@@ -661,10 +697,14 @@ int ssh_step4(ssh_session*  ssh,Packet* pktin)
     if (ssh->sc_mac_ctx)
 	{
 		ssh->scmac->free_context(ssh->sc_mac_ctx);
+		ssh->sc_mac_ctx = NULL;
 	}
 
     ssh->scmac = s->scmac_tobe;
-    ssh->sc_mac_ctx = ssh->scmac->make_context();
+    if (ssh->scmac)
+	{
+		ssh->sc_mac_ctx = ssh->scmac->make_context();
+	}
 
     if (ssh->sc_comp_ctx)
 	{
@@ -691,7 +731,8 @@ int ssh_step4(ssh_session*  ssh,Packet* pktin)
 		ssh->sccipher->setiv(ssh->sc_cipher_ctx, keyspace);
 		ssh2_mkkey(ssh,s->K,s->exchange_hash,'F',keyspace);
 		//assert(ssh->scmac->len <=	       ssh->kex->hash->hlen * SSH2_MKKEY_ITERS);
-		ssh->scmac->setkey(ssh->sc_mac_ctx, keyspace);
+		if (ssh->scmac)
+			ssh->scmac->setkey(ssh->sc_mac_ctx, keyspace);
 		smemclr(keyspace, sizeof(keyspace));
     }
 
@@ -717,6 +758,46 @@ int ssh_step4(ssh_session*  ssh,Packet* pktin)
 	return S_OK;
 }
 
+/*
+ * ECDH reply: string K_S,string Q_S,string signature. The exchange
+ * hash takes the host key,both public points and K.
+ */
+static int ssh_step3_ecdh(ssh_session* ssh,ssh2_transport_state* s,Packet* pktin)
+{
+	char *keydata;
+	int   keylen;
+	const unsigned char *publicPoint;
+	int   publicPointLength;
+
+	ssh_pkt_getstring(pktin, &keydata, &keylen);
+	if (!keydata)
+	{
+		return S_FALSE;
+	}
+	ssh_pkt_getstring(pktin, &s->sigdata, &s->siglen);
+	if (!s->sigdata)
+	{
+		return S_FALSE;
+	}
+
+	s->K = ssh_ecdhkex_getkey(ssh->kex_ctx, (unsigned char*)keydata, keylen);
+	if (!s->K)
+	{
+		ssh_ecdhkex_freekey(ssh->kex_ctx);
+		ssh->kex_ctx = NULL;
+		return S_FALSE;
+	}
+
+	hash_string(ssh->kex->hash, ssh->exhash, s->hostkeydata, s->hostkeylen);
+	publicPoint = ssh_ecdhkex_getpublic(ssh->kex_ctx, &publicPointLength);
+	hash_string(ssh->kex->hash, ssh->exhash, (void*)publicPoint, publicPointLength);
+	hash_string(ssh->kex->hash, ssh->exhash, keydata, keylen);
+	hash_mpint(ssh->kex->hash, ssh->exhash, s->K);
+
+	ssh_ecdhkex_freekey(ssh->kex_ctx);
+	return S_OK;
+}
+
 int ssh_step3(ssh_session*  ssh,Packet* pktin)
 {
 	ssh2_transport_state* s;
@@ -730,6 +811,16 @@ int ssh_step3(ssh_session*  ssh,Packet* pktin)
 		return S_FALSE;
 	}
 	s->hkey = ssh->hostkey->newkey(s->hostkeydata, s->hostkeylen);
+
+	if (ssh->kex->main_type == KEXTYPE_ECDH)
+	{
+		if (ssh_step3_ecdh(ssh, s, pktin) != S_OK)
+		{
+			return S_FALSE;
+		}
+		goto __KEX_DONE;
+	}
+
 	s->f = ssh2_pkt_getmp(pktin);
 	if (!s->f) 
 	{
@@ -776,6 +867,8 @@ int ssh_step3(ssh_session*  ssh,Packet* pktin)
      
 
 	 hash_mpint(ssh->kex->hash, ssh->exhash, s->K);	 
+
+__KEX_DONE:
 	 ssh->kex->hash->final(ssh->exhash, s->exchange_hash);
 	 ssh->kex_ctx = NULL;
 
@@ -837,10 +930,14 @@ int ssh_step3(ssh_session*  ssh,Packet* pktin)
     if (ssh->cs_mac_ctx)
 	{
 		ssh->csmac->free_context(ssh->cs_mac_ctx);
+		ssh->cs_mac_ctx = NULL;
 	}
     	
 	ssh->csmac = s->csmac_tobe;
-    ssh->cs_mac_ctx = ssh->csmac->make_context();
+    if (ssh->csmac)
+	{
+		ssh->cs_mac_ctx = ssh->csmac->make_context();
+	}
 
     if (ssh->cs_comp_ctx)
 	{
@@ -864,7 +961,8 @@ int ssh_step3(ssh_session*  ssh,Packet* pktin)
 		ssh->cscipher->setiv(ssh->cs_cipher_ctx, keyspace);
 		ssh2_mkkey(ssh,s->K,s->exchange_hash,'E',keyspace);
 		//assert(ssh->csmac->len <=	       ssh->kex->hash->hlen * SSH2_MKKEY_ITERS);
-		ssh->csmac->setkey(ssh->cs_mac_ctx, keyspace);
+		if (ssh->csmac)
+			ssh->csmac->setkey(ssh->cs_mac_ctx, keyspace);
 		smemclr(keyspace, sizeof(keyspace));
     }
 
@@ -957,10 +1055,24 @@ int ssh_init_kexinfo(ssh_session*  ssh,Packet* pkt)
 	//begin_key_exchange
 
 	// Set up the preferred key exchange
+	s->preferred_kex[s->n_preferred_kex++] =  &ssh_ec_kex;
 	s->preferred_kex[s->n_preferred_kex++] =	  &ssh_diffiehellman_gex;
 	s->preferred_kex[s->n_preferred_kex++] =  &ssh_rsa_kex;
 	
-	//Set up the preferred ciphers		
+	//Set up the preferred ciphers,AES first if the CPU accelerates it,
+	//otherwise ChaCha20 is faster than the software AES.
+	if (aes_hw_available())
+	{
+		s->preferred_ciphers[s->n_preferred_ciphers++] = &ssh2_aesgcm;
+		s->preferred_ciphers[s->n_preferred_ciphers++] = &ssh2_aes;
+		s->preferred_ciphers[s->n_preferred_ciphers++] = &ssh2_ccp;
+	}
+	else
+	{
+		s->preferred_ciphers[s->n_preferred_ciphers++] = &ssh2_ccp;
+		s->preferred_ciphers[s->n_preferred_ciphers++] = &ssh2_aesgcm;
+		s->preferred_ciphers[s->n_preferred_ciphers++] = &ssh2_aes;
+	}
 	s->preferred_ciphers[s->n_preferred_ciphers++] = &ssh2_3des;
 	
 	s->preferred_comp = &ssh_comp_none;
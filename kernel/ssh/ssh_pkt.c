@@ -9,6 +9,7 @@
 #define PKT_SETP3      3
 #define PKT_SETP4      4
 #define PKT_SETP5      5
+#define PKT_SETP6      6
 
 #define PKT_DATA_ERROR     0x100
 
@@ -89,6 +90,12 @@ Packet *ssh_read_packet(ssh_session* ssh,uint8* data,int* datalen)
 		case PKT_SETP4:
 			goto _STEP4;
 			break;
+		case PKT_SETP5:
+			goto _STEP5;
+			break;
+		case PKT_SETP6:
+			goto _STEP6;
+			break;
 	}
 
 	st->pktin   = ssh_new_packet();
@@ -175,6 +182,59 @@ Packet *ssh_read_packet(ssh_session* ssh,uint8* data,int* datalen)
 		st->pktin->maxlen  = st->packetlen + st->maclen;
 		st->pktin->data    = ssh_rnew(st->pktin->data,st->pktin->maxlen + APIEXTRA);
     } 
+	else if (ssh->sccipher && (ssh->sccipher->flags & SSH_CIPHER_IS_AEAD))
+	{
+		/*
+		 * The length field is not part of the cipher blocks,the whole
+		 * packet and the tag are read,then authenticated before any
+		 * byte is decrypted.
+		 */
+		st->maclen      = ssh->sccipher->taglen;
+		st->pktin->data = snewn(4 + APIEXTRA, unsigned char);
+
+		for (st->i = 0; st->i < 4; st->i++) 
+		{
+			_STEP5:
+			if(*datalen == 0) 
+			{
+				read_state  = PKT_SETP5;
+				goto _END;
+			}
+
+			st->pktin->data[st->i] = *data; data++; (*datalen)--;
+		}
+
+		st->len = ssh->sccipher->aead_length(ssh->sc_cipher_ctx, st->pktin->data, st->incoming_sequence);
+		if (st->len < 0 || st->len > OUR_V2_PACKETLIMIT || st->len % st->cipherblk != 0) 
+		{
+			read_state  = PKT_DATA_ERROR;
+			goto _END;
+		}
+
+		st->packetlen = st->len + 4;
+
+		st->pktin->maxlen = st->packetlen + st->maclen;
+		st->pktin->data   = ssh_rnew(st->pktin->data, st->pktin->maxlen + APIEXTRA);
+
+		for (st->i = 4; st->i < st->packetlen + st->maclen; st->i++) 
+		{
+			_STEP6:
+			if(*datalen == 0) 
+			{
+				read_state  = PKT_SETP6;
+				goto _END;
+			}
+
+			st->pktin->data[st->i] = *data; data++; (*datalen)--;
+		}
+
+		//Length field is left in clear by the decryption.
+		if (!ssh->sccipher->aead_decrypt(ssh->sc_cipher_ctx, st->pktin->data, st->packetlen, st->incoming_sequence)) 
+		{
+			read_state  = PKT_DATA_ERROR;
+			goto _END;
+		}
+	}
 	else 
 	{
 		st->pktin->data = snewn(st->cipherblk + APIEXTRA, unsigned char);
@@ -589,6 +649,7 @@ void ssh_pkt_defersend(ssh_session* ssh)
 int ssh2_pkt_construct(ssh_session* ssh, Packet *pkt)
 {
     int cipherblk, maclen, padding, i;
+    int aead, aadlen;
 
     //if (ssh->logctx)
      //   ssh2_log_outgoing_packet(ssh, pkt);
@@ -628,14 +689,19 @@ int ssh2_pkt_construct(ssh_session* ssh, Packet *pkt)
      */
     cipherblk = ssh->cscipher ? ssh->cscipher->blksize : 8;  /* block size */
     cipherblk = cipherblk < 8 ? 8 : cipherblk;	/* or 8 if blksize < 8 */
+    aead = ssh->cscipher && (ssh->cscipher->flags & SSH_CIPHER_IS_AEAD);
+    aadlen = aead ? 4 : 0;	/* AEAD ciphers don't count the length field */
     padding = 4;
     if (pkt->length + padding < pkt->forcepad)
 	padding = pkt->forcepad - pkt->length;
-    padding += 	(cipherblk - (pkt->length + padding) % cipherblk) % cipherblk;
+    padding += 	(cipherblk - (pkt->length - aadlen + padding) % cipherblk) % cipherblk;
 
     //assert(padding <= 255);
 
-    maclen = ssh->csmac ? ssh->csmac->len : 0;
+    if (aead)
+	maclen = ssh->cscipher->taglen;
+    else
+	maclen = ssh->csmac ? ssh->csmac->len : 0;
     ssh2_pkt_ensure(pkt, pkt->length + padding + maclen);
     pkt->data[4] = padding;
 
@@ -645,6 +711,16 @@ int ssh2_pkt_construct(ssh_session* ssh, Packet *pkt)
 		}
 
     PUT_32BIT(pkt->data, pkt->length + padding - 4);
+
+    if (aead)
+	{
+		/* Encrypts and appends the tag. */
+		ssh->cscipher->aead_encrypt(ssh->cs_cipher_ctx, pkt->data, pkt->length + padding, ssh->v2_outgoing_sequence);
+		ssh->v2_outgoing_sequence++;
+		pkt->encrypted_len = pkt->length + padding;
+		pkt->body = pkt->data;
+		return pkt->length + padding + maclen;
+	}
     
 	if (ssh->csmac)
 		{
@@ -0,0 +1,1095 @@
+#include "ssh_def.h"
+
+/*
+ * AES for SSH-2: aes128-ctr, aes256-ctr, aes128-gcm@openssh.com and
+ * aes256-gcm@openssh.com.
+ *
+ * Two implementations of the block function and of GHASH are provided:
+ *
+ *  - AES-NI and PCLMULQDQ,used when the CPU has both of them. The kernel
+ *    does not save XMM registers on thread switch,so the XMM registers
+ *    are only touched with interrupts disabled,in short bursts.
+ *  - A bitsliced AES and a bit-serial GHASH,used otherwise. Neither of
+ *    them looks up any table,so no key or data dependent memory access
+ *    leaks timing. The bitsliced AES encrypts two blocks at once.
+ */
+
+#define AES_MAXROUNDS  14
+#define AES_GCM_TAGLEN 16
+
+/* Blocks processed by one call of the block function. */
+#define AESNI_GROUP    4
+#define AESCT_GROUP    2
+
+/* Blocks hashed by PCLMULQDQ with interrupts disabled in one go. */
+#define GHASH_HW_BURST 256
+
+#define GET_32BIT_LSB_FIRST(cp) \
+	(((unsigned long)(unsigned char)(cp)[0]) | \
+	((unsigned long)(unsigned char)(cp)[1] << 8) | \
+	((unsigned long)(unsigned char)(cp)[2] << 16) | \
+	((unsigned long)(unsigned char)(cp)[3] << 24))
+
+#define PUT_32BIT_LSB_FIRST(cp, value) ( \
+	(cp)[0] = (unsigned char)(value), \
+	(cp)[1] = (unsigned char)((value) >> 8), \
+	(cp)[2] = (unsigned char)((value) >> 16), \
+	(cp)[3] = (unsigned char)((value) >> 24) )
+
+#if defined(__GCC__) && defined(__SSE__)
+#define AESNI_CLOBBERS , "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7"
+#else
+#define AESNI_CLOBBERS
+#endif
+
+typedef struct
+{
+	int rounds;
+	int hw;                                  /* Use AES-NI. */
+	word32 sk[(AES_MAXROUNDS + 1) * 8];      /* Bitsliced round keys. */
+	unsigned char rk[(AES_MAXROUNDS + 1) * 16]; /* Round keys for AES-NI. */
+	unsigned char iv[16];                    /* CTR counter,or GCM IV. */
+
+	/* GCM only. */
+	unsigned char H[16];                     /* Hash key. */
+	unsigned char Hr[16];                    /* Byte reversed hash key. */
+	unsigned char X[16];                     /* Hash state. */
+	unsigned char EJ0[16];                   /* Encrypted first counter block. */
+	unsigned char ctr[16];                   /* Counter of current packet. */
+} AESContext;
+
+/* ----------------------------------------------------------------------
+ * CPU support.
+ */
+
+static int aes_hw_state = -1;
+
+#ifdef __I386__
+
+static void aes_cpuid(word32 leaf, word32 *regs)
+{
+#ifdef __GCC__
+    word32 a, b, c, d;
+    __asm__ __volatile__("cpuid"
+	: "=a"(a), "=b"(b), "=c"(c), "=d"(d)
+	: "a"(leaf), "c"(0));
+    regs[0] = a;
+    regs[1] = b;
+    regs[2] = c;
+    regs[3] = d;
+#else
+    __asm{
+	push esi
+	mov eax,leaf
+	xor ecx,ecx
+	cpuid
+	mov esi,regs
+	mov dword ptr [esi],eax
+	mov dword ptr [esi + 4],ebx
+	mov dword ptr [esi + 8],ecx
+	mov dword ptr [esi + 12],edx
+	pop esi
+    }
+#endif
+}
+
+/*
+ * Set CR4.OSFXSR and CR4.OSXMMEXCPT,without them SSE instructions raise
+ * #UD. The kernel itself is built without SSE,so nothing else changes.
+ */
+static void aes_enable_sse(void)
+{
+#ifdef __GCC__
+    unsigned long cr4;
+    __asm__ __volatile__("mov %%cr4, %0" : "=r"(cr4));
+    cr4 |= (1 << 9) | (1 << 10);
+    __asm__ __volatile__("mov %0, %%cr4" : : "r"(cr4));
+#else
+    __asm{
+	mov eax,cr4
+	or eax,0x600
+	mov cr4,eax
+    }
+#endif
+}
+
+#endif /* __I386__ */
+
+/*
+ * Returns non-zero if AES-NI and PCLMULQDQ can be used.
+ */
+int aes_hw_available(void)
+{
+    if (aes_hw_state < 0) {
+	aes_hw_state = 0;
+#ifdef __I386__
+	{
+	    word32 regs[4];
+
+	    aes_cpuid(0, regs);
+	    if (regs[0] >= 1) {
+		aes_cpuid(1, regs);
+		/* AES-NI,PCLMULQDQ and SSSE3(pshufb) in ECX,FXSR and SSE2 in EDX. */
+		if ((regs[2] & (1 << 25)) && (regs[2] & (1 << 1)) &&
+		    (regs[2] & (1 << 9)) && (regs[3] & (1 << 24)) &&
+		    (regs[3] & (1 << 26))) {
+		    aes_enable_sse();
+		    aes_hw_state = 1;
+		}
+	    }
+	}
+#endif
+    }
+    return aes_hw_state;
+}
+
+/* ----------------------------------------------------------------------
+ * Bitsliced AES. Eight words hold two blocks,word i holds bit i of every
+ * byte,so the S-box is evaluated as a boolean circuit on all 32 bytes.
+ */
+
+static void aes_ct_sbox(word32 *q)
+{
+    word32 x0, x1, x2, x3, x4, x5, x6, x7;
+    word32 y1, y2, y3, y4, y5, y6, y7, y8, y9;
+    word32 y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+    word32 y20, y21;
+    word32 z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    word32 z10, z11, z12, z13, z14, z15, z16, z17;
+    word32 t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    word32 t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    word32 t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    word32 t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    word32 t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    word32 t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    word32 t60, t61, t62, t63, t64, t65, t66, t67;
+    word32 s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    /* Top linear transformation. */
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    /* Non-linear section,inversion in GF(2^8). */
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    /* Bottom linear transformation. */
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+#define SWAPN(cl, ch, s, x, y) do { \
+	word32 a_, b_; \
+	a_ = (x); b_ = (y); \
+	(x) = (a_ & (word32)(cl)) | ((b_ & (word32)(cl)) << (s)); \
+	(y) = ((a_ & (word32)(ch)) >> (s)) | (b_ & (word32)(ch)); \
+    } while (0)
+
+#define SWAP2(x, y) SWAPN(0x55555555, 0xAAAAAAAA, 1, x, y)
+#define SWAP4(x, y) SWAPN(0x33333333, 0xCCCCCCCC, 2, x, y)
+#define SWAP8(x, y) SWAPN(0x0F0F0F0F, 0xF0F0F0F0, 4, x, y)
+
+/*
+ * Convert between byte order and bitsliced order,it's own inverse.
+ */
+static void aes_ct_ortho(word32 *q)
+{
+    SWAP2(q[0], q[1]);
+    SWAP2(q[2], q[3]);
+    SWAP2(q[4], q[5]);
+    SWAP2(q[6], q[7]);
+
+    SWAP4(q[0], q[2]);
+    SWAP4(q[1], q[3]);
+    SWAP4(q[4], q[6]);
+    SWAP4(q[5], q[7]);
+
+    SWAP8(q[0], q[4]);
+    SWAP8(q[1], q[5]);
+    SWAP8(q[2], q[6]);
+    SWAP8(q[3], q[7]);
+}
+
+static void aes_ct_shift_rows(word32 *q)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+	word32 x = q[i];
+
+	q[i] = (x & 0x000000FF)
+	    | ((x & 0x0000FC00) >> 2) | ((x & 0x00000300) << 6)
+	    | ((x & 0x00F00000) >> 4) | ((x & 0x000F0000) << 4)
+	    | ((x & 0xC0000000) >> 6) | ((x & 0x3F000000) << 2);
+    }
+}
+
+#define ROTR16(x) (((x) << 16) | ((x) >> 16))
+
+static void aes_ct_mix_columns(word32 *q)
+{
+    word32 q0, q1, q2, q3, q4, q5, q6, q7;
+    word32 r0, r1, r2, r3, r4, r5, r6, r7;
+
+    q0 = q[0]; q1 = q[1]; q2 = q[2]; q3 = q[3];
+    q4 = q[4]; q5 = q[5]; q6 = q[6]; q7 = q[7];
+    r0 = (q0 >> 8) | (q0 << 24);
+    r1 = (q1 >> 8) | (q1 << 24);
+    r2 = (q2 >> 8) | (q2 << 24);
+    r3 = (q3 >> 8) | (q3 << 24);
+    r4 = (q4 >> 8) | (q4 << 24);
+    r5 = (q5 >> 8) | (q5 << 24);
+    r6 = (q6 >> 8) | (q6 << 24);
+    r7 = (q7 >> 8) | (q7 << 24);
+
+    q[0] = q7 ^ r7 ^ r0 ^ ROTR16(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ ROTR16(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ ROTR16(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ ROTR16(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ ROTR16(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ ROTR16(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ ROTR16(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ ROTR16(q7 ^ r7);
+}
+
+static void aes_ct_add_round_key(word32 *q, const word32 *sk)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+	q[i] ^= sk[i];
+}
+
+/*
+ * Encrypt two blocks in place.
+ */
+static void aes_ct_encrypt2(AESContext *ctx, unsigned char *b0, unsigned char *b1)
+{
+    word32 q[8];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+	q[i * 2] = GET_32BIT_LSB_FIRST(b0 + i * 4);
+	q[i * 2 + 1] = GET_32BIT_LSB_FIRST(b1 + i * 4);
+    }
+    aes_ct_ortho(q);
+
+    aes_ct_add_round_key(q, ctx->sk);
+    for (i = 1; i < ctx->rounds; i++) {
+	aes_ct_sbox(q);
+	aes_ct_shift_rows(q);
+	aes_ct_mix_columns(q);
+	aes_ct_add_round_key(q, ctx->sk + i * 8);
+    }
+    aes_ct_sbox(q);
+    aes_ct_shift_rows(q);
+    aes_ct_add_round_key(q, ctx->sk + ctx->rounds * 8);
+
+    aes_ct_ortho(q);
+    for (i = 0; i < 4; i++) {
+	PUT_32BIT_LSB_FIRST(b0 + i * 4, q[i * 2]);
+	PUT_32BIT_LSB_FIRST(b1 + i * 4, q[i * 2 + 1]);
+    }
+    smemclr(q, sizeof(q));
+}
+
+static word32 aes_sub_word(word32 x)
+{
+    word32 q[8];
+
+    memset(q, 0, sizeof(q));
+    q[0] = x;
+    aes_ct_ortho(q);
+    aes_ct_sbox(q);
+    aes_ct_ortho(q);
+    x = q[0];
+    smemclr(q, sizeof(q));
+    return x;
+}
+
+/*
+ * Key schedule,fills both the bitsliced and the AES-NI round keys.
+ * Words are in little-endian byte order,so RotWord is a right rotation.
+ */
+static void aes_setup(AESContext *ctx, unsigned char *key, int keylen)
+{
+    static const unsigned char rcon[] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+    };
+    word32 w[(AES_MAXROUNDS + 1) * 4];
+    word32 dup[(AES_MAXROUNDS + 1) * 8];
+    word32 tmp, x, y;
+    int nk, nkf, i, j, k;
+
+    nk = keylen / 4;
+    ctx->rounds = nk + 6;
+    ctx->hw = aes_hw_available();
+    nkf = (ctx->rounds + 1) * 4;
+
+    for (i = 0; i < nk; i++)
+	w[i] = GET_32BIT_LSB_FIRST(key + i * 4);
+    tmp = w[nk - 1];
+    for (i = nk, j = 0, k = 0; i < nkf; i++) {
+	if (j == 0) {
+	    tmp = (tmp << 24) | (tmp >> 8);
+	    tmp = aes_sub_word(tmp) ^ rcon[k];
+	} else if (nk > 6 && j == 4) {
+	    tmp = aes_sub_word(tmp);
+	}
+	tmp ^= w[i - nk];
+	w[i] = tmp;
+	if (++j == nk) {
+	    j = 0;
+	    k++;
+	}
+    }
+
+    /* Round keys for AES-NI,in plain byte order. */
+    for (i = 0; i < nkf; i++)
+	PUT_32BIT_LSB_FIRST(ctx->rk + i * 4, w[i]);
+
+    /* Bitsliced round keys,the same key is used for both blocks. */
+    for (i = 0; i < nkf; i++)
+	dup[i * 2] = dup[i * 2 + 1] = w[i];
+    for (i = 0; i < nkf; i += 4)
+	aes_ct_ortho(dup + i * 2);
+    for (i = 0; i < nkf; i++) {
+	x = y = (dup[i * 2] & 0x55555555) | (dup[i * 2 + 1] & 0xAAAAAAAA);
+	x &= 0x55555555;
+	y &= 0xAAAAAAAA;
+	ctx->sk[i * 2] = x | (x << 1);
+	ctx->sk[i * 2 + 1] = y | (y >> 1);
+    }
+
+    smemclr(w, sizeof(w));
+    smemclr(dup, sizeof(dup));
+}
+
+/* ----------------------------------------------------------------------
+ * AES-NI and PCLMULQDQ.
+ */
+
+#ifdef __I386__
+
+/*
+ * Encrypt four blocks in place,interrupts must be disabled.
+ */
+static void aesni_encrypt4(const unsigned char *rk, int rounds, unsigned char *blk)
+{
+#ifdef __GCC__
+    int n = rounds - 1;
+
+    __asm__ __volatile__(
+	"movdqu (%0), %%xmm4\n\t"
+	"movdqu (%2), %%xmm0\n\t"
+	"movdqu 16(%2), %%xmm1\n\t"
+	"movdqu 32(%2), %%xmm2\n\t"
+	"movdqu 48(%2), %%xmm3\n\t"
+	"pxor %%xmm4, %%xmm0\n\t"
+	"pxor %%xmm4, %%xmm1\n\t"
+	"pxor %%xmm4, %%xmm2\n\t"
+	"pxor %%xmm4, %%xmm3\n\t"
+	"1:\n\t"
+	"add $16, %0\n\t"
+	"movdqu (%0), %%xmm4\n\t"
+	"aesenc %%xmm4, %%xmm0\n\t"
+	"aesenc %%xmm4, %%xmm1\n\t"
+	"aesenc %%xmm4, %%xmm2\n\t"
+	"aesenc %%xmm4, %%xmm3\n\t"
+	"dec %1\n\t"
+	"jnz 1b\n\t"
+	"movdqu 16(%0), %%xmm4\n\t"
+	"aesenclast %%xmm4, %%xmm0\n\t"
+	"aesenclast %%xmm4, %%xmm1\n\t"
+	"aesenclast %%xmm4, %%xmm2\n\t"
+	"aesenclast %%xmm4, %%xmm3\n\t"
+	"movdqu %%xmm0, (%2)\n\t"
+	"movdqu %%xmm1, 16(%2)\n\t"
+	"movdqu %%xmm2, 32(%2)\n\t"
+	"movdqu %%xmm3, 48(%2)\n\t"
+	: "+r"(rk), "+r"(n)
+	: "r"(blk)
+	: "memory", "cc" AESNI_CLOBBERS);
+#else
+    __asm{
+	push esi
+	push edi
+	mov esi,rk
+	mov edi,blk
+	mov ecx,rounds
+	dec ecx
+	movdqu xmm4,[esi]
+	movdqu xmm0,[edi]
+	movdqu xmm1,[edi + 16]
+	movdqu xmm2,[edi + 32]
+	movdqu xmm3,[edi + 48]
+	pxor xmm0,xmm4
+	pxor xmm1,xmm4
+	pxor xmm2,xmm4
+	pxor xmm3,xmm4
+__aesni_round:
+	add esi,16
+	movdqu xmm4,[esi]
+	aesenc xmm0,xmm4
+	aesenc xmm1,xmm4
+	aesenc xmm2,xmm4
+	aesenc xmm3,xmm4
+	dec ecx
+	jnz __aesni_round
+	movdqu xmm4,[esi + 16]
+	aesenclast xmm0,xmm4
+	aesenclast xmm1,xmm4
+	aesenclast xmm2,xmm4
+	aesenclast xmm3,xmm4
+	movdqu [edi],xmm0
+	movdqu [edi + 16],xmm1
+	movdqu [edi + 32],xmm2
+	movdqu [edi + 48],xmm3
+	pop edi
+	pop esi
+    }
+#endif
+}
+
+static const unsigned char ghash_bswap_mask[16] = {
+    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+};
+
+/*
+ * X = (X ^ B[0]) * H ... (X ^ B[n-1]) * H,by carry-less multiplication on
+ * byte reversed values,then the 256-bit product is shifted left by one
+ * bit and reduced by x^128 + x^7 + x^2 + x + 1. Interrupts must be
+ * disabled.
+ */
+static void pclmul_ghash(unsigned char *x, const unsigned char *hr,
+			 const unsigned char *blk, int n)
+{
+    const unsigned char *mask = ghash_bswap_mask;
+
+#ifdef __GCC__
+    __asm__ __volatile__(
+	"movdqu (%3), %%xmm7\n\t"
+	"movdqu (%0), %%xmm0\n\t"
+	"pshufb %%xmm7, %%xmm0\n\t"
+	"1:\n\t"
+	"movdqu (%3), %%xmm7\n\t"
+	"movdqu (%2), %%xmm2\n\t"
+	"pshufb %%xmm7, %%xmm2\n\t"
+	"pxor %%xmm2, %%xmm0\n\t"
+	"movdqu (%1), %%xmm1\n\t"
+	/* Product of 128 x 128 bits in xmm6:xmm3. */
+	"movdqa %%xmm0, %%xmm3\n\t"
+	"pclmulqdq $0x00, %%xmm1, %%xmm3\n\t"
+	"movdqa %%xmm0, %%xmm4\n\t"
+	"pclmulqdq $0x10, %%xmm1, %%xmm4\n\t"
+	"movdqa %%xmm0, %%xmm5\n\t"
+	"pclmulqdq $0x01, %%xmm1, %%xmm5\n\t"
+	"movdqa %%xmm0, %%xmm6\n\t"
+	"pclmulqdq $0x11, %%xmm1, %%xmm6\n\t"
+	"pxor %%xmm5, %%xmm4\n\t"
+	"movdqa %%xmm4, %%xmm5\n\t"
+	"psrldq $8, %%xmm4\n\t"
+	"pslldq $8, %%xmm5\n\t"
+	"pxor %%xmm5, %%xmm3\n\t"
+	"pxor %%xmm4, %%xmm6\n\t"
+	/* Shift left by one bit. */
+	"movdqa %%xmm3, %%xmm7\n\t"
+	"movdqa %%xmm6, %%xmm2\n\t"
+	"pslld $1, %%xmm3\n\t"
+	"pslld $1, %%xmm6\n\t"
+	"psrld $31, %%xmm7\n\t"
+	"psrld $31, %%xmm2\n\t"
+	"movdqa %%xmm7, %%xmm1\n\t"
+	"pslldq $4, %%xmm2\n\t"
+	"pslldq $4, %%xmm7\n\t"
+	"psrldq $12, %%xmm1\n\t"
+	"por %%xmm7, %%xmm3\n\t"
+	"por %%xmm2, %%xmm6\n\t"
+	"por %%xmm1, %%xmm6\n\t"
+	/* Reduction. */
+	"movdqa %%xmm3, %%xmm7\n\t"
+	"movdqa %%xmm3, %%xmm2\n\t"
+	"movdqa %%xmm3, %%xmm1\n\t"
+	"pslld $31, %%xmm7\n\t"
+	"pslld $30, %%xmm2\n\t"
+	"pslld $25, %%xmm1\n\t"
+	"pxor %%xmm2, %%xmm7\n\t"
+	"pxor %%xmm1, %%xmm7\n\t"
+	"movdqa %%xmm7, %%xmm2\n\t"
+	"pslldq $12, %%xmm7\n\t"
+	"psrldq $4, %%xmm2\n\t"
+	"pxor %%xmm7, %%xmm3\n\t"
+	"movdqa %%xmm3, %%xmm0\n\t"
+	"movdqa %%xmm3, %%xmm4\n\t"
+	"movdqa %%xmm3, %%xmm5\n\t"
+	"psrld $1, %%xmm0\n\t"
+	"psrld $2, %%xmm4\n\t"
+	"psrld $7, %%xmm5\n\t"
+	"pxor %%xmm4, %%xmm0\n\t"
+	"pxor %%xmm5, %%xmm0\n\t"
+	"pxor %%xmm2, %%xmm0\n\t"
+	"pxor %%xmm0, %%xmm3\n\t"
+	"pxor %%xmm3, %%xmm6\n\t"
+	"movdqa %%xmm6, %%xmm0\n\t"
+	"add $16, %2\n\t"
+	"dec %4\n\t"
+	"jnz 1b\n\t"
+	"movdqu (%3), %%xmm7\n\t"
+	"pshufb %%xmm7, %%xmm0\n\t"
+	"movdqu %%xmm0, (%0)\n\t"
+	: "+r"(x), "+r"(hr), "+r"(blk), "+r"(mask), "+r"(n)
+	:
+	: "memory", "cc" AESNI_CLOBBERS);
+#else
+    __asm{
+	push esi
+	push edi
+	push ebx
+	mov esi,x
+	mov edi,blk
+	mov edx,hr
+	mov ebx,mask
+	mov ecx,n
+	movdqu xmm7,[ebx]
+	movdqu xmm0,[esi]
+	pshufb xmm0,xmm7
+__ghash_block:
+	movdqu xmm7,[ebx]
+	movdqu xmm2,[edi]
+	pshufb xmm2,xmm7
+	pxor xmm0,xmm2
+	movdqu xmm1,[edx]
+	movdqa xmm3,xmm0
+	pclmulqdq xmm3,xmm1,0x00
+	movdqa xmm4,xmm0
+	pclmulqdq xmm4,xmm1,0x10
+	movdqa xmm5,xmm0
+	pclmulqdq xmm5,xmm1,0x01
+	movdqa xmm6,xmm0
+	pclmulqdq xmm6,xmm1,0x11
+	pxor xmm4,xmm5
+	movdqa xmm5,xmm4
+	psrldq xmm4,8
+	pslldq xmm5,8
+	pxor xmm3,xmm5
+	pxor xmm6,xmm4
+	movdqa xmm7,xmm3
+	movdqa xmm2,xmm6
+	pslld xmm3,1
+	pslld xmm6,1
+	psrld xmm7,31
+	psrld xmm2,31
+	movdqa xmm1,xmm7
+	pslldq xmm2,4
+	pslldq xmm7,4
+	psrldq xmm1,12
+	por xmm3,xmm7
+	por xmm6,xmm2
+	por xmm6,xmm1
+	movdqa xmm7,xmm3
+	movdqa xmm2,xmm3
+	movdqa xmm1,xmm3
+	pslld xmm7,31
+	pslld xmm2,30
+	pslld xmm1,25
+	pxor xmm7,xmm2
+	pxor xmm7,xmm1
+	movdqa xmm2,xmm7
+	pslldq xmm7,12
+	psrldq xmm2,4
+	pxor xmm3,xmm7
+	movdqa xmm0,xmm3
+	movdqa xmm4,xmm3
+	movdqa xmm5,xmm3
+	psrld xmm0,1
+	psrld xmm4,2
+	psrld xmm5,7
+	pxor xmm0,xmm4
+	pxor xmm0,xmm5
+	pxor xmm0,xmm2
+	pxor xmm3,xmm0
+	pxor xmm6,xmm3
+	movdqa xmm0,xmm6
+	add edi,16
+	dec ecx
+	jnz __ghash_block
+	movdqu xmm7,[ebx]
+	pshufb xmm0,xmm7
+	movdqu [esi],xmm0
+	pop ebx
+	pop edi
+	pop esi
+    }
+#endif
+}
+
+#endif /* __I386__ */
+
+/* ----------------------------------------------------------------------
+ * Modes shared by both implementations.
+ */
+
+/*
+ * Encrypt n(at most AESNI_GROUP) blocks in place.
+ */
+static void aes_encrypt_blocks(AESContext *ctx, unsigned char *blk, int n)
+{
+#ifdef __I386__
+    if (ctx->hw) {
+	DWORD dwFlags;
+
+	__ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	aesni_encrypt4(ctx->rk, ctx->rounds, blk);
+	__LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	return;
+    }
+#endif
+    aes_ct_encrypt2(ctx, blk, blk + 16);
+    if (n > AESCT_GROUP)
+	aes_ct_encrypt2(ctx, blk + 32, blk + 48);
+}
+
+/*
+ * Counter mode,the whole 128-bit counter is incremented for SSH CTR
+ * mode and only the last 32 bits for GCM.
+ */
+static void aes_ctr_crypt(AESContext *ctx, unsigned char *ctr,
+			  unsigned char *blk, int len, int inc32)
+{
+    unsigned char ks[AESNI_GROUP * 16];
+    int group = ctx->hw ? AESNI_GROUP : AESCT_GROUP;
+    int n, i, j;
+
+    while (len > 0) {
+	n = (len + 15) / 16;
+	if (n > group)
+	    n = group;
+	for (i = 0; i < n; i++) {
+	    memcpy(ks + i * 16, ctr, 16);
+	    for (j = 15; j >= (inc32 ? 12 : 0); j--)
+		if (++ctr[j] != 0)
+		    break;
+	}
+	aes_encrypt_blocks(ctx, ks, n);
+	for (i = 0; i < n * 16 && i < len; i++)
+	    blk[i] ^= ks[i];
+	blk += n * 16;
+	len -= n * 16;
+    }
+    smemclr(ks, sizeof(ks));
+}
+
+/*
+ * GHASH multiplication in constant time,X = X * H,bit by bit from the
+ * most significant bit as GCM defines it.
+ */
+static void ghash_mul_ct(unsigned char *x, const unsigned char *h)
+{
+    word32 z0 = 0, z1 = 0, z2 = 0, z3 = 0;
+    word32 v0, v1, v2, v3, m, xw[4];
+    int i;
+
+    for (i = 0; i < 4; i++)
+	xw[i] = GET_32BIT_MSB_FIRST(x + i * 4);
+    v0 = GET_32BIT_MSB_FIRST(h);
+    v1 = GET_32BIT_MSB_FIRST(h + 4);
+    v2 = GET_32BIT_MSB_FIRST(h + 8);
+    v3 = GET_32BIT_MSB_FIRST(h + 12);
+
+    for (i = 0; i < 128; i++) {
+	m = 0 - ((xw[i >> 5] >> (31 - (i & 31))) & 1);
+	z0 ^= v0 & m;
+	z1 ^= v1 & m;
+	z2 ^= v2 & m;
+	z3 ^= v3 & m;
+	m = 0 - (v3 & 1);
+	v3 = (v3 >> 1) | (v2 << 31);
+	v2 = (v2 >> 1) | (v1 << 31);
+	v1 = (v1 >> 1) | (v0 << 31);
+	v0 = (v0 >> 1) ^ (0xE1000000 & m);
+    }
+
+    PUT_32BIT_MSB_FIRST(x, z0);
+    PUT_32BIT_MSB_FIRST(x + 4, z1);
+    PUT_32BIT_MSB_FIRST(x + 8, z2);
+    PUT_32BIT_MSB_FIRST(x + 12, z3);
+}
+
+/*
+ * Hash len bytes into GCM state,the last partial block is padded by zero.
+ */
+static void gcm_ghash(AESContext *ctx, const unsigned char *blk, int len)
+{
+    unsigned char last[16];
+    int n, i;
+
+#ifdef __I386__
+    if (ctx->hw) {
+	DWORD dwFlags;
+
+	while (len >= 16) {
+	    n = len / 16;
+	    if (n > GHASH_HW_BURST)
+		n = GHASH_HW_BURST;
+	    __ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	    pclmul_ghash(ctx->X, ctx->Hr, blk, n);
+	    __LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	    blk += n * 16;
+	    len -= n * 16;
+	}
+	if (len > 0) {
+	    memset(last, 0, sizeof(last));
+	    memcpy(last, blk, len);
+	    __ENTER_CRITICAL_SECTION(NULL, dwFlags);
+	    pclmul_ghash(ctx->X, ctx->Hr, last, 1);
+	    __LEAVE_CRITICAL_SECTION(NULL, dwFlags);
+	}
+	return;
+    }
+#endif
+    while (len > 0) {
+	n = len < 16 ? len : 16;
+	for (i = 0; i < n; i++)
+	    ctx->X[i] ^= blk[i];
+	ghash_mul_ct(ctx->X, ctx->H);
+	blk += n;
+	len -= n;
+    }
+}
+
+/* ----------------------------------------------------------------------
+ * SSH-2 cipher interface.
+ */
+
+static void *aes_make_context(void)
+{
+    AESContext *ctx = snewn(1, AESContext);
+
+    memset(ctx, 0, sizeof(AESContext));
+    return ctx;
+}
+
+static void aes_free_context(void *handle)
+{
+    smemclr(handle, sizeof(AESContext));
+    sfree(handle);
+}
+
+static void aes128_key(void *handle, unsigned char *key)
+{
+    aes_setup((AESContext *)handle, key, 16);
+}
+
+static void aes256_key(void *handle, unsigned char *key)
+{
+    aes_setup((AESContext *)handle, key, 32);
+}
+
+static void aes_iv(void *handle, unsigned char *iv)
+{
+    AESContext *ctx = (AESContext *)handle;
+
+    memcpy(ctx->iv, iv, 16);
+}
+
+static void aes_ssh2_sdctr(void *handle, unsigned char *blk, int len)
+{
+    AESContext *ctx = (AESContext *)handle;
+
+    aes_ctr_crypt(ctx, ctx->iv, blk, len, FALSE);
+}
+
+/*
+ * The hash key of GCM depends on the cipher key only,it's computed when
+ * the key is set. Key is always set before IV in SSH-2.
+ */
+static void aes_gcm_key(void *handle, unsigned char *key, int keylen)
+{
+    AESContext *ctx = (AESContext *)handle;
+    unsigned char blk[AESNI_GROUP * 16];
+    int i;
+
+    aes_setup(ctx, key, keylen);
+    memset(blk, 0, sizeof(blk));
+    aes_encrypt_blocks(ctx, blk, 1);
+    memcpy(ctx->H, blk, 16);
+    for (i = 0; i < 16; i++)
+	ctx->Hr[i] = ctx->H[15 - i];
+    smemclr(blk, sizeof(blk));
+}
+
+static void aes128_gcm_key(void *handle, unsigned char *key)
+{
+    aes_gcm_key(handle, key, 16);
+}
+
+static void aes256_gcm_key(void *handle, unsigned char *key)
+{
+    aes_gcm_key(handle, key, 32);
+}
+
+/*
+ * IV of aes-gcm@openssh.com is 12 bytes,a fixed field of 4 bytes and an
+ * invocation counter of 8 bytes,which is incremented for each packet.
+ */
+static void aes_gcm_iv(void *handle, unsigned char *iv)
+{
+    AESContext *ctx = (AESContext *)handle;
+
+    memcpy(ctx->iv, iv, 12);
+}
+
+/*
+ * Start a packet: reset hash state,compute E(K,J0) and the first
+ * counter block.
+ */
+static void aes_gcm_start(AESContext *ctx)
+{
+    unsigned char blk[AESNI_GROUP * 16];
+
+    memset(ctx->X, 0, 16);
+    memcpy(blk, ctx->iv, 12);
+    PUT_32BIT_MSB_FIRST(blk + 12, 1);
+    memcpy(ctx->ctr, blk, 16);
+    ctx->ctr[15] = 2;
+    aes_encrypt_blocks(ctx, blk, 1);
+    memcpy(ctx->EJ0, blk, 16);
+    smemclr(blk, sizeof(blk));
+}
+
+/*
+ * Finish a packet: hash the lengths,compute the tag and step the
+ * invocation counter.
+ */
+static void aes_gcm_finish(AESContext *ctx, int aadlen, int len, unsigned char *tag)
+{
+    unsigned char lens[16];
+    int i;
+
+    memset(lens, 0, sizeof(lens));
+    PUT_32BIT_MSB_FIRST(lens + 4, aadlen * 8);
+    PUT_32BIT_MSB_FIRST(lens + 12, len * 8);
+    gcm_ghash(ctx, lens, 16);
+    for (i = 0; i < AES_GCM_TAGLEN; i++)
+	tag[i] = ctx->X[i] ^ ctx->EJ0[i];
+
+    for (i = 11; i >= 4; i--)
+	if (++ctx->iv[i] != 0)
+	    break;
+}
+
+/*
+ * The packet length field is not encrypted in GCM,it's the additional
+ * authenticated data.
+ */
+static int aes_gcm_length(void *handle, unsigned char const *blk, unsigned long seq)
+{
+    return toint(GET_32BIT(blk));
+}
+
+static void aes_gcm_encrypt(void *handle, unsigned char *blk, int len, unsigned long seq)
+{
+    AESContext *ctx = (AESContext *)handle;
+
+    aes_gcm_start(ctx);
+    gcm_ghash(ctx, blk, 4);
+    aes_ctr_crypt(ctx, ctx->ctr, blk + 4, len - 4, TRUE);
+    gcm_ghash(ctx, blk + 4, len - 4);
+    aes_gcm_finish(ctx, 4, len - 4, blk + len);
+}
+
+static int aes_gcm_decrypt(void *handle, unsigned char *blk, int len, unsigned long seq)
+{
+    AESContext *ctx = (AESContext *)handle;
+    unsigned char tag[AES_GCM_TAGLEN];
+    int ok;
+
+    aes_gcm_start(ctx);
+    gcm_ghash(ctx, blk, 4);
+    gcm_ghash(ctx, blk + 4, len - 4);
+    aes_gcm_finish(ctx, 4, len - 4, tag);
+    ok = smemeq(tag, blk + len, AES_GCM_TAGLEN);
+    if (ok)
+	aes_ctr_crypt(ctx, ctx->ctr, blk + 4, len - 4, TRUE);
+    smemclr(tag, sizeof(tag));
+    return ok;
+}
+
+static ssh2_cipher ssh_aes128_ctr = {
+    aes_make_context, aes_free_context, aes_iv, aes128_key,
+    aes_ssh2_sdctr, aes_ssh2_sdctr,
+    "aes128-ctr",
+    16, 128, 0, "AES-128 SDCTR"
+};
+
+static ssh2_cipher ssh_aes256_ctr = {
+    aes_make_context, aes_free_context, aes_iv, aes256_key,
+    aes_ssh2_sdctr, aes_ssh2_sdctr,
+    "aes256-ctr",
+    16, 256, 0, "AES-256 SDCTR"
+};
+
+static ssh2_cipher ssh_aes128_gcm = {
+    aes_make_context, aes_free_context, aes_gcm_iv, aes128_gcm_key,
+    NULL, NULL,
+    "aes128-gcm@openssh.com",
+    16, 128, SSH_CIPHER_IS_AEAD, "AES-128 GCM",
+    aes_gcm_length, aes_gcm_encrypt, aes_gcm_decrypt, AES_GCM_TAGLEN
+};
+
+static ssh2_cipher ssh_aes256_gcm = {
+    aes_make_context, aes_free_context, aes_gcm_iv, aes256_gcm_key,
+    NULL, NULL,
+    "aes256-gcm@openssh.com",
+    16, 256, SSH_CIPHER_IS_AEAD, "AES-256 GCM",
+    aes_gcm_length, aes_gcm_encrypt, aes_gcm_decrypt, AES_GCM_TAGLEN
+};
+
+static ssh2_cipher *const aes_list[] = {
+    &ssh_aes256_ctr,
+    &ssh_aes128_ctr
+};
+
+ssh2_ciphers ssh2_aes = {
+    sizeof(aes_list) / sizeof(*aes_list),
+    aes_list
+};
+
+static ssh2_cipher *const aesgcm_list[] = {
+    &ssh_aes256_gcm,
+    &ssh_aes128_gcm
+};
+
+ssh2_ciphers ssh2_aesgcm = {
+    sizeof(aesgcm_list) / sizeof(*aesgcm_list),
+    aesgcm_list
+};
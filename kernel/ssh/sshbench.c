@@ -0,0 +1,218 @@
+
+#ifndef __STDAFX_H__
+#include <StdAfx.h>
+#endif
+
+#include "ssh_def.h"
+#include "ssh/ssh.h"
+
+/*
+ * Throughput of the SSH-2 ciphers,measured on packets of the maximal
+ * size we send,with the same calls the packet layer makes,and cost
+ * of the public key operations of a handshake.
+ */
+
+#define BENCH_PKTLEN   OUR_V2_MAXPKT
+#define BENCH_TICKS    20
+
+extern ssh2_ciphers ssh2_3des;
+extern ssh2_ciphers ssh2_aes;
+extern ssh2_ciphers ssh2_aesgcm;
+extern ssh2_ciphers ssh2_ccp;
+
+static ssh2_ciphers *bench_ciphers[] = {
+    &ssh2_aesgcm, &ssh2_aes, &ssh2_ccp, &ssh2_3des
+};
+
+/*
+ * Encrypt packets for BENCH_TICKS clock ticks,returns KB/s.
+ */
+static unsigned long bench_cipher(ssh2_cipher *c, unsigned char *pkt)
+{
+    unsigned char key[64];
+    void *ctx;
+    DWORD dwStartTick, dwEndTick;
+    unsigned long seq = 0, bytes = 0;
+    int i;
+
+    for (i = 0; i < sizeof(key); i++)
+	key[i] = (unsigned char)i;
+    ctx = c->make_context();
+    c->setkey(ctx, key);
+    c->setiv(ctx, key);
+    memset(pkt, 0x5A, BENCH_PKTLEN + 16);
+
+    //Start measuring at a tick boundary.
+    dwStartTick = System.GetClockTickCounter((__COMMON_OBJECT*)&System);
+    while (dwStartTick == System.GetClockTickCounter((__COMMON_OBJECT*)&System));
+    dwStartTick = System.GetClockTickCounter((__COMMON_OBJECT*)&System);
+    dwEndTick = dwStartTick;
+    while (dwEndTick - dwStartTick < BENCH_TICKS) {
+	PUT_32BIT(pkt, BENCH_PKTLEN - 4);
+	if (c->flags & SSH_CIPHER_IS_AEAD)
+	    c->aead_encrypt(ctx, pkt, BENCH_PKTLEN, seq++);
+	else
+	    c->encrypt(ctx, pkt, BENCH_PKTLEN);
+	bytes += BENCH_PKTLEN;
+	dwEndTick = System.GetClockTickCounter((__COMMON_OBJECT*)&System);
+    }
+    c->free_context(ctx);
+
+    return (bytes / ((dwEndTick - dwStartTick) * SYSTEM_TIME_SLICE)) * 1000 / 1024;
+}
+
+int ssh_cipher_bench(void)
+{
+    unsigned char *pkt;
+    unsigned long kbps;
+    int i, j;
+
+    pkt = snewn(BENCH_PKTLEN + 16, unsigned char);
+    if (!pkt)
+	return SSH_ERROR;
+
+    _hx_printf("  AES: %s\r\n", aes_hw_available() ?
+	       "AES-NI and PCLMULQDQ" : "constant time software");
+    _hx_printf("  %-32s %-10s\r\n", "cipher", "KB/s");
+    for (i = 0; i < lenof(bench_ciphers); i++) {
+	for (j = 0; j < bench_ciphers[i]->nciphers; j++) {
+	    kbps = bench_cipher(bench_ciphers[i]->list[j], pkt);
+	    _hx_printf("  %-32s %-10d\r\n", bench_ciphers[i]->list[j]->name, kbps);
+	}
+    }
+    _hx_printf("  Packets of %d bytes,MAC of non-AEAD ciphers is not counted.\r\n",
+	       BENCH_PKTLEN);
+
+    sfree(pkt);
+    return SSH_ERROR_NO;
+}
+
+/*
+ * Cost of the key exchange. Both ends of the handshake run here,the
+ * server side standing in for a real peer,so it's the CPU time of
+ * the public key operations only,without network round trips.
+ */
+typedef void (*bench_op)(void *ctx);
+
+/*
+ * Run op for BENCH_TICKS clock ticks,returns microseconds per call.
+ */
+static unsigned long bench_op_time(bench_op op, void *ctx)
+{
+    DWORD dwStartTick, dwEndTick;
+    unsigned long count = 0;
+
+    dwStartTick = System.GetClockTickCounter((__COMMON_OBJECT*)&System);
+    while (dwStartTick == System.GetClockTickCounter((__COMMON_OBJECT*)&System));
+    dwStartTick = System.GetClockTickCounter((__COMMON_OBJECT*)&System);
+    dwEndTick = dwStartTick;
+    while (dwEndTick - dwStartTick < BENCH_TICKS) {
+	op(ctx);
+	count++;
+	dwEndTick = System.GetClockTickCounter((__COMMON_OBJECT*)&System);
+    }
+    return (dwEndTick - dwStartTick) * SYSTEM_TIME_SLICE * 1000 / count;
+}
+
+/*
+ * Client and server key pairs and both shared secrets,the whole
+ * curve25519 exchange.
+ */
+static void bench_ecdh(void *ctx)
+{
+    void *client, *server;
+    const unsigned char *pub;
+    Bignum K1, K2;
+    int len;
+
+    client = ssh_ecdhkex_newkey((const ssh_kex *)ctx);
+    server = ssh_ecdhkex_newkey((const ssh_kex *)ctx);
+    pub = ssh_ecdhkex_getpublic(server, &len);
+    K1 = ssh_ecdhkex_getkey(client, pub, len);
+    pub = ssh_ecdhkex_getpublic(client, &len);
+    K2 = ssh_ecdhkex_getkey(server, pub, len);
+    if (K1)
+	freebn(K1);
+    if (K2)
+	freebn(K2);
+    ssh_ecdhkex_freekey(client);
+    ssh_ecdhkex_freekey(server);
+}
+
+typedef struct
+{
+    Bignum base, exp, mod;
+    Bignum (*pow)(Bignum, Bignum, Bignum);
+}bench_pow_ctx;
+
+/*
+ * One side of a finite field DH exchange is two exponentiations,
+ * e = g^x and K = f^x.
+ */
+static void bench_dh(void *ctx)
+{
+    bench_pow_ctx *c = (bench_pow_ctx *)ctx;
+    freebn(c->pow(c->base, c->exp, c->mod));
+    freebn(c->pow(c->base, c->exp, c->mod));
+}
+
+static void bench_pow(void *ctx)
+{
+    bench_pow_ctx *c = (bench_pow_ctx *)ctx;
+    freebn(c->pow(c->base, c->exp, c->mod));
+}
+
+static Bignum bench_random_bn(int nbytes)
+{
+    unsigned char *buf;
+    Bignum ret;
+    int i;
+
+    buf = snewn(nbytes, unsigned char);
+    for (i = 0; i < nbytes; i++)
+	buf[i] = (unsigned char)random_byte();
+    buf[0] |= 0x80;
+    buf[nbytes - 1] |= 1;
+    ret = bignum_from_bytes(buf, nbytes);
+    sfree(buf);
+    return ret;
+}
+
+extern ssh_kexes ssh_ec_kex;
+
+int ssh_kex_bench(void)
+{
+    static const unsigned char e65537[] = { 0x01, 0x00, 0x01 };
+    bench_pow_ctx c;
+    unsigned long us;
+
+    _hx_printf("  %-40s %-10s\r\n", "operation", "us");
+
+    us = bench_op_time(bench_ecdh, (void *)ssh_ec_kex.list[0]);
+    _hx_printf("  %-40s %-10d\r\n", "curve25519 exchange,both sides", us);
+
+    //2048 bits group with the 512 bits exponent the group exchange
+    //asks for,by Montgomery with sliding window and by the plain
+    //square and multiply.
+    c.mod = bench_random_bn(256);
+    c.base = bench_random_bn(255);
+    c.exp = bench_random_bn(64);
+    c.pow = modpow;
+    us = bench_op_time(bench_dh, &c);
+    _hx_printf("  %-40s %-10d\r\n", "dh-gex 2048 one side,modpow", us);
+    c.pow = modpow_simple;
+    us = bench_op_time(bench_dh, &c);
+    _hx_printf("  %-40s %-10d\r\n", "dh-gex 2048 one side,modpow_simple", us);
+
+    //Host key signature check,RSA 2048 with e = 65537.
+    freebn(c.exp);
+    c.exp = bignum_from_bytes(e65537, sizeof(e65537));
+    c.pow = modpow;
+    us = bench_op_time(bench_pow, &c);
+    _hx_printf("  %-40s %-10d\r\n", "rsa 2048 verify", us);
+
+    freebn(c.mod);
+    freebn(c.base);
+    freebn(c.exp);
+    return SSH_ERROR_NO;
+}
@@ -14,6 +14,7 @@ Bignum modmul(Bignum p, Bignum q, Bignum mod);
 void bignum_set_bit(Bignum bn, int bitnum, int value);
 Bignum bigmod(Bignum a, Bignum b);
 Bignum modinv(Bignum number, Bignum modulus);
+int bignum_bit(Bignum bn, int i);
 /*
  * The Bignum format is an array of `BignumInt'. The first
  * element of the array counts the remaining elements. The
@@ -123,6 +124,89 @@ static void internal_sub(const BignumInt *a, const BignumInt *b,
     }
 }
 
+/*
+ * Add the double width t into the three word column accumulator
+ * c2:c1:c0. t must not exceed (2^BIGNUM_INT_BITS - 1)^2.
+ */
+#define COMBA_ADD(t, c0, c1, c2) do { \
+    (t) += (c0); \
+    (c0) = (BignumInt)(t); \
+    (t) = ((t) >> BIGNUM_INT_BITS) + (c1); \
+    (c1) = (BignumInt)(t); \
+    (c2) += (BignumInt)((t) >> BIGNUM_INT_BITS); \
+} while (0)
+
+/*
+ * Comba multiplication,the O(N^2) base case of internal_mul. The
+ * product is built column by column from the least significant one,
+ * summing every a_i * b_j with i + j equal to the column in a three
+ * word accumulator,so each word of c is written only once and no
+ * carry is propagated along the rows.
+ */
+static void internal_mul_comba(const BignumInt *a, const BignumInt *b,
+                               BignumInt *c, int len)
+{
+    const BignumInt *al = a + len - 1, *bl = b + len - 1; /* least significant */
+    BignumInt c0 = 0, c1 = 0, c2 = 0;
+    BignumDblInt t;
+    int i, k, lo, hi;
+
+    for (k = 0; k < 2*len - 1; k++) {
+        lo = (k < len ? 0 : k - len + 1);
+        hi = (k < len ? k : len - 1);
+        for (i = lo; i <= hi; i++) {
+            t = MUL_WORD(al[-i], bl[i - k]);
+            COMBA_ADD(t, c0, c1, c2);
+        }
+        c[2*len - 1 - k] = c0;
+        c0 = c1;
+        c1 = c2;
+        c2 = 0;
+    }
+    c[0] = c0;
+}
+
+/*
+ * Comba squaring. Every product a_i * a_j with i != j appears twice in
+ * a column,so it is computed once,summed separately and doubled,which
+ * saves nearly half of the multiplications.
+ */
+static void internal_sqr_comba(const BignumInt *a, BignumInt *c, int len)
+{
+    const BignumInt *al = a + len - 1;
+    BignumInt c0 = 0, c1 = 0, c2 = 0;
+    BignumInt d0, d1, d2;
+    BignumDblInt t;
+    int i, k, lo;
+
+    for (k = 0; k < 2*len - 1; k++) {
+        lo = (k < len ? 0 : k - len + 1);
+        d0 = d1 = d2 = 0;
+        for (i = lo; i < k - i; i++) {
+            t = MUL_WORD(al[-i], al[i - k]);
+            COMBA_ADD(t, d0, d1, d2);
+        }
+        d2 = (d2 << 1) | (d1 >> (BIGNUM_INT_BITS - 1));
+        d1 = (d1 << 1) | (d0 >> (BIGNUM_INT_BITS - 1));
+        d0 = d0 << 1;
+        if (!(k & 1)) {
+            t = MUL_WORD(al[-(k/2)], al[-(k/2)]);
+            COMBA_ADD(t, d0, d1, d2);
+        }
+        t = (BignumDblInt)c0 + d0;
+        c0 = (BignumInt)t;
+        t = (t >> BIGNUM_INT_BITS) + c1 + d1;
+        c1 = (BignumInt)t;
+        c2 += d2 + (BignumInt)(t >> BIGNUM_INT_BITS);
+
+        c[2*len - 1 - k] = c0;
+        c0 = c1;
+        c1 = c2;
+        c2 = 0;
+    }
+    c[0] = c0;
+}
+
 /*
  * Compute c = a * b.
  * Input is in the first len words of a and b.
@@ -327,190 +411,77 @@ static void internal_mul(const BignumInt *a, const BignumInt *b,
 #endif
 
     } else {
-        int i;
-        BignumInt carry;
-        BignumDblInt t;
-        const BignumInt *ap, *bp;
-        BignumInt *cp, *cps;
-
-        /*
-         * Multiply in the ordinary O(N^2) way.
-         */
-
-        for (i = 0; i < 2 * len; i++)
-            c[i] = 0;
-
-        for (cps = c + 2*len, ap = a + len; ap-- > a; cps--) {
-            carry = 0;
-            for (cp = cps, bp = b + len; cp--, bp-- > b ;) {
-                t = (MUL_WORD(*ap, *bp) + carry) + *cp;
-                *cp = (BignumInt) t;
-                carry = (BignumInt)(t >> BIGNUM_INT_BITS);
-            }
-            *cp = carry;
-        }
+        internal_mul_comba(a, b, c, len);
     }
 }
 
 /*
- * Variant form of internal_mul used for the initial step of
- * Montgomery reduction. Only bothers outputting 'len' words
- * (everything above that is thrown away).
+ * Compute c = a * a,the same layout as internal_mul.
  */
-static void internal_mul_low(const BignumInt *a, const BignumInt *b,
-                             BignumInt *c, int len, BignumInt *scratch)
+static void internal_sqr(const BignumInt *a, BignumInt *c, int len,
+                         BignumInt *scratch)
 {
-    if (len > KARATSUBA_THRESHOLD) {
-        int i;
-
-        /*
-         * Karatsuba-aware version of internal_mul_low. As before, we
-         * express each input value as a shifted combination of two
-         * halves:
-         *
-         *   a = a_1 D + a_0
-         *   b = b_1 D + b_0
-         *
-         * Then the full product is, as before,
-         *
-         *  ab = a_1 b_1 D^2 + (a_1 b_0 + a_0 b_1) D + a_0 b_0
-         *
-         * Provided we choose D on the large side (so that a_0 and b_0
-         * are _at least_ as long as a_1 and b_1), we don't need the
-         * topmost term at all, and we only need half of the middle
-         * term. So there's no point in doing the proper Karatsuba
-         * optimisation which computes the middle term using the top
-         * one, because we'd take as long computing the top one as
-         * just computing the middle one directly.
-         *
-         * So instead, we do a much more obvious thing: we call the
-         * fully optimised internal_mul to compute a_0 b_0, and we
-         * recursively call ourself to compute the _bottom halves_ of
-         * a_1 b_0 and a_0 b_1, each of which we add into the result
-         * in the obvious way.
-         *
-         * In other words, there's no actual Karatsuba _optimisation_
-         * in this function; the only benefit in doing it this way is
-         * that we call internal_mul proper for a large part of the
-         * work, and _that_ can optimise its operation.
-         */
-
-        int toplen = len/2, botlen = len - toplen; /* botlen is the bigger */
-
-        /*
-         * Scratch space for the various bits and pieces we're going
-         * to be adding together: we need botlen*2 words for a_0 b_0
-         * (though we may end up throwing away its topmost word), and
-         * toplen words for each of a_1 b_0 and a_0 b_1. That adds up
-         * to exactly 2*len.
-         */
-
-        /* a_0 b_0 */
-        internal_mul(a + toplen, b + toplen, scratch + 2*toplen, botlen,
-                     scratch + 2*len);
-
-        /* a_1 b_0 */
-        internal_mul_low(a, b + len - toplen, scratch + toplen, toplen,
-                         scratch + 2*len);
-
-        /* a_0 b_1 */
-        internal_mul_low(a + len - toplen, b, scratch, toplen,
-                         scratch + 2*len);
-
-        /* Copy the bottom half of the big coefficient into place */
-        for (i = 0; i < botlen; i++)
-            c[toplen + i] = scratch[2*toplen + botlen + i];
-
-        /* Add the two small coefficients, throwing away the returned carry */
-        internal_add(scratch, scratch + toplen, scratch, toplen);
-
-        /* And add that to the large coefficient, leaving the result in c. */
-        internal_add(scratch, scratch + 2*toplen + botlen - toplen,
-                     c, toplen);
-
-    } else {
-        int i;
-        BignumInt carry;
-        BignumDblInt t;
-        const BignumInt *ap, *bp;
-        BignumInt *cp, *cps;
-
-        /*
-         * Multiply in the ordinary O(N^2) way.
-         */
-
-        for (i = 0; i < len; i++)
-            c[i] = 0;
-
-        for (cps = c + len, ap = a + len; ap-- > a; cps--) {
-            carry = 0;
-            for (cp = cps, bp = b + len; bp--, cp-- > c ;) {
-                t = (MUL_WORD(*ap, *bp) + carry) + *cp;
-                *cp = (BignumInt) t;
-                carry = (BignumInt)(t >> BIGNUM_INT_BITS);
-            }
-        }
-    }
+    if (len > KARATSUBA_THRESHOLD)
+        internal_mul(a, a, c, len, scratch);
+    else
+        internal_sqr_comba(a, c, len);
 }
 
 /*
  * Montgomery reduction. Expects x to be a big-endian array of 2*len
  * BignumInts whose value satisfies 0 <= x < rn (where r = 2^(len *
- * BIGNUM_INT_BITS) is the Montgomery base). Returns in the same array
- * a value x' which is congruent to xr^{-1} mod n, and satisfies 0 <=
- * x' < n.
+ * BIGNUM_INT_BITS) is the Montgomery base). Returns in the least
+ * significant half of the array a value x' which is congruent to
+ * xr^{-1} mod n,and satisfies 0 <= x' < n,the most significant half
+ * is zeroed.
  *
- * 'n' and 'mninv' should be big-endian arrays of 'len' BignumInts
- * each, containing respectively n and the multiplicative inverse of
- * -n mod r.
+ * 'n' is a big-endian array of 'len' BignumInts,'n0inv' is the
+ * inverse of -n mod 2^BIGNUM_INT_BITS.
  *
- * 'tmp' is an array of BignumInt used as scratch space, of length at
- * least 3*len + mul_compute_scratch(len).
+ * The reduction is done word by word: each step adds the multiple of
+ * n which clears the lowest remaining word of x. This costs len^2
+ * multiplications,where a full multiply of m = x * (-n)^{-1} mod r
+ * followed by m * n costs half as much again.
  */
 static void monty_reduce(BignumInt *x, const BignumInt *n,
-                         const BignumInt *mninv, BignumInt *tmp, int len)
+                         BignumInt n0inv, int len)
 {
-    int i;
-    BignumInt carry;
-
-    /*
-     * Multiply x by (-n)^{-1} mod r. This gives us a value m such
-     * that mn is congruent to -x mod r. Hence, mn+x is an exact
-     * multiple of r, and is also (obviously) congruent to x mod n.
-     */
-    internal_mul_low(x + len, mninv, tmp, len, tmp + 3*len);
+    BignumInt *xp, *p, m, carry, top = 0;
+    BignumDblInt t;
+    int i, j;
+
+    for (i = 0; i < len; i++) {
+        xp = x + 2*len - 1 - i;        /* word i of x */
+        m = *xp * n0inv;
+        carry = 0;
+        for (j = 0; j < len; j++) {
+            t = MUL_WORD(m, n[len - 1 - j]) + xp[-j] + carry;
+            xp[-j] = (BignumInt)t;
+            carry = (BignumInt)(t >> BIGNUM_INT_BITS);
+        }
+        for (p = xp - len; carry && p >= x; p--) {
+            t = (BignumDblInt)*p + carry;
+            *p = (BignumInt)t;
+            carry = (BignumInt)(t >> BIGNUM_INT_BITS);
+        }
+        top += carry;
+    }
 
-    /*
-     * Compute t = (mn+x)/r in ordinary, non-modular, integer
-     * arithmetic. By construction this is exact, and is congruent mod
-     * n to x * r^{-1}, i.e. the answer we want.
-     *
-     * The following multiply leaves that answer in the _most_
-     * significant half of the 'x' array, so then we must shift it
-     * down.
-     */
-    internal_mul(tmp, n, tmp+len, len, tmp + 3*len);
-    carry = internal_add(x, tmp+len, x, 2*len);
     for (i = 0; i < len; i++)
         x[len + i] = x[i], x[i] = 0;
 
     /*
      * Reduce t mod n. This doesn't require a full-on division by n,
-     * but merely a test and single optional subtraction, since we can
-     * show that 0 <= t < 2n.
-     *
-     * Proof:
-     *  + we computed m mod r, so 0 <= m < r.
-     *  + so 0 <= mn < rn, obviously
-     *  + hence we only need 0 <= x < rn to guarantee that 0 <= mn+x < 2rn
-     *  + yielding 0 <= (mn+x)/r < 2n as required.
+     * but merely a test and single optional subtraction: the sum of
+     * the multiples of n added is mn with 0 <= m < r,so we have
+     * 0 <= x + mn < 2rn and hence 0 <= t < 2n.
      */
-    if (!carry) {
+    if (!top) {
         for (i = 0; i < len; i++)
             if (x[len + i] != n[i])
                 break;
     }
-    if (carry || i >= len || x[len + i] > n[i])
+    if (top || i >= len || x[len + i] > n[i])
         internal_sub(x+len, n, x+len, len);
 }
 
@@ -758,21 +729,37 @@ Bignum modpow_simple(Bignum base_in, Bignum exp, Bignum mod)
     return result;
 }
 
+/*
+ * Window width of modpow for an exponent of 'bits' bits,chosen to
+ * minimise the multiplications of precomputing and of the scan.
+ */
+static int modpow_window(int bits)
+{
+    if (bits > 671) return 6;
+    if (bits > 239) return 5;
+    if (bits > 79) return 4;
+    if (bits > 23) return 3;
+    return 1;
+}
+
 /*
  * Compute (base ^ exp) % mod. Uses the Montgomery multiplication
  * technique where possible, falling back to modpow_simple otherwise.
+ *
+ * All values stay in Montgomery form until the end. The exponent is
+ * scanned from the top by a sliding window of up to 'w' bits,which
+ * always starts and ends with a set bit,so only the odd powers
+ * base^1,base^3 ... base^(2^w - 1) are precomputed and one
+ * multiplication is made per window instead of per set bit.
  */
 Bignum modpow(Bignum base_in, Bignum exp, Bignum mod)
 {
-    BignumInt *a, *b, *x, *n, *mninv, *scratch;
-    int len, scratchlen, i, j;
-    Bignum base, base2, r, rn, inv, result;
+    BignumInt *a, *b, *t, *n, *tab, *scratch;
+    BignumInt n0, n0inv;
+    int len, scratchlen, ntab, w, bits, i, j, k, started;
+    unsigned val;
+    Bignum base, base2, r, result;
 
-    /*
-     * The most significant word of mod needs to be non-zero. It
-     * should already be, but let's make sure.
-     */
-    
     /*
      * mod had better be odd, or we can't do Montgomery multiplication
      * using a power of two at all.
@@ -787,104 +774,114 @@ Bignum modpow(Bignum base_in, Bignum exp, Bignum mod)
     base = bigmod(base_in, mod);
 
     /*
-     * Compute the inverse of n mod r, for monty_reduce. (In fact we
-     * want the inverse of _minus_ n mod r, but we'll sort that out
-     * below.)
+     * Only the lowest word of -n^{-1} mod r is needed by monty_reduce,
+     * it's computed by Newton's iteration,each step doubles the number
+     * of correct low bits and n0 itself is right in the low 3 bits.
      */
     len = mod[0];
-    r = bn_power_2(BIGNUM_INT_BITS * len);
-    inv = modinv(mod, r);
-
+    n0 = mod[1];
+    n0inv = n0;
+    for (i = 0; i < 5; i++)
+        n0inv *= 2 - n0 * n0inv;
+    n0inv = 0 - n0inv;
 
     /*
      * Multiply the base by r mod n, to get it into Montgomery
      * representation.
      */
+    r = bn_power_2(BIGNUM_INT_BITS * len);
     base2 = modmul(base, r, mod);
     freebn(base);
+    freebn(r);
     base = base2;
 
-    rn = bigmod(r, mod);               /* r mod n, i.e. Montgomerified 1 */
-
-    freebn(r);                         /* won't need this any more */
-
-    /*
-     * Set up internal arrays of the right lengths, in big-endian
-     * format, containing the base, the modulus, and the modulus's
-     * inverse.
-     */
     n = snewn(len, BignumInt);
     for (j = 0; j < len; j++)
 	n[len - 1 - j] = mod[j + 1];
 
-    mninv = snewn(len, BignumInt);
-    for (j = 0; j < len; j++)
-	mninv[len - 1 - j] = (j < (int)inv[0] ? inv[j + 1] : 0);
-    freebn(inv);         /* we don't need this copy of it any more */
-    /* Now negate mninv mod r, so it's the inverse of -n rather than +n. */
-    x = snewn(len, BignumInt);
-    for (j = 0; j < len; j++)
-        x[j] = 0;
-    internal_sub(x, mninv, mninv, len);
-
-    /* x = snewn(len, BignumInt); */ /* already done above */
-    for (j = 0; j < len; j++)
-	x[len - 1 - j] = (j < (int)base[0] ? base[j + 1] : 0);
-    freebn(base);        /* we don't need this copy of it any more */
-
     a = snewn(2*len, BignumInt);
     b = snewn(2*len, BignumInt);
-    for (j = 0; j < len; j++)
-	a[2*len - 1 - j] = (j < (int)rn[0] ? rn[j + 1] : 0);
-    freebn(rn);
-
-    /* Scratch space for multiplies */
-    scratchlen = 3*len + mul_compute_scratch(len);
+    scratchlen = mul_compute_scratch(len);
     scratch = snewn(scratchlen, BignumInt);
 
-    /* Skip leading zero bits of exp. */
-    i = 0;
-    j = BIGNUM_INT_BITS-1;
-    while (i < (int)exp[0] && (exp[exp[0] - i] & ((BignumInt)1 << j)) == 0) {
-	j--;
-	if (j < 0) {
-	    i++;
-	    j = BIGNUM_INT_BITS-1;
-	}
+    /*
+     * Table of odd powers,entry k holds base^(2k+1),built by
+     * multiplying with base^2.
+     */
+    bits = bignum_bitcount(exp);
+    w = modpow_window(bits);
+    ntab = 1 << (w - 1);
+    tab = snewn(ntab * len, BignumInt);
+    for (j = 0; j < len; j++)
+	tab[len - 1 - j] = (j < (int)base[0] ? base[j + 1] : 0);
+    freebn(base);
+    if (ntab > 1) {
+        internal_sqr(tab, b, len, scratch);
+        monty_reduce(b, n, n0inv, len);
+        for (k = 1; k < ntab; k++) {
+            internal_mul(tab + (k - 1) * len, b + len, a, len, scratch);
+            monty_reduce(a, n, n0inv, len);
+            for (j = 0; j < len; j++)
+                tab[k * len + j] = a[len + j];
+        }
     }
 
     /* Main computation */
-    while (i < (int)exp[0]) {
-	while (j >= 0) {
-	    internal_mul(a + len, a + len, b, len, scratch);
-            monty_reduce(b, n, mninv, scratch, len);
-	    if ((exp[exp[0] - i] & ((BignumInt)1 << j)) != 0) {
-                internal_mul(b + len, x, a, len,  scratch);
-                monty_reduce(a, n, mninv, scratch, len);
-	    } else {
-		BignumInt *t;
-		t = a;
-		a = b;
-		b = t;
-	    }
-	    j--;
-	}
-	i++;
-	j = BIGNUM_INT_BITS-1;
+    started = 0;
+    for (i = bits - 1; i >= 0; ) {
+        if (!bignum_bit(exp, i)) {
+            internal_sqr(a + len, b, len, scratch);
+            monty_reduce(b, n, n0inv, len);
+            t = a; a = b; b = t;
+            i--;
+            continue;
+        }
+
+        /* Longest window from bit i ending with a set bit. */
+        j = i - w + 1;
+        if (j < 0)
+            j = 0;
+        while (!bignum_bit(exp, j))
+            j++;
+        for (val = 0, k = i; k >= j; k--)
+            val = (val << 1) | bignum_bit(exp, k);
+
+        if (!started) {
+            for (k = 0; k < len; k++) {
+                a[k] = 0;
+                a[len + k] = tab[(val >> 1) * len + k];
+            }
+            started = 1;
+        } else {
+            for (k = i; k >= j; k--) {
+                internal_sqr(a + len, b, len, scratch);
+                monty_reduce(b, n, n0inv, len);
+                t = a; a = b; b = t;
+            }
+            internal_mul(a + len, tab + (val >> 1) * len, b, len, scratch);
+            monty_reduce(b, n, n0inv, len);
+            t = a; a = b; b = t;
+        }
+        i = j - 1;
     }
 
-    /*
-     * Final monty_reduce to get back from the adjusted Montgomery
-     * representation.
-     */
-    monty_reduce(a, n, mninv, scratch, len);
+    if (!started) {
+        /* exp is 0. */
+        result = bigmod(One, mod);
+    } else {
+        /*
+         * Final monty_reduce to get back from the Montgomery
+         * representation.
+         */
+        monty_reduce(a, n, n0inv, len);
 
-    /* Copy result to buffer */
-    result = newbn(mod[0]);
-    for (i = 0; i < len; i++)
-	result[result[0] - i] = a[i + len];
-    while (result[0] > 1 && result[result[0]] == 0)
-	result[0]--;
+        /* Copy result to buffer */
+        result = newbn(mod[0]);
+        for (i = 0; i < len; i++)
+            result[result[0] - i] = a[i + len];
+        while (result[0] > 1 && result[result[0]] == 0)
+            result[0]--;
+    }
 
     /* Free temporary arrays */
     smemclr(scratch, scratchlen * sizeof(*scratch));
@@ -893,12 +890,10 @@ Bignum modpow(Bignum base_in, Bignum exp, Bignum mod)
     sfree(a);
     smemclr(b, 2 * len * sizeof(*b));
     sfree(b);
-    smemclr(mninv, len * sizeof(*mninv));
-    sfree(mninv);
+    smemclr(tab, ntab * len * sizeof(*tab));
+    sfree(tab);
     smemclr(n, len * sizeof(*n));
     sfree(n);
-    smemclr(x, len * sizeof(*x));
-    sfree(x);
 
     return result;
 }
@@ -1724,8 +1719,45 @@ char *bignum_decimal(Bignum x)
 }
 
 
+/*
+ * Random bytes for key generation. There is no entropy device,so
+ * the pool is stirred with the time stamp counter on every refill,
+ * the low bits of which are unpredictable across the interrupts and
+ * scheduling between calls. Output is the SHA-256 of the pool state,
+ * the previous output and a counter,32 bytes at a time.
+ */
+static unsigned char random_pool[32];
+static unsigned char random_out[32];
+static int random_left = 0;
+static unsigned long random_counter = 0;
+
 int random_byte(void)
-{    
-	return 0;
+{
+    SHA256_State s;
+    __U64 tsc;
+    DWORD dwTick;
+
+    if (random_left == 0) {
+	__GetTsc(&tsc);
+	dwTick = System.GetClockTickCounter((__COMMON_OBJECT*)&System);
+	random_counter++;
+
+	SHA256_Init(&s);
+	SHA256_Bytes(&s, random_pool, sizeof(random_pool));
+	SHA256_Bytes(&s, &tsc, sizeof(tsc));
+	SHA256_Bytes(&s, &dwTick, sizeof(dwTick));
+	SHA256_Bytes(&s, &random_counter, sizeof(random_counter));
+	SHA256_Final(&s, random_pool);
+
+	//Output is derived from the pool one way,so it can't be
+	//used to recover the next pool state.
+	SHA256_Init(&s);
+	SHA256_Bytes(&s, "out", 3);
+	SHA256_Bytes(&s, random_pool, sizeof(random_pool));
+	SHA256_Final(&s, random_out);
+	smemclr(&s, sizeof(s));
+	random_left = sizeof(random_out);
+    }
+    return random_out[--random_left];
 }
 
@@ -0,0 +1,361 @@
+#include "ssh_def.h"
+
+/*
+ * chacha20-poly1305@openssh.com,as described by PROTOCOL.chacha20poly1305
+ * of OpenSSH.
+ *
+ * The 64 bytes key is two ChaCha20 keys,the first one encrypts the
+ * payload and the second one encrypts the packet length only. The nonce
+ * of both is the packet sequence number. The Poly1305 key of a packet is
+ * the first 32 bytes of the payload key stream,the payload is encrypted
+ * from block 1 on. The tag covers the encrypted length and payload.
+ *
+ * Both algorithms are made of add,xor and rotate on 32-bit words,so they
+ * run in constant time without any CPU support.
+ */
+
+#define CCP_TAGLEN 16
+
+typedef unsigned __int64 word64;
+
+#define GET_32BIT_LSB_FIRST(cp) \
+	(((unsigned long)(unsigned char)(cp)[0]) | \
+	((unsigned long)(unsigned char)(cp)[1] << 8) | \
+	((unsigned long)(unsigned char)(cp)[2] << 16) | \
+	((unsigned long)(unsigned char)(cp)[3] << 24))
+
+#define PUT_32BIT_LSB_FIRST(cp, value) ( \
+	(cp)[0] = (unsigned char)(value), \
+	(cp)[1] = (unsigned char)((value) >> 8), \
+	(cp)[2] = (unsigned char)((value) >> 16), \
+	(cp)[3] = (unsigned char)((value) >> 24) )
+
+typedef struct
+{
+	word32 state[16];
+} ChaChaState;
+
+typedef struct
+{
+	ChaChaState main;       /* Payload and Poly1305 key. */
+	ChaChaState header;     /* Packet length. */
+} CCPContext;
+
+/* ----------------------------------------------------------------------
+ * ChaCha20.
+ */
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d) \
+	a += b; d ^= a; d = ROTL32(d, 16); \
+	c += d; b ^= c; b = ROTL32(b, 12); \
+	a += b; d ^= a; d = ROTL32(d, 8); \
+	c += d; b ^= c; b = ROTL32(b, 7);
+
+static void chacha20_key(ChaChaState *cs, const unsigned char *key)
+{
+    int i;
+
+    cs->state[0] = 0x61707865;	       /* "expand 32-byte k" */
+    cs->state[1] = 0x3320646e;
+    cs->state[2] = 0x79622d32;
+    cs->state[3] = 0x6b206574;
+    for (i = 0; i < 8; i++)
+	cs->state[4 + i] = GET_32BIT_LSB_FIRST(key + i * 4);
+    for (i = 12; i < 16; i++)
+	cs->state[i] = 0;
+}
+
+/*
+ * Set the 64-bit block counter and nonce,the nonce is the sequence
+ * number as a big-endian 64-bit value.
+ */
+static void chacha20_nonce(ChaChaState *cs, word32 counter, unsigned long seq)
+{
+    unsigned char nonce[4];
+
+    PUT_32BIT_MSB_FIRST(nonce, seq);
+    cs->state[12] = counter;
+    cs->state[13] = 0;
+    cs->state[14] = 0;
+    cs->state[15] = GET_32BIT_LSB_FIRST(nonce);
+}
+
+static void chacha20_block(ChaChaState *cs, unsigned char *out)
+{
+    word32 x[16];
+    int i;
+
+    for (i = 0; i < 16; i++)
+	x[i] = cs->state[i];
+    for (i = 0; i < 10; i++) {
+	QUARTERROUND(x[0], x[4], x[8], x[12]);
+	QUARTERROUND(x[1], x[5], x[9], x[13]);
+	QUARTERROUND(x[2], x[6], x[10], x[14]);
+	QUARTERROUND(x[3], x[7], x[11], x[15]);
+	QUARTERROUND(x[0], x[5], x[10], x[15]);
+	QUARTERROUND(x[1], x[6], x[11], x[12]);
+	QUARTERROUND(x[2], x[7], x[8], x[13]);
+	QUARTERROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (i = 0; i < 16; i++) {
+	x[i] += cs->state[i];
+	PUT_32BIT_LSB_FIRST(out + i * 4, x[i]);
+    }
+    if (++cs->state[12] == 0)
+	cs->state[13]++;
+    smemclr(x, sizeof(x));
+}
+
+static void chacha20_crypt(ChaChaState *cs, unsigned char *blk, int len)
+{
+    unsigned char ks[64];
+    int n, i;
+
+    while (len > 0) {
+	chacha20_block(cs, ks);
+	n = len < 64 ? len : 64;
+	for (i = 0; i < n; i++)
+	    blk[i] ^= ks[i];
+	blk += n;
+	len -= n;
+    }
+    smemclr(ks, sizeof(ks));
+}
+
+/* ----------------------------------------------------------------------
+ * Poly1305,in 26-bit limbs so products fit in 64 bits.
+ */
+
+typedef struct
+{
+	word32 r[5];
+	word32 h[5];
+	word32 pad[4];
+} Poly1305State;
+
+static void poly1305_init(Poly1305State *ps, const unsigned char *key)
+{
+    ps->r[0] = (GET_32BIT_LSB_FIRST(key + 0)) & 0x3ffffff;
+    ps->r[1] = (GET_32BIT_LSB_FIRST(key + 3) >> 2) & 0x3ffff03;
+    ps->r[2] = (GET_32BIT_LSB_FIRST(key + 6) >> 4) & 0x3ffc0ff;
+    ps->r[3] = (GET_32BIT_LSB_FIRST(key + 9) >> 6) & 0x3f03fff;
+    ps->r[4] = (GET_32BIT_LSB_FIRST(key + 12) >> 8) & 0x00fffff;
+
+    ps->h[0] = ps->h[1] = ps->h[2] = ps->h[3] = ps->h[4] = 0;
+
+    ps->pad[0] = GET_32BIT_LSB_FIRST(key + 16);
+    ps->pad[1] = GET_32BIT_LSB_FIRST(key + 20);
+    ps->pad[2] = GET_32BIT_LSB_FIRST(key + 24);
+    ps->pad[3] = GET_32BIT_LSB_FIRST(key + 28);
+}
+
+/*
+ * Hash one 16 bytes block,hibit is 1 << 24 for a full block and 0 for
+ * the last partial block which carries its own padding bit.
+ */
+static void poly1305_block(Poly1305State *ps, const unsigned char *m, word32 hibit)
+{
+    word32 r0 = ps->r[0], r1 = ps->r[1], r2 = ps->r[2], r3 = ps->r[3], r4 = ps->r[4];
+    word32 s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    word32 h0 = ps->h[0], h1 = ps->h[1], h2 = ps->h[2], h3 = ps->h[3], h4 = ps->h[4];
+    word64 d0, d1, d2, d3, d4;
+    word32 c;
+
+    h0 += (GET_32BIT_LSB_FIRST(m + 0)) & 0x3ffffff;
+    h1 += (GET_32BIT_LSB_FIRST(m + 3) >> 2) & 0x3ffffff;
+    h2 += (GET_32BIT_LSB_FIRST(m + 6) >> 4) & 0x3ffffff;
+    h3 += (GET_32BIT_LSB_FIRST(m + 9) >> 6) & 0x3ffffff;
+    h4 += (GET_32BIT_LSB_FIRST(m + 12) >> 8) | hibit;
+
+    d0 = ((word64)h0 * r0) + ((word64)h1 * s4) + ((word64)h2 * s3) + ((word64)h3 * s2) + ((word64)h4 * s1);
+    d1 = ((word64)h0 * r1) + ((word64)h1 * r0) + ((word64)h2 * s4) + ((word64)h3 * s3) + ((word64)h4 * s2);
+    d2 = ((word64)h0 * r2) + ((word64)h1 * r1) + ((word64)h2 * r0) + ((word64)h3 * s4) + ((word64)h4 * s3);
+    d3 = ((word64)h0 * r3) + ((word64)h1 * r2) + ((word64)h2 * r1) + ((word64)h3 * r0) + ((word64)h4 * s4);
+    d4 = ((word64)h0 * r4) + ((word64)h1 * r3) + ((word64)h2 * r2) + ((word64)h3 * r1) + ((word64)h4 * r0);
+
+    c = (word32)(d0 >> 26); h0 = (word32)d0 & 0x3ffffff;
+    d1 += c; c = (word32)(d1 >> 26); h1 = (word32)d1 & 0x3ffffff;
+    d2 += c; c = (word32)(d2 >> 26); h2 = (word32)d2 & 0x3ffffff;
+    d3 += c; c = (word32)(d3 >> 26); h3 = (word32)d3 & 0x3ffffff;
+    d4 += c; c = (word32)(d4 >> 26); h4 = (word32)d4 & 0x3ffffff;
+    h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+    h1 += c;
+
+    ps->h[0] = h0; ps->h[1] = h1; ps->h[2] = h2; ps->h[3] = h3; ps->h[4] = h4;
+}
+
+static void poly1305_bytes(Poly1305State *ps, const unsigned char *m, int len)
+{
+    unsigned char last[16];
+
+    while (len >= 16) {
+	poly1305_block(ps, m, 1 << 24);
+	m += 16;
+	len -= 16;
+    }
+    if (len > 0) {
+	memset(last, 0, sizeof(last));
+	memcpy(last, m, len);
+	last[len] = 1;
+	poly1305_block(ps, last, 0);
+    }
+}
+
+static void poly1305_finish(Poly1305State *ps, unsigned char *mac)
+{
+    word32 h0 = ps->h[0], h1 = ps->h[1], h2 = ps->h[2], h3 = ps->h[3], h4 = ps->h[4];
+    word32 g0, g1, g2, g3, g4, c, mask;
+    word64 f;
+
+    /* Fully carry h. */
+    c = h1 >> 26; h1 &= 0x3ffffff;
+    h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+    h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+    h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+    h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+    h1 += c;
+
+    /* h - p,selected without branch if h >= p. */
+    g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+    g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+    g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+    g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+    g4 = h4 + c - (1 << 26);
+
+    mask = (g4 >> 31) - 1;
+    g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+    mask = ~mask;
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+    h3 = (h3 & mask) | g3;
+    h4 = (h4 & mask) | g4;
+
+    /* h = (h + pad) % 2^128. */
+    h0 = ((h0) | (h1 << 26)) & 0xffffffff;
+    h1 = ((h1 >> 6) | (h2 << 20)) & 0xffffffff;
+    h2 = ((h2 >> 12) | (h3 << 14)) & 0xffffffff;
+    h3 = ((h3 >> 18) | (h4 << 8)) & 0xffffffff;
+
+    f = (word64)h0 + ps->pad[0]; h0 = (word32)f;
+    f = (word64)h1 + ps->pad[1] + (f >> 32); h1 = (word32)f;
+    f = (word64)h2 + ps->pad[2] + (f >> 32); h2 = (word32)f;
+    f = (word64)h3 + ps->pad[3] + (f >> 32); h3 = (word32)f;
+
+    PUT_32BIT_LSB_FIRST(mac + 0, h0);
+    PUT_32BIT_LSB_FIRST(mac + 4, h1);
+    PUT_32BIT_LSB_FIRST(mac + 8, h2);
+    PUT_32BIT_LSB_FIRST(mac + 12, h3);
+
+    smemclr(ps, sizeof(Poly1305State));
+}
+
+/* ----------------------------------------------------------------------
+ * SSH-2 cipher interface.
+ */
+
+/*
+ * Poly1305 tag of the packet,blk is the encrypted length and payload.
+ */
+static void ccp_tag(CCPContext *ctx, unsigned char *blk, int len,
+		    unsigned long seq, unsigned char *tag)
+{
+    Poly1305State ps;
+    unsigned char key[64];
+
+    chacha20_nonce(&ctx->main, 0, seq);
+    chacha20_block(&ctx->main, key);
+    poly1305_init(&ps, key);
+    poly1305_bytes(&ps, blk, len);
+    poly1305_finish(&ps, tag);
+    smemclr(key, sizeof(key));
+}
+
+static void *ccp_make_context(void)
+{
+    CCPContext *ctx = snewn(1, CCPContext);
+
+    memset(ctx, 0, sizeof(CCPContext));
+    return ctx;
+}
+
+static void ccp_free_context(void *handle)
+{
+    smemclr(handle, sizeof(CCPContext));
+    sfree(handle);
+}
+
+static void ccp_key(void *handle, unsigned char *key)
+{
+    CCPContext *ctx = (CCPContext *)handle;
+
+    chacha20_key(&ctx->main, key);
+    chacha20_key(&ctx->header, key + 32);
+}
+
+static void ccp_iv(void *handle, unsigned char *iv)
+{
+    /* The sequence number is the nonce,no IV is used. */
+}
+
+static int ccp_length(void *handle, unsigned char const *blk, unsigned long seq)
+{
+    CCPContext *ctx = (CCPContext *)handle;
+    unsigned char len[4];
+
+    memcpy(len, blk, 4);
+    chacha20_nonce(&ctx->header, 0, seq);
+    chacha20_crypt(&ctx->header, len, 4);
+    return toint(GET_32BIT(len));
+}
+
+static void ccp_encrypt(void *handle, unsigned char *blk, int len, unsigned long seq)
+{
+    CCPContext *ctx = (CCPContext *)handle;
+
+    chacha20_nonce(&ctx->header, 0, seq);
+    chacha20_crypt(&ctx->header, blk, 4);
+    chacha20_nonce(&ctx->main, 1, seq);
+    chacha20_crypt(&ctx->main, blk + 4, len - 4);
+    ccp_tag(ctx, blk, len, seq, blk + len);
+}
+
+/*
+ * Verify the tag,then decrypt the payload and the length in place.
+ */
+static int ccp_decrypt(void *handle, unsigned char *blk, int len, unsigned long seq)
+{
+    CCPContext *ctx = (CCPContext *)handle;
+    unsigned char tag[CCP_TAGLEN];
+    int ok;
+
+    ccp_tag(ctx, blk, len, seq, tag);
+    ok = smemeq(tag, blk + len, CCP_TAGLEN);
+    if (ok) {
+	chacha20_nonce(&ctx->header, 0, seq);
+	chacha20_crypt(&ctx->header, blk, 4);
+	chacha20_nonce(&ctx->main, 1, seq);
+	chacha20_crypt(&ctx->main, blk + 4, len - 4);
+    }
+    smemclr(tag, sizeof(tag));
+    return ok;
+}
+
+static ssh2_cipher ssh2_chacha20_poly1305 = {
+    ccp_make_context, ccp_free_context, ccp_iv, ccp_key,
+    NULL, NULL,
+    "chacha20-poly1305@openssh.com",
+    8, 512, SSH_CIPHER_IS_AEAD, "ChaCha20-Poly1305",
+    ccp_length, ccp_encrypt, ccp_decrypt, CCP_TAGLEN
+};
+
+static ssh2_cipher *const ccp_list[] = {
+    &ssh2_chacha20_poly1305
+};
+
+ssh2_ciphers ssh2_ccp = {
+    sizeof(ccp_list) / sizeof(*ccp_list),
+    ccp_list
+};
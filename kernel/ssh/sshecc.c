@@ -0,0 +1,408 @@
+#include "ssh_def.h"
+
+/*
+ * Curve25519 key exchange (RFC 7748,RFC 8731).
+ *
+ * Field elements mod p = 2^255 - 19 are held in ten signed 32-bit
+ * limbs of alternately 26 and 25 bits,so that a product of two
+ * limbs fits in 64 bits and the reduction by 2^255 is a multiply
+ * by 19. The scalar multiplication is the Montgomery ladder on the
+ * u coordinate only,with no branch or memory access depending on
+ * the secret scalar.
+ */
+
+extern ssh_hash ssh_sha256;
+
+typedef int fe[10];
+typedef __int64 fe_wide;
+
+static const int fe_bits[10] = { 26, 25, 26, 25, 26, 25, 26, 25, 26, 25 };
+
+/*
+ * Propagate carries so every limb is back within its width. The
+ * carry out of the top limb wraps round to limb 0 times 19.
+ */
+static void fe_carry_wide(fe h, fe_wide *t)
+{
+    fe_wide c;
+    int i;
+
+    for (i = 0; i < 10; i++) {
+	c = (t[i] + ((fe_wide)1 << (fe_bits[i] - 1))) >> fe_bits[i];
+	t[i] -= c * ((fe_wide)1 << fe_bits[i]);
+	if (i < 9)
+	    t[i + 1] += c;
+	else
+	    t[0] += c * 19;
+    }
+    c = (t[0] + (1 << 25)) >> 26;
+    t[0] -= c * ((fe_wide)1 << 26);
+    t[1] += c;
+
+    for (i = 0; i < 10; i++)
+	h[i] = (int)t[i];
+}
+
+static void fe_copy(fe h, const fe f)
+{
+    int i;
+    for (i = 0; i < 10; i++)
+	h[i] = f[i];
+}
+
+static void fe_set(fe h, int v)
+{
+    int i;
+    h[0] = v;
+    for (i = 1; i < 10; i++)
+	h[i] = 0;
+}
+
+static void fe_add(fe h, const fe f, const fe g)
+{
+    fe_wide t[10];
+    int i;
+    for (i = 0; i < 10; i++)
+	t[i] = (fe_wide)f[i] + g[i];
+    fe_carry_wide(h, t);
+}
+
+static void fe_sub(fe h, const fe f, const fe g)
+{
+    fe_wide t[10];
+    int i;
+    for (i = 0; i < 10; i++)
+	t[i] = (fe_wide)f[i] - g[i];
+    fe_carry_wide(h, t);
+}
+
+/*
+ * h = f * g. Limb i has weight 2^ceil(25.5*i),so the product of two
+ * odd limbs lands half a bit short of its column and is doubled.
+ */
+static void fe_mul(fe h, const fe f, const fe g)
+{
+    fe_wide t[19];
+    int i, j;
+
+    for (i = 0; i < 19; i++)
+	t[i] = 0;
+    for (i = 0; i < 10; i++) {
+	for (j = 0; j < 10; j++) {
+	    fe_wide p = (fe_wide)f[i] * g[j];
+	    if (i & j & 1)
+		p *= 2;
+	    t[i + j] += p;
+	}
+    }
+    for (i = 0; i < 9; i++)
+	t[i] += t[i + 10] * 19;
+    fe_carry_wide(h, t);
+}
+
+static void fe_sq(fe h, const fe f)
+{
+    fe_mul(h, f, f);
+}
+
+static void fe_mul121665(fe h, const fe f)
+{
+    fe_wide t[10];
+    int i;
+    for (i = 0; i < 10; i++)
+	t[i] = (fe_wide)f[i] * 121665;
+    fe_carry_wide(h, t);
+}
+
+/*
+ * Swap f and g if b is 1,without branching on b.
+ */
+static void fe_cswap(fe f, fe g, unsigned b)
+{
+    int mask = -(int)b, x, i;
+    for (i = 0; i < 10; i++) {
+	x = mask & (f[i] ^ g[i]);
+	f[i] ^= x;
+	g[i] ^= x;
+    }
+}
+
+/*
+ * h = z^(p-2) = 1/z,by the usual chain of 254 squarings and 11
+ * multiplications.
+ */
+static void fe_invert(fe out, const fe z)
+{
+    fe z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+    int i;
+
+    fe_sq(z2, z);
+    fe_sq(t, z2);
+    fe_sq(t, t);
+    fe_mul(z9, t, z);
+    fe_mul(z11, z9, z2);
+    fe_sq(t, z11);
+    fe_mul(z2_5_0, t, z9);
+
+    fe_sq(t, z2_5_0);
+    for (i = 1; i < 5; i++)
+	fe_sq(t, t);
+    fe_mul(z2_10_0, t, z2_5_0);
+
+    fe_sq(t, z2_10_0);
+    for (i = 1; i < 10; i++)
+	fe_sq(t, t);
+    fe_mul(z2_20_0, t, z2_10_0);
+
+    fe_sq(t, z2_20_0);
+    for (i = 1; i < 20; i++)
+	fe_sq(t, t);
+    fe_mul(t, t, z2_20_0);
+
+    for (i = 0; i < 10; i++)
+	fe_sq(t, t);
+    fe_mul(z2_50_0, t, z2_10_0);
+
+    fe_sq(t, z2_50_0);
+    for (i = 1; i < 50; i++)
+	fe_sq(t, t);
+    fe_mul(z2_100_0, t, z2_50_0);
+
+    fe_sq(t, z2_100_0);
+    for (i = 1; i < 100; i++)
+	fe_sq(t, t);
+    fe_mul(t, t, z2_100_0);
+
+    for (i = 0; i < 50; i++)
+	fe_sq(t, t);
+    fe_mul(t, t, z2_50_0);
+
+    for (i = 0; i < 5; i++)
+	fe_sq(t, t);
+    fe_mul(out, t, z11);
+}
+
+/*
+ * Load 32 little-endian bytes,ignoring the top bit as RFC 7748 asks.
+ */
+static void fe_frombytes(fe h, const unsigned char *s)
+{
+    fe_wide t[10];
+    unsigned __int64 acc = 0;
+    int i, j = 0, nacc = 0;
+
+    for (i = 0; i < 10; i++) {
+	while (nacc < fe_bits[i] && j < 32) {
+	    acc |= (unsigned __int64)(j == 31 ? s[j] & 0x7F : s[j]) << nacc;
+	    nacc += 8;
+	    j++;
+	}
+	t[i] = (fe_wide)(acc & ((1UL << fe_bits[i]) - 1));
+	acc >>= fe_bits[i];
+	nacc -= fe_bits[i];
+    }
+    fe_carry_wide(h, t);
+}
+
+/*
+ * Store the fully reduced value of h as 32 little-endian bytes.
+ */
+static void fe_tobytes(unsigned char *s, const fe h)
+{
+    fe_wide t[10], q;
+    unsigned __int64 acc = 0;
+    int i, j = 0, nacc = 0;
+
+    for (i = 0; i < 10; i++)
+	t[i] = h[i];
+
+    //q is 1 if h >= p,0 otherwise,found by propagating the carry of
+    //h + 19 through the limbs.
+    q = (19 * t[9] + ((fe_wide)1 << 24)) >> 25;
+    for (i = 0; i < 10; i++)
+	q = (t[i] + q) >> fe_bits[i];
+
+    //h - q*p,the carry out of the top is the 2^255 being dropped.
+    t[0] += 19 * q;
+    for (i = 0; i < 9; i++) {
+	q = t[i] >> fe_bits[i];
+	t[i + 1] += q;
+	t[i] -= q * ((fe_wide)1 << fe_bits[i]);
+    }
+    t[9] &= (1 << 25) - 1;
+
+    for (i = 0; i < 10; i++) {
+	acc |= (unsigned __int64)t[i] << nacc;
+	nacc += fe_bits[i];
+	while (nacc >= 8) {
+	    s[j++] = (unsigned char)acc;
+	    acc >>= 8;
+	    nacc -= 8;
+	}
+    }
+    s[j] = (unsigned char)acc;
+}
+
+/*
+ * out = scalar * u,all 32-byte little-endian strings. The scalar is
+ * clamped as RFC 7748 decodeScalar25519 does.
+ */
+static void x25519(unsigned char *out, const unsigned char *scalar,
+		   const unsigned char *u)
+{
+    fe x1, x2, z2, x3, z3, a, aa, b, bb, e, c, d, da, cb;
+    unsigned char k[32];
+    unsigned swap = 0, bit;
+    int i;
+
+    memcpy(k, scalar, 32);
+    k[0] &= 248;
+    k[31] &= 127;
+    k[31] |= 64;
+
+    fe_frombytes(x1, u);
+    fe_set(x2, 1);
+    fe_set(z2, 0);
+    fe_copy(x3, x1);
+    fe_set(z3, 1);
+
+    for (i = 254; i >= 0; i--) {
+	bit = (k[i >> 3] >> (i & 7)) & 1;
+	swap ^= bit;
+	fe_cswap(x2, x3, swap);
+	fe_cswap(z2, z3, swap);
+	swap = bit;
+
+	fe_add(a, x2, z2);
+	fe_sq(aa, a);
+	fe_sub(b, x2, z2);
+	fe_sq(bb, b);
+	fe_sub(e, aa, bb);
+	fe_add(c, x3, z3);
+	fe_sub(d, x3, z3);
+	fe_mul(da, d, a);
+	fe_mul(cb, c, b);
+
+	fe_add(x3, da, cb);
+	fe_sq(x3, x3);
+	fe_sub(z3, da, cb);
+	fe_sq(z3, z3);
+	fe_mul(z3, z3, x1);
+	fe_mul(x2, aa, bb);
+	fe_mul121665(z2, e);
+	fe_add(z2, z2, aa);
+	fe_mul(z2, z2, e);
+    }
+    fe_cswap(x2, x3, swap);
+    fe_cswap(z2, z3, swap);
+
+    fe_invert(z2, z2);
+    fe_mul(x2, x2, z2);
+    fe_tobytes(out, x2);
+
+    smemclr(k, sizeof(k));
+    smemclr(x2, sizeof(x2));
+    smemclr(z2, sizeof(z2));
+    smemclr(x3, sizeof(x3));
+    smemclr(z3, sizeof(z3));
+}
+
+/* ----------------------------------------------------------------------
+ * Key exchange.
+ */
+
+typedef struct
+{
+    unsigned char priv[32];
+    unsigned char pub[32];
+}ecdh_key;
+
+static const unsigned char curve25519_base[32] = { 9 };
+
+void *ssh_ecdhkex_newkey(const ssh_kex *kex)
+{
+    ecdh_key *key;
+    int i;
+
+    key = snewn(1, ecdh_key);
+    if (!key)
+	return NULL;
+    for (i = 0; i < 32; i++)
+	key->priv[i] = (unsigned char)random_byte();
+
+    x25519(key->pub, key->priv, curve25519_base);
+    return key;
+}
+
+/*
+ * Our public value Q_C,32 bytes,valid until the key is freed.
+ */
+const unsigned char *ssh_ecdhkex_getpublic(void *handle, int *len)
+{
+    ecdh_key *key = (ecdh_key *)handle;
+    *len = sizeof(key->pub);
+    return key->pub;
+}
+
+/*
+ * Compute the shared secret K from the server's Q_S. The X25519
+ * output is taken as a big-endian number (RFC 8731 section 3.1).
+ * Returns NULL if Q_S is malformed or a low order point,which
+ * gives an all zero result.
+ */
+Bignum ssh_ecdhkex_getkey(void *handle, const unsigned char *remote, int len)
+{
+    ecdh_key *key = (ecdh_key *)handle;
+    unsigned char out[32];
+    unsigned char acc = 0;
+    Bignum ret;
+    int i;
+
+    if (len != 32)
+	return NULL;
+
+    x25519(out, key->priv, remote);
+    for (i = 0; i < 32; i++)
+	acc |= out[i];
+    if (!acc)
+	return NULL;
+
+    ret = bignum_from_bytes(out, 32);
+    smemclr(out, sizeof(out));
+    return ret;
+}
+
+void ssh_ecdhkex_freekey(void *handle)
+{
+    smemclr(handle, sizeof(ecdh_key));
+    sfree(handle);
+}
+
+/*
+ * Raw X25519,exported for the key exchange benchmark.
+ */
+void ssh_x25519(unsigned char *out, const unsigned char *scalar,
+		const unsigned char *u)
+{
+    x25519(out, scalar, u);
+}
+
+static ssh_kex ssh_ec_kex_curve25519 = {
+    "curve25519-sha256", NULL,
+    KEXTYPE_ECDH, NULL, NULL, 0, 0, &ssh_sha256
+};
+
+static ssh_kex ssh_ec_kex_curve25519_libssh = {
+    "curve25519-sha256@libssh.org", NULL,
+    KEXTYPE_ECDH, NULL, NULL, 0, 0, &ssh_sha256
+};
+
+static const ssh_kex *const ec_kex_list[] = {
+    &ssh_ec_kex_curve25519,
+    &ssh_ec_kex_curve25519_libssh
+};
+
+ssh_kexes ssh_ec_kex = {
+    sizeof(ec_kex_list) / sizeof(*ec_kex_list),
+    ec_kex_list
+};
@@ -109,9 +109,8 @@ unsigned long EHCIIntHandler(LPVOID pParam)
 	struct ehci_ctrl* pUsbCtrl = NULL;
 	unsigned long ulResult = 0;
 	unsigned long status = 0, int_bit = 0;
-	unsigned long pciStatus = 0;
 	unsigned long ulOwn = 0; /* Raised by this controller if = 1. */
-	static int show_warn = 1;
+	DWORD dwEvents = 0;  /* Events handed over to USB core thread. */
 
 	if (NULL == pCommCtrl)
 	{
@@ -145,7 +144,8 @@ unsigned long EHCIIntHandler(LPVOID pParam)
 		if (status & INTR_PCE)
 		{
 			ulResult++;
-			//Handler of PCE.
+			//Handler of PCE,processed in USB core thread.
+			dwEvents |= USB_CTRL_EVENT_PORT_CHANGE;
 			/*
 			 * Clear the status bit.
 			 */
@@ -154,14 +154,8 @@ unsigned long EHCIIntHandler(LPVOID pParam)
 		}
 		if (status & INTR_SEE)
 		{
-			pciStatus = pCommCtrl->pPhysicalDev->ReadDeviceConfig(pCommCtrl->pPhysicalDev,
-				PCI_CONFIG_OFFSET_COMMAND, 4);
-			_hx_printf("USB Controller [%d] system error,PCI_status/Ctrl_status = %X/%X.\r\n",
-				pCommCtrl->pPhysicalDev->dwNumber, 
-				pciStatus,
-				ehci_readl(&pUsbCtrl->hcor->or_usbsts));
-			//Should reset the USB controller according USB EHCI specification.But now we let 
-			//it empty...
+			//Report it in USB core thread instead of interrupt.
+			dwEvents |= USB_CTRL_EVENT_SYSTEM_ERROR;
 			ulResult++;
 			/*
 			* Clear the status bit.
@@ -183,14 +177,7 @@ unsigned long EHCIIntHandler(LPVOID pParam)
 		}
 		if (status & INTR_UEE)
 		{
-			if (show_warn)
-			{
-				_hx_printf("USB Controller [Vendor = %X,Device = %X] encounters transfer error.\r\n",
-					pCommCtrl->pPhysicalDev->DevId.Bus_ID.PCI_Identifier.wVendor,
-					pCommCtrl->pPhysicalDev->DevId.Bus_ID.PCI_Identifier.wDevice);
-				/* No more warning will be showed out next time. */
-				show_warn = 0;
-			}
+			dwEvents |= USB_CTRL_EVENT_XFER_ERROR;
 			ulResult++;
 			pUsbCtrl->nXferErrNum++;
 			//Handler of UEE.
@@ -229,6 +216,12 @@ unsigned long EHCIIntHandler(LPVOID pParam)
 		}
 	}
 
+	/* Hand over the events to USB core thread. */
+	if (dwEvents)
+	{
+		USBManager.PostCtrlEvent(pCommCtrl, dwEvents);
+	}
+
 __TERMINAL:
 	return ulOwn;
 }
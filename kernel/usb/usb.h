@@ -345,8 +345,19 @@ typedef struct tag__COMMON_USB_CONTROLLER{
 	__PHYSICAL_DEVICE* pPhysicalDev;      //Physical device the controller corresponding.
 	__COMMON_OBJECT* IntObject;           //Interrupt object of this controller.
 	LPVOID pUsbCtrl;                      //Actual controller specified informations.
+	volatile DWORD dwPendingEvents;       //Events raised in interrupt,USB_CTRL_EVENT_XXX.
+	DWORD dwPortChangeNum;                //How many port change events processed.
 }__COMMON_USB_CONTROLLER;
 
+//Events raised by controller's interrupt handler,they are handed over to
+//USB core thread through USB Manager's event ring and processed there.
+#define USB_CTRL_EVENT_PORT_CHANGE   0x01
+#define USB_CTRL_EVENT_SYSTEM_ERROR  0x02
+#define USB_CTRL_EVENT_XFER_ERROR    0x04
+
+//Message sent to USB core thread when the event ring becomes non-empty.
+#define USB_MSG_CTRL_EVENT           0x0100
+
 //USB controller types.
 #define USB_CONTROLLER_OHCI                0x0001
 #define USB_CONTROLLER_UHCI                0x0002
@@ -393,11 +404,17 @@ typedef struct tag__USB_MANAGER{
 
 	//Handle of the USB background kernel thread.
 	__KERNEL_THREAD_OBJECT* UsbCoreThread;
+	//Controllers with pending events,each one is in the ring at most once.
+	__RING_BUFFER* pEventRing;
+	//Set when USB core thread can not be notified,retried by next post.
+	volatile DWORD dwWakeupLost;
 
 	//Global level resource or object management.
 	__COMMON_USB_CONTROLLER* (*CreateUsbCtrl)(__USB_CONTROLLER_OPERATIONS* ops,DWORD dwCtrlType,
 		__PHYSICAL_DEVICE* pPhyDev,void* priv);
 	struct usb_device* (*CreateUsbDevice)(__COMMON_USB_CONTROLLER* pCtrl);
+	//Raise controller events in interrupt,they are processed in USB core thread.
+	BOOL (*PostCtrlEvent)(__COMMON_USB_CONTROLLER* pCtrl, DWORD dwEvents);
 	//Add a physical USB device into system.
 	BOOL (*AddUsbDevice)(struct usb_device* pDevice);
 	//Get a physical device specified by id.
@@ -15,6 +15,7 @@
 //***********************************************************************/
 
 #include <StdAfx.h>
+#include <pci_drv.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -55,6 +56,137 @@ static BOOL CommonInterruptHandler(LPVOID lpESP, LPVOID lpParam)
 	return FALSE;
 }
 
+//Wakeup routine of the event ring,notify USB core thread to process
+//the pending controller events.
+//If the message can not be sent,the wakeup is marked as lost and retried
+//by the next event post,since controllers already in ring will not add
+//new element into ring and the ring itself will never wake up consumer.
+static BOOL _EventRingWakeup(LPVOID lpWakeupParam)
+{
+	__KERNEL_THREAD_MESSAGE msg;
+
+	if (NULL == USBManager.UsbCoreThread)
+	{
+		USBManager.dwWakeupLost = 1;
+		return FALSE;
+	}
+	msg.wCommand = USB_MSG_CTRL_EVENT;
+	msg.wParam = 0;
+	msg.dwParam = 0;
+	if (!SendMessage((HANDLE)USBManager.UsbCoreThread, &msg))
+	{
+		USBManager.dwWakeupLost = 1;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+//Raise events of a USB controller,mainly called in interrupt handler.
+//The controller is added into event ring only when it has no pending
+//event before,so it's in the ring at most once and the ring never
+//overflows.
+static BOOL _PostCtrlEvent(__COMMON_USB_CONTROLLER* pCtrl, DWORD dwEvents)
+{
+	__RING_BUFFER* pRing = USBManager.pEventRing;
+	DWORD dwOld = 0;
+
+	if ((NULL == pCtrl) || (0 == dwEvents) || (NULL == pRing))
+	{
+		return FALSE;
+	}
+	do {
+		dwOld = pCtrl->dwPendingEvents;
+	} while (dwOld != __AtomicCompareExchange(&pCtrl->dwPendingEvents, dwOld, dwOld | dwEvents));
+	if (dwOld)  //Already in ring.
+	{
+		//Retry the lost wakeup,otherwise the ring may stay pending forever.
+		if (1 == __AtomicCompareExchange(&USBManager.dwWakeupLost, 1, 0))
+		{
+			_EventRingWakeup(NULL);
+		}
+		return TRUE;
+	}
+	if (!pRing->AddElement((__COMMON_OBJECT*)pRing, (DWORD)pCtrl))
+	{
+		pCtrl->dwPendingEvents = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+//Process events of one controller in USB core thread's context,the
+//messages that used to be printed in interrupt handler are showed here.
+static VOID _ProcessCtrlEvents(__COMMON_USB_CONTROLLER* pCtrl, DWORD dwEvents)
+{
+	static BOOL bShowXferWarn = TRUE;
+	unsigned long ctrlStatus = 0;
+
+	if (pCtrl->ctrlOps.get_ctrl_status)
+	{
+		ctrlStatus = pCtrl->ctrlOps.get_ctrl_status(pCtrl, USB_CTRL_FLAG_EHCI_STATUS);
+	}
+	if (dwEvents & USB_CTRL_EVENT_SYSTEM_ERROR)
+	{
+		//Should reset the USB controller according USB EHCI specification.But now we let 
+		//it empty...
+		_hx_printf("USB Controller [%d] system error,PCI_status/Ctrl_status = %X/%X.\r\n",
+			pCtrl->pPhysicalDev->dwNumber,
+			pCtrl->pPhysicalDev->ReadDeviceConfig(pCtrl->pPhysicalDev,
+				PCI_CONFIG_OFFSET_COMMAND, 4),
+			ctrlStatus);
+	}
+	if (dwEvents & USB_CTRL_EVENT_XFER_ERROR)
+	{
+		if (bShowXferWarn)
+		{
+			_hx_printf("USB Controller [Vendor = %X,Device = %X] encounters transfer error.\r\n",
+				pCtrl->pPhysicalDev->DevId.Bus_ID.PCI_Identifier.wVendor,
+				pCtrl->pPhysicalDev->DevId.Bus_ID.PCI_Identifier.wDevice);
+			/* No more warning will be showed out next time. */
+			bShowXferWarn = FALSE;
+		}
+	}
+	if (dwEvents & USB_CTRL_EVENT_PORT_CHANGE)
+	{
+		pCtrl->dwPortChangeNum++;
+	}
+}
+
+//Handler of USB_MSG_CTRL_EVENT message,drain the event ring.
+static VOID _CtrlEventHandler()
+{
+	__COMMON_USB_CONTROLLER* CtrlArray[CONFIG_USB_MAX_CONTROLLER_NUM];
+	__RING_BUFFER* pRing = USBManager.pEventRing;
+	DWORD dwNum = 0, dwEvents = 0, i = 0;
+
+	while (TRUE)
+	{
+		dwNum = pRing->GetElements((__COMMON_OBJECT*)pRing, (DWORD*)&CtrlArray[0],
+			CONFIG_USB_MAX_CONTROLLER_NUM, 0);
+		if (0 == dwNum)
+		{
+			//Arm the wakeup and check again,events may come before arming.
+			if (pRing->ArmWakeup((__COMMON_OBJECT*)pRing))
+			{
+				break;
+			}
+			continue;
+		}
+		for (i = 0; i < dwNum; i++)
+		{
+			//Take all events of the controller,it can be added into ring
+			//again by interrupt handler after this.
+			do {
+				dwEvents = CtrlArray[i]->dwPendingEvents;
+			} while (dwEvents != __AtomicCompareExchange(&CtrlArray[i]->dwPendingEvents, dwEvents, 0));
+			if (dwEvents)
+			{
+				_ProcessCtrlEvents(CtrlArray[i], dwEvents);
+			}
+		}
+	}
+}
+
 //A dedicated kernel thread is used to service all USB controllers
 //or devices in system.It's the core of USB sub-system.
 static DWORD USBCoreThread(LPVOID pData)
@@ -83,12 +215,24 @@ static DWORD USBCoreThread(LPVOID pData)
 		dwIndex++;  //Continue to load.
 	}
 
+	//Drain events raised before this thread could be waken up.
+	USBManager.dwWakeupLost = 0;
+	_CtrlEventHandler();
+
 	//Main message loop.
 	while (TRUE)
 	{
 		if (KernelThreadManager.GetMessage(NULL, &msg))
 		{
 			//Process the message.
+			switch (msg.wCommand)
+			{
+			case USB_MSG_CTRL_EVENT:
+				_CtrlEventHandler();
+				break;
+			default:
+				break;
+			}
 		}
 	}
 	return 1;
@@ -111,6 +255,18 @@ static BOOL UsbMgrInit(__USB_MANAGER* pUsbMgr)
 	}
 	pUsbMgr->dev_index = 0;
 
+	//Create the event ring,all controllers' interrupt handlers post
+	//events into it.
+	pUsbMgr->pEventRing = (__RING_BUFFER*)CreateRingBuffEx(CONFIG_USB_MAX_CONTROLLER_NUM,
+		RING_BUFFER_FLAG_MPSC);
+	if (NULL == pUsbMgr->pEventRing)
+	{
+		_hx_printf("USB: Can not create event ring.\r\n");
+		return FALSE;
+	}
+	pUsbMgr->pEventRing->SetWakeupRoutine((__COMMON_OBJECT*)pUsbMgr->pEventRing,
+		_EventRingWakeup, NULL);
+
 	//Create the background service kernel thread.
 	pUsbMgr->UsbCoreThread = KernelThreadManager.CreateKernelThread(
 		(__COMMON_OBJECT*)&KernelThreadManager,
@@ -165,6 +321,8 @@ static __COMMON_USB_CONTROLLER* CreateUsbCtrl(__USB_CONTROLLER_OPERATIONS* ops,D
 	pUsbCtrl->dwCtrlType = dwCtrlType;
 	pUsbCtrl->pPhysicalDev = pPhyDev;
 	pUsbCtrl->IntObject = NULL;
+	pUsbCtrl->dwPendingEvents = 0;
+	pUsbCtrl->dwPortChangeNum = 0;
 	pUsbCtrl->ctrlOps.submit_bulk_msg = ops->submit_bulk_msg;
 	pUsbCtrl->ctrlOps.submit_control_msg = ops->submit_control_msg;
 	pUsbCtrl->ctrlOps.submit_int_msg = ops->submit_int_msg;
@@ -701,10 +859,13 @@ __USB_MANAGER USBManager = {
 	0,        //nPhysicalDevNum.
 	NULL,     //pUsbDeviceRoot.
 	NULL,     //UsbCoreThread.
+	NULL,     //pEventRing.
+	0,        //dwWakeupLost.
 
 	//Operations.
 	CreateUsbCtrl,              //CreateUsbCtrl.
 	NULL,                       //CreateUsbDevice.
+	_PostCtrlEvent,             //PostCtrlEvent.
 	_AddUsbDevice,              //AddUsbDevice.
 	_GetUsbDevice,              //GetUsbDevice.
 	_GetConfigDescriptor,       //GetConfigDescriptor.
@@ -20,11 +20,13 @@ __ETHERNET_BUFFER* Do_DPI(__ETHERNET_BUFFER* pBuffer)
 	struct ip_hdr* ip_header = NULL;
 	
 	/*
-	 * Clone a new buffer from the old one,do modifications on the new one
+	 * Copy a new buffer from the old one,do modifications on the new one
 	 * and return it,the underlay code will through the new ethernet frame
 	 * out.
+	 * The frame data is copied into a private data block,since the old
+	 * one's data block may be shared by other cloned buffers.
 	 */
-	pNewBuffer = EthernetManager.CloneEthernetBuffer(pBuffer);
+	pNewBuffer = EthernetManager.CopyEthernetBuffer(pBuffer);
 	if (NULL == pNewBuffer)
 	{
 		return NULL;